@@ -0,0 +1,9 @@
+#ifndef MSTL_ALLOC_BENCH_H
+#define MSTL_ALLOC_BENCH_H
+
+namespace mstl {
+
+	void pool_allocator_bench();
+}
+
+#endif // !MSTL_ALLOC_BENCH_H
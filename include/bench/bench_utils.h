@@ -0,0 +1,74 @@
+#ifndef MSTL_BENCH_UTILS_H
+#define MSTL_BENCH_UTILS_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+
+namespace mstl::bench {
+
+	/// ---------------------------------------------------------------
+	/// Tiny timing helpers shared by the benchmarks
+	/// ---------------------------------------------------------------
+
+	using clock_type = std::chrono::steady_clock;
+
+	// runs fn once and returns elapsed milliseconds
+	template<typename Fn>
+	double time_ms(Fn&& fn)
+	{
+		const auto start = clock_type::now();
+		fn();
+		const auto stop = clock_type::now();
+		return std::chrono::duration<double, std::milli>(stop - start).count();
+	}
+
+	// million operations per second
+	inline double mops(std::size_t ops, double ms) noexcept
+	{
+		return ms > 0.0 ? static_cast<double>(ops) / (ms * 1000.0) : 0.0;
+	}
+
+	inline void print_row(const char* label, std::size_t n, std::size_t ops, double ms)
+	{
+		std::cout << std::left << std::setw(36) << label
+			<< " n = " << std::setw(10) << n
+			<< std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << ms << " ms"
+			<< std::setw(10) << mops(ops, ms) << " Mops/s\n";
+	}
+
+	// written by do_not_optimize, never read: a namespace-scope
+	// volatile is an observable store, no set-but-unused local
+	inline const void* volatile do_not_optimize_sink = nullptr;
+
+	// keeps the optimizer from dropping a computed value: the address
+	// escapes to a global and the fence makes the compiler assume a
+	// signal handler could read through it, so value must be stored
+	template<typename T>
+	inline void do_not_optimize(const T& value)
+	{
+		do_not_optimize_sink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	// allocation counters of a container (Container::trace), printed
+	// under the timing row; nothing unless built with MSTL_TRACE=1
+	template<typename Trace>
+	inline void print_trace()
+	{
+		if constexpr (Trace::enabled)
+		{
+			const auto s = Trace::stats();
+			std::cout << "    allocs " << s.allocations
+				<< "  frees " << s.deallocations
+				<< "  bytes " << s.bytes_allocated
+				<< "  growths " << s.growths
+				<< "  relocated " << s.bytes_relocated << " B\n";
+		}
+	}
+}
+
+#endif // !MSTL_BENCH_UTILS_H
@@ -0,0 +1,14 @@
+#ifndef MSTL_DEQUE_BENCH_H
+#define MSTL_DEQUE_BENCH_H
+
+#include <cstddef>
+
+namespace mstl {
+
+	// queue workloads on n ints: fill then drain, a steady FIFO with a
+	// short backlog, and the reversed direction (push_front/pop_back),
+	// mstl::deque vs mstl::list and std::deque
+	void deque_queue_bench(std::size_t n = 10'000'000);
+}
+
+#endif // !MSTL_DEQUE_BENCH_H
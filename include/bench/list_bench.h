@@ -0,0 +1,14 @@
+#ifndef MSTL_LIST_BENCH_H
+#define MSTL_LIST_BENCH_H
+
+#include <cstddef>
+
+namespace mstl {
+
+	// traversal of n ints (list nodes scattered by a sort) and 10'000
+	// inserts walking through the middle of n / 10 ints:
+	// unrolled_list vs list vs vector
+	void unrolled_list_bench(std::size_t n = 1'000'000);
+}
+
+#endif // !MSTL_LIST_BENCH_H
@@ -0,0 +1,43 @@
+#ifndef MSTL_MAP_BENCH_H
+#define MSTL_MAP_BENCH_H
+
+#include <cstddef>
+
+namespace mstl {
+
+	// insert / hit lookup / miss lookup / erase, from 1K keys up to
+	// max_keys (x10 steps); pass 100'000'000 for the big run
+	void unordered_map_bench(std::size_t max_keys = 10'000'000);
+
+	// same operations, ordered containers: btree_map vs mstl::map
+	void btree_map_bench(std::size_t max_keys = 10'000'000);
+
+	// read-mostly tables: bulk build, lookups and full iteration,
+	// flat_map vs mstl::map
+	void flat_map_bench(std::size_t max_keys = 1'000'000);
+
+	// ascending keys (timestamps) from 1K up to max_keys: insert(v)
+	// vs insert(end(), v), mstl::map, avl_tree and std::map
+	void tree_hint_bench(std::size_t max_keys = 10'000'000);
+
+	// map<uint32_t, uint32_t> node layouts: rb_node vs rb_compact_node
+	// (color in the parent word) on a node pool, and arena_map (32-bit
+	// index links, one array): node size, build and random lookups
+	void rb_node_layout_bench(std::size_t max_keys = 10'000'000);
+
+	// teardown of a filled tree: map on std::allocator, on a node pool
+	// (trivial values: slabs dropped, no walk; std::string values:
+	// destructors only) and a degenerate bst_tree (ascending keys)
+	void tree_clear_bench(std::size_t max_keys = 10'000'000);
+
+	// copy constructor of trees built in random order (snapshots):
+	// mstl::map, avl_tree, bst_tree and std::map
+	void tree_copy_bench(std::size_t max_keys = 10'000'000);
+
+	// snapshots under updates: persistent_map (O(1) snapshot, path
+	// copying) vs mstl::map (full copy); update throughput and bytes
+	// held by the map plus its live snapshots
+	void persistent_map_bench(std::size_t max_keys = 1'000'000);
+}
+
+#endif // !MSTL_MAP_BENCH_H
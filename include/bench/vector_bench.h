@@ -0,0 +1,18 @@
+#ifndef MSTL_VECTOR_BENCH_H
+#define MSTL_VECTOR_BENCH_H
+
+#include <cstddef>
+
+namespace mstl {
+
+	// push_back-driven growth from 1M elements up to max_elems (x10
+	// steps): trivially relocatable vs element-wise relocation, and
+	// the mremap path for big buffers. 1'000'000'000 for the big run
+	void vector_growth_bench(std::size_t max_elems = 100'000'000);
+
+	// rounds short-lived vectors of 4..64 ints: heap allocations per
+	// vector and time, small_vector<int, 16> vs vector/std::vector
+	void small_vector_bench(std::size_t rounds = 1'000'000);
+}
+
+#endif // !MSTL_VECTOR_BENCH_H
@@ -0,0 +1,1401 @@
+#ifndef MSTL_ARENA_TREE_H
+#define MSTL_ARENA_TREE_H
+
+#include "red_black_tree.h"
+#include "relocate.h"
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Arena node
+	/// ---------------------------------------------------------------
+	/// Links are 32-bit slot indices into the arena, not pointers:
+	/// 12 bytes of links instead of 24 (32 with the color byte).
+	///
+	/// Slot 0 is the header and doubles as the null link (it is never
+	/// a child): header.m_Left -> root, header.m_Right -> rightmost,
+	/// root.m_Parent == 0. Bit 31 of m_Parent holds the color.
+	///
+	/// The value lives in raw storage, constructed only while the
+	/// slot is in the tree: erased slots keep no value and are chained
+	/// in a free list through m_Left, marked by m_Parent == arena_free.
+
+	using arena_index = std::uint32_t;
+
+	inline constexpr arena_index arena_nil       = 0;             // header / null link
+	inline constexpr arena_index arena_black_bit = 0x80000000u;
+	inline constexpr arena_index arena_free      = 0xFFFFFFFFu;   // m_Parent of a free slot
+	inline constexpr arena_index arena_max_nodes = 0x7FFFFFFEu;
+
+	template<typename T>
+	struct arena_node {
+
+		using value_type = T;
+
+		arena_index m_Left;
+		arena_index m_Right;
+		arena_index m_Parent;     // parent index | color (RBBk -> bit 31)
+
+		alignas(T) unsigned char m_Storage[sizeof(T)];
+
+		T& value() noexcept { return *std::launder(reinterpret_cast<T*>(m_Storage)); }
+		const T& value() const noexcept { return *std::launder(reinterpret_cast<const T*>(m_Storage)); }
+
+		arena_index parent() const noexcept { return m_Parent & ~arena_black_bit; }
+		void set_parent(arena_index p) noexcept { m_Parent = p | (m_Parent & arena_black_bit); }
+
+		RBColor color() const noexcept { return (m_Parent & arena_black_bit) ? RBBk : RBRed; }
+
+		void set_color(RBColor c) noexcept {
+			m_Parent = c == RBBk ? (m_Parent | arena_black_bit) : (m_Parent & ~arena_black_bit);
+		}
+
+		bool is_free() const noexcept { return m_Parent == arena_free; }
+	};
+
+	/// In-order neighbours over the slot array (shared by the
+	/// iterator and the tree). Successor of the rightmost node and
+	/// predecessor of the header follow the header layout, as in
+	/// TreeSuccessor / TreePredecessor.
+
+	template<typename NodeT>
+	inline arena_index ArenaMin(const NodeT* slots, arena_index i) noexcept {
+		while (slots[i].m_Left) i = slots[i].m_Left;
+		return i;
+	}
+
+	template<typename NodeT>
+	inline arena_index ArenaMax(const NodeT* slots, arena_index i) noexcept {
+		while (slots[i].m_Right) i = slots[i].m_Right;
+		return i;
+	}
+
+	template<typename NodeT>
+	inline arena_index ArenaSuccessor(const NodeT* slots, arena_index i) noexcept {
+
+		if (slots[i].m_Right) return ArenaMin(slots, slots[i].m_Right);
+
+		arena_index p = slots[i].parent();
+
+		while (p != arena_nil && i == slots[p].m_Right)
+		{
+			i = p;
+			p = slots[p].parent();
+		}
+
+		return p;
+	}
+
+	template<typename NodeT>
+	inline arena_index ArenaPredecessor(const NodeT* slots, arena_index i) noexcept {
+
+		// --end(): the header caches the rightmost node
+		if (i == arena_nil) return slots[i].m_Right;
+
+		if (slots[i].m_Left) return ArenaMax(slots, slots[i].m_Left);
+
+		arena_index p = slots[i].parent();
+
+		while (p != arena_nil && i == slots[p].m_Left)
+		{
+			i = p;
+			p = slots[p].parent();
+		}
+
+		return p;
+	}
+
+	/// ---------------------------------------------------------------
+	/// Arena iterator
+	/// ---------------------------------------------------------------
+	/// (arena, index) pair: it reads the slot array through the
+	/// tree's own pointer to it, so an iterator survives the arena
+	/// growing. References and pointers to values do not (unless
+	/// reserve() made room beforehand). Moving or swapping the tree
+	/// invalidates its iterators.
+
+	template<typename node_t, bool IsConst>
+	class arena_iterator {
+
+		using node_type = node_t;
+		using arena_ref = std::conditional_t<IsConst, const node_type* const*, node_type* const*>;
+
+		arena_ref   mpp_Slots{};
+		arena_index m_Idx{};
+
+	public:
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type        = typename node_t::value_type;
+		using difference_type   = std::ptrdiff_t;
+		using reference         = std::conditional_t<IsConst, const value_type&, value_type&>;
+		using pointer           = std::conditional_t<IsConst, const value_type*, value_type*>;
+
+		arena_iterator() = default;
+
+		arena_iterator(arena_ref slots, arena_index i) noexcept : mpp_Slots{ slots }, m_Idx{ i } {}
+
+		template<bool C = IsConst, typename = std::enable_if_t<C>>
+		arena_iterator(const arena_iterator<node_t, false>& other) noexcept
+			: mpp_Slots{ other.mpp_Slots }, m_Idx{ other.m_Idx } {
+		}
+
+		reference operator*()  const { return (*mpp_Slots)[m_Idx].value(); }
+		pointer   operator->() const { return std::addressof((*mpp_Slots)[m_Idx].value()); }
+
+		friend bool operator==(const arena_iterator& a, const arena_iterator& b) { return a.m_Idx == b.m_Idx; }
+		friend bool operator!=(const arena_iterator& a, const arena_iterator& b) { return !(a == b); }
+
+		arena_iterator& operator++() noexcept {
+			m_Idx = ArenaSuccessor(*mpp_Slots, m_Idx);
+			return *this;
+		}
+
+		arena_iterator operator++(int) noexcept {
+			arena_iterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		arena_iterator& operator--() noexcept {
+			m_Idx = ArenaPredecessor(*mpp_Slots, m_Idx);
+			return *this;
+		}
+
+		arena_iterator operator--(int) noexcept {
+			arena_iterator tmp = *this;
+			--(*this);
+			return tmp;
+		}
+
+	private:
+
+		template<typename T, typename KeyOfValue, typename Compare, typename A>
+		friend class arena_rb_tree;
+
+		template<typename, bool>
+		friend class arena_iterator;
+	};
+
+	/// ---------------------------------------------------------------
+	/// Arena RB Tree
+	/// ---------------------------------------------------------------
+	/// The red-black tree of rb_tree (same invariants, same insert
+	/// and erase fixups) with every node in one growable array of
+	/// slots linked by 32-bit indices:
+	///   - half the link overhead: map<uint32_t, uint32_t> takes 20
+	///     bytes per node instead of 40;
+	///   - one allocation for the whole tree, nodes built from sorted
+	///     input sit in key order in memory;
+	///   - the tree holds no pointer into itself: it relocates and,
+	///     for trivially copyable values, copies with one memcpy; the
+	///     slots of such a tree are plain bytes, they can be written
+	///     out and read back as they are.
+	///
+	/// Erased slots are recycled by later inserts, the arena never
+	/// shrinks but on clear() + shrink_to_fit() or a copy.
+	///
+	/// [!] at most arena_max_nodes (2^31 - 2) values.
+	/// ---------------------------------------------------------------
+
+	template<
+		typename T,
+		typename KeyOfValue = identity_key<T>,
+		typename compare = std::less<std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>>,
+		typename A = std::allocator<T>
+	>
+	class arena_rb_tree {
+
+	public:
+
+		using value_type      = T;
+		using key_type        = std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>;
+		using key_compare     = compare;
+		using value_compare   = key_compare;
+		using alloc_type      = A;
+		using alloc_traits    = std::allocator_traits<A>;
+		using size_type       = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using node_type = arena_node<T>;
+
+		using iterator       = arena_iterator<node_type, false>;
+		using const_iterator = arena_iterator<node_type, true>;
+
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	private:
+
+		using slot_alloc  = typename alloc_traits::template rebind_alloc<node_type>;
+		using slot_traits = std::allocator_traits<slot_alloc>;
+
+		[[no_unique_address]] alloc_type  m_ValueAlloc{};
+		[[no_unique_address]] slot_alloc  m_SlotAlloc{ m_ValueAlloc };
+		[[no_unique_address]] key_compare m_Comp{};
+		[[no_unique_address]] KeyOfValue  m_KeyExtractor{};
+
+		node_type*  mp_Slots{};          // [0] is the header, nullptr until the first insert
+		arena_index m_Used{};            // slots handed out so far (header included)
+		arena_index m_Capacity{};
+		arena_index m_FreeHead{};        // erased slots, chained through m_Left
+		arena_index m_Leftmost{};        // begin()
+		size_type   m_Size{};
+
+	public:
+
+		// ================= Ctors =================
+
+		explicit arena_rb_tree(const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: m_ValueAlloc{ a }
+			, m_SlotAlloc{ m_ValueAlloc }
+			, m_Comp{ c } {
+		}
+
+		template<std::input_iterator It>
+		arena_rb_tree(It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: arena_rb_tree(a, c)
+		{
+			if constexpr (std::forward_iterator<It>)
+				reserve(static_cast<size_type>(std::distance(first, last)));
+
+			for (; first != last; ++first)
+				insert(end(), *first);
+		}
+
+		arena_rb_tree(std::initializer_list<T> il, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: arena_rb_tree(il.begin(), il.end(), a, c) {
+		}
+
+		// [first, last) sorted by key, no duplicates: O(n) bottom-up
+		// build, the nodes laid out in key order
+		template<std::input_iterator It>
+		arena_rb_tree(sorted_unique_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: arena_rb_tree(a, c)
+		{
+			build_sorted(first, last);
+		}
+
+		// ============= Copy semantics =================
+
+		// slot by slot: same indices, same shape and colors, no
+		// comparison; trivially copyable values: a single memcpy
+		arena_rb_tree(const arena_rb_tree& other)
+			: arena_rb_tree(alloc_traits::select_on_container_copy_construction(other.m_ValueAlloc), other.m_Comp)
+		{
+			if (!other.mp_Slots) return;
+
+			node_type* slots = slot_traits::allocate(m_SlotAlloc, other.m_Used);
+
+			try {
+				copy_slots(other.mp_Slots, other.m_Used, slots);
+			}
+			catch (...)
+			{
+				slot_traits::deallocate(m_SlotAlloc, slots, other.m_Used);
+				throw;
+			}
+
+			mp_Slots = slots;
+			m_Used = m_Capacity = other.m_Used;
+			m_FreeHead = other.m_FreeHead;
+			m_Leftmost = other.m_Leftmost;
+			m_Size = other.m_Size;
+		}
+
+		arena_rb_tree& operator=(const arena_rb_tree& other)
+		{
+			if (this == &other) return *this;
+			arena_rb_tree tmp(other);
+			swap(tmp);
+			return *this;
+		}
+
+		// ============= Move semantics =================
+
+		arena_rb_tree(arena_rb_tree&& other) noexcept
+			: m_ValueAlloc{ std::move(other.m_ValueAlloc) }
+			, m_SlotAlloc{ m_ValueAlloc }
+			, m_Comp{ std::move(other.m_Comp) }
+			, m_KeyExtractor{ std::move(other.m_KeyExtractor) }
+			, mp_Slots{ std::exchange(other.mp_Slots, nullptr) }
+			, m_Used{ std::exchange(other.m_Used, 0) }
+			, m_Capacity{ std::exchange(other.m_Capacity, 0) }
+			, m_FreeHead{ std::exchange(other.m_FreeHead, 0) }
+			, m_Leftmost{ std::exchange(other.m_Leftmost, 0) }
+			, m_Size{ std::exchange(other.m_Size, 0) } {
+		}
+
+		arena_rb_tree& operator=(arena_rb_tree&& other) noexcept
+		{
+			if (this != &other) swap(other);
+			return *this;
+		}
+
+		~arena_rb_tree()
+		{
+			clear();
+			release_arena();
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return iterator{ &mp_Slots, m_Leftmost }; }
+		const_iterator begin() const noexcept { return const_iterator{ &mp_Slots, m_Leftmost }; }
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		iterator end() noexcept { return iterator{ &mp_Slots, arena_nil }; }
+		const_iterator end() const noexcept { return const_iterator{ &mp_Slots, arena_nil }; }
+		const_iterator cend() const noexcept { return end(); }
+
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return rend(); }
+
+		// ================= Capacity =================
+
+		size_type size() const noexcept { return m_Size; }
+
+		bool empty() const noexcept { return m_Size == 0; }
+
+		static constexpr size_type max_size() noexcept { return arena_max_nodes; }
+
+		// values the arena holds without growing
+		size_type capacity() const noexcept { return m_Capacity ? m_Capacity - 1u : 0u; }
+
+		// room for n values: no reallocation (and no invalidated
+		// reference) until the tree grows past n
+		void reserve(size_type n)
+		{
+			if (n > max_size())
+				throw std::length_error{ "mstl::arena_rb_tree: size exceeds max_size" };
+
+			if (n && n + 1 > m_Capacity)
+				grow_to(static_cast<arena_index>(n + 1));
+		}
+
+		// gives the unused capacity back (only when no erased slot is
+		// waiting for reuse); an empty tree gives its whole arena back
+		void shrink_to_fit()
+		{
+			if (empty())
+			{
+				release_arena();
+				return;
+			}
+
+			if (m_FreeHead == arena_nil && m_Used < m_Capacity)
+				grow_to(m_Used);
+		}
+
+		// ================= Lookups =================
+
+		iterator find(const key_type& key) noexcept { return iterator{ &mp_Slots, find_index(key) }; }
+		const_iterator find(const key_type& key) const noexcept { return const_iterator{ &mp_Slots, find_index(key) }; }
+
+		bool contains(const key_type& key) const noexcept { return find_index(key) != arena_nil; }
+
+		iterator lower_bound(const key_type& key) noexcept { return iterator{ &mp_Slots, bound_index<false>(key) }; }
+		const_iterator lower_bound(const key_type& key) const noexcept { return const_iterator{ &mp_Slots, bound_index<false>(key) }; }
+
+		iterator upper_bound(const key_type& key) noexcept { return iterator{ &mp_Slots, bound_index<true>(key) }; }
+		const_iterator upper_bound(const key_type& key) const noexcept { return const_iterator{ &mp_Slots, bound_index<true>(key) }; }
+
+		std::pair<iterator, iterator> equal_range(const key_type& key) noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ============== Heterogeneous lookups =================
+		// transparent comparators only, see TransparentCompare
+
+		template<typename K>
+		static constexpr bool is_heterogeneous_key = TransparentCompare<key_compare>
+			&& !std::is_convertible_v<const K&, iterator>
+			&& !std::is_convertible_v<const K&, const_iterator>;
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator find(const K& key) noexcept { return iterator{ &mp_Slots, find_index(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator find(const K& key) const noexcept { return const_iterator{ &mp_Slots, find_index(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		bool contains(const K& key) const noexcept { return find_index(key) != arena_nil; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator lower_bound(const K& key) noexcept { return iterator{ &mp_Slots, bound_index<false>(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator lower_bound(const K& key) const noexcept { return const_iterator{ &mp_Slots, bound_index<false>(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator upper_bound(const K& key) noexcept { return iterator{ &mp_Slots, bound_index<true>(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator upper_bound(const K& key) const noexcept { return const_iterator{ &mp_Slots, bound_index<true>(key) }; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		std::pair<iterator, iterator> equal_range(const K& key) noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ================= Modifiers =================
+
+		// the arena (and its capacity) is kept
+		void clear() noexcept
+		{
+			if (!mp_Slots) return;
+
+			if constexpr (!std::is_trivially_destructible_v<T> || !alloc_default_construct<A, T>)
+			{
+				for (arena_index i = 1; i < m_Used; ++i)
+					if (!mp_Slots[i].is_free())
+						alloc_traits::destroy(m_ValueAlloc, std::addressof(mp_Slots[i].value()));
+			}
+
+			m_Used = 1;
+			reset_header();
+		}
+
+		template<typename U>
+		std::pair<iterator, bool> insert(U&& v)
+		{
+			if constexpr (std::is_same_v<std::remove_cvref_t<U>, value_type>)
+			{
+				return insert_impl(std::forward<U>(v));
+			}
+			else
+			{
+				// convertible input (e.g. pair<K, V> for pair<const K, V>):
+				// build the value first, the key must outlive the search
+				return insert_impl(value_type(std::forward<U>(v)));
+			}
+		}
+
+		// O(1) when v goes right before hint (e.g. end() for
+		// ascending input), else a normal insert
+		template<typename U>
+		iterator insert(const_iterator hint, U&& v)
+		{
+			if constexpr (std::is_same_v<std::remove_cvref_t<U>, value_type>)
+			{
+				const position pos = hint_position(hint.m_Idx, m_KeyExtractor(v));
+
+				if (pos.existing != arena_nil) return iterator{ &mp_Slots, pos.existing };
+				if (!pos.valid) return insert_impl(std::forward<U>(v)).first;
+
+				return iterator{ &mp_Slots, link_new(pos, std::forward<U>(v)) };
+			}
+			else
+			{
+				return insert(hint, value_type(std::forward<U>(v)));
+			}
+		}
+
+		// the value is built in its slot, dropped on a duplicate key
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			const arena_index n = new_slot(std::forward<Args>(args)...);
+			const position pos = find_position(key_of(n));
+
+			if (pos.existing != arena_nil)
+			{
+				free_slot(n);
+				return { iterator{ &mp_Slots, pos.existing }, false };
+			}
+
+			link_slot(n, pos);
+			return { iterator{ &mp_Slots, n }, true };
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			const arena_index n = new_slot(std::forward<Args>(args)...);
+			position pos = hint_position(hint.m_Idx, key_of(n));
+
+			if (!pos.valid && pos.existing == arena_nil) pos = find_position(key_of(n));
+
+			if (pos.existing != arena_nil)
+			{
+				free_slot(n);
+				return iterator{ &mp_Slots, pos.existing };
+			}
+
+			link_slot(n, pos);
+			return iterator{ &mp_Slots, n };
+		}
+
+		// lookup first: the value is built from args only for a new
+		// key (try_emplace, operator[])
+		template<typename K, class... Args>
+		std::pair<iterator, bool> emplace_if_absent(const K& key, Args&&... args)
+		{
+			const position pos = find_position(key);
+
+			if (pos.existing != arena_nil) return { iterator{ &mp_Slots, pos.existing }, false };
+
+			return { iterator{ &mp_Slots, link_new(pos, std::forward<Args>(args)...) }, true };
+		}
+
+		// erase by key
+		size_type erase(const key_type& key)
+		{
+			const arena_index z = find_index(key);
+			if (z == arena_nil) return 0;
+			erase_slot(z);
+			return 1;
+		}
+
+		template<typename K> requires is_heterogeneous_key<K>
+		size_type erase(const K& key)
+		{
+			const arena_index z = find_index(key);
+			if (z == arena_nil) return 0;
+			erase_slot(z);
+			return 1;
+		}
+
+		// erase by iterator -> returns successor
+		// (the successor keeps its slot, erase never moves a value)
+		iterator erase(const_iterator pos)
+		{
+			const arena_index next = ArenaSuccessor(mp_Slots, pos.m_Idx);
+			erase_slot(pos.m_Idx);
+			return iterator{ &mp_Slots, next };
+		}
+
+		void swap(arena_rb_tree& other) noexcept
+		{
+			using std::swap;
+
+			if constexpr (alloc_traits::propagate_on_container_swap::value)
+				swap(m_ValueAlloc, other.m_ValueAlloc);
+
+			m_SlotAlloc = slot_alloc{ m_ValueAlloc };
+			other.m_SlotAlloc = slot_alloc{ other.m_ValueAlloc };
+
+			swap(m_Comp, other.m_Comp);
+			swap(m_KeyExtractor, other.m_KeyExtractor);
+			swap(mp_Slots, other.mp_Slots);
+			swap(m_Used, other.m_Used);
+			swap(m_Capacity, other.m_Capacity);
+			swap(m_FreeHead, other.m_FreeHead);
+			swap(m_Leftmost, other.m_Leftmost);
+			swap(m_Size, other.m_Size);
+		}
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Comp; }
+
+		alloc_type get_allocator() const { return m_ValueAlloc; }
+
+		// ================= Debug =================
+
+		/// RB invariants, parent links, key order, header caches and
+		/// the slot accounting (live + free + header == used).
+		bool verify() const noexcept
+		{
+			if (!mp_Slots) return m_Size == 0;
+
+			const arena_index root = mp_Slots[0].m_Left;
+
+			if (root != arena_nil && (mp_Slots[root].color() != RBBk || mp_Slots[root].parent() != arena_nil))
+				return false;
+
+			size_type count = 0;
+			if (verify_rec(root, count) < 0 || count != m_Size) return false;
+
+			if (m_Leftmost != (root ? ArenaMin(mp_Slots, root) : arena_nil)
+				|| mp_Slots[0].m_Right != (root ? ArenaMax(mp_Slots, root) : arena_nil))
+				return false;
+
+			// keys strictly increasing in order
+			for (arena_index i = m_Leftmost, next; i != arena_nil; i = next)
+			{
+				next = ArenaSuccessor(mp_Slots, i);
+				if (next != arena_nil && !m_Comp(key_of(i), key_of(next))) return false;
+			}
+
+			size_type free_slots = 0;
+			for (arena_index f = m_FreeHead; f != arena_nil; f = mp_Slots[f].m_Left)
+			{
+				if (!mp_Slots[f].is_free() || ++free_slots > m_Used) return false;
+			}
+
+			return 1 + m_Size + free_slots == m_Used;
+		}
+
+		friend bool operator==(const arena_rb_tree& a, const arena_rb_tree& b)
+		{
+			return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+		friend bool operator!=(const arena_rb_tree& a, const arena_rb_tree& b) { return !(a == b); }
+
+	private:
+
+		// ================= Slots =================
+
+		node_type& slot(arena_index i) noexcept { return mp_Slots[i]; }
+		const node_type& slot(arena_index i) const noexcept { return mp_Slots[i]; }
+
+		const key_type& key_of(arena_index i) const noexcept { return m_KeyExtractor(mp_Slots[i].value()); }
+
+		arena_index root() const noexcept { return mp_Slots ? mp_Slots[0].m_Left : arena_nil; }
+
+		RBColor color_of(arena_index i) const noexcept {
+			return i == arena_nil ? RBBk : mp_Slots[i].color(); // leaves are always black
+		}
+
+		void set_color(arena_index i, RBColor c) noexcept {
+			if (i != arena_nil) mp_Slots[i].set_color(c);
+		}
+
+		void reset_header() noexcept
+		{
+			mp_Slots[0].m_Left = mp_Slots[0].m_Right = arena_nil;
+			mp_Slots[0].m_Parent = arena_nil;
+			m_FreeHead = arena_nil;
+			m_Leftmost = arena_nil;
+			m_Size = 0;
+		}
+
+		void release_arena() noexcept
+		{
+			if (mp_Slots) slot_traits::deallocate(m_SlotAlloc, mp_Slots, m_Capacity);
+			mp_Slots = nullptr;
+			m_Used = m_Capacity = 0;
+			m_FreeHead = m_Leftmost = arena_nil;
+			m_Size = 0;
+		}
+
+		/// Copies the first n slots of src into the raw dst: links
+		/// byte for byte, values copy constructed (one memcpy when
+		/// they are trivially copyable). Strong guarantee.
+		void copy_slots(const node_type* src, arena_index n, node_type* dst)
+		{
+			if constexpr (copy_by_memcpy<A, T>)
+			{
+				std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(node_type));
+			}
+			else
+			{
+				transfer_slots<false>(src, n, dst);
+			}
+		}
+
+		// live values copied (or moved, Move), free slots and the
+		// header only get their links; on exception dst is left empty
+		template<bool Move>
+		void transfer_slots(std::conditional_t<Move, node_type*, const node_type*> src, arena_index n, node_type* dst)
+		{
+			arena_index i = 0;
+
+			try {
+				for (; i < n; ++i)
+				{
+					dst[i].m_Left = src[i].m_Left;
+					dst[i].m_Right = src[i].m_Right;
+					dst[i].m_Parent = src[i].m_Parent;
+
+					if (i == 0 || src[i].is_free()) continue;
+
+					if constexpr (Move)
+						alloc_traits::construct(m_ValueAlloc, std::addressof(dst[i].value()), std::move_if_noexcept(src[i].value()));
+					else
+						alloc_traits::construct(m_ValueAlloc, std::addressof(dst[i].value()), src[i].value());
+				}
+			}
+			catch (...)
+			{
+				while (i > 1)
+				{
+					--i;
+					if (!src[i].is_free())
+						alloc_traits::destroy(m_ValueAlloc, std::addressof(dst[i].value()));
+				}
+				throw;
+			}
+		}
+
+		/// Moves the used slots into an arena of new_cap slots: one
+		/// memcpy for trivially relocatable values, else each live
+		/// value is moved (copied if its move may throw) and the old
+		/// one destroyed. Strong guarantee.
+		void grow_to(arena_index new_cap)
+		{
+			node_type* slots = slot_traits::allocate(m_SlotAlloc, new_cap);
+
+			if (!mp_Slots)
+			{
+				mp_Slots = slots;
+				m_Capacity = new_cap;
+				m_Used = 1;
+				reset_header();
+				return;
+			}
+
+			try {
+				adopt_arena(slots, new_cap);
+			}
+			catch (...)
+			{
+				slot_traits::deallocate(m_SlotAlloc, slots, new_cap);
+				throw;
+			}
+		}
+
+		// moves the used slots into slots and frees the old arena; if
+		// a move throws the old arena is untouched and slots is still
+		// the caller's
+		void adopt_arena(node_type* slots, arena_index new_cap)
+		{
+			if constexpr (relocate_by_memcpy<A, T>)
+			{
+				std::memcpy(static_cast<void*>(slots), static_cast<const void*>(mp_Slots), m_Used * sizeof(node_type));
+			}
+			else
+			{
+				transfer_slots<true>(mp_Slots, m_Used, slots);
+
+				for (arena_index i = 1; i < m_Used; ++i)
+					if (!mp_Slots[i].is_free())
+						alloc_traits::destroy(m_ValueAlloc, std::addressof(mp_Slots[i].value()));
+			}
+
+			slot_traits::deallocate(m_SlotAlloc, mp_Slots, m_Capacity);
+			mp_Slots = slots;
+			m_Capacity = new_cap;
+		}
+
+		/// The arena is full: the value is built in the new array
+		/// before the old one is freed, args may refer to a value in
+		/// the tree (insert_or_assign(k, begin()->second)), as
+		/// vector::realloc_emplace_back. Strong guarantee.
+		template<class... Args>
+		arena_index grow_emplace(Args&&... args)
+		{
+			if (m_Size >= max_size())
+				throw std::length_error{ "mstl::arena_rb_tree: size exceeds max_size" };
+
+			const arena_index new_cap = NextCapacity<arena_index>(m_Used, m_Capacity, 1, arena_max_nodes + 1, 16);
+			node_type* slots = slot_traits::allocate(m_SlotAlloc, new_cap);
+			const arena_index n = m_Used;
+
+			try {
+				alloc_traits::construct(m_ValueAlloc, std::addressof(slots[n].value()), std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				slot_traits::deallocate(m_SlotAlloc, slots, new_cap);
+				throw;
+			}
+
+			try {
+				adopt_arena(slots, new_cap);
+			}
+			catch (...)
+			{
+				alloc_traits::destroy(m_ValueAlloc, std::addressof(slots[n].value()));
+				slot_traits::deallocate(m_SlotAlloc, slots, new_cap);
+				throw;
+			}
+
+			return m_Used++;
+		}
+
+		// a slot for a new value: recycled, else the next unused one
+		arena_index take_slot()
+		{
+			if (m_FreeHead != arena_nil)
+			{
+				const arena_index i = m_FreeHead;
+				m_FreeHead = mp_Slots[i].m_Left;
+				return i;
+			}
+
+			if (m_Used == m_Capacity)
+			{
+				if (m_Size >= max_size())
+					throw std::length_error{ "mstl::arena_rb_tree: size exceeds max_size" };
+
+				grow_to(NextCapacity<arena_index>(m_Used, m_Capacity, 1, arena_max_nodes + 1, 16));
+			}
+
+			return m_Used++;
+		}
+
+		void put_slot(arena_index i) noexcept
+		{
+			mp_Slots[i].m_Parent = arena_free;
+			mp_Slots[i].m_Left = m_FreeHead;
+			m_FreeHead = i;
+		}
+
+		// takes a slot and builds the value in it, the slot goes back
+		// to the free list if the constructor throws
+		template<class... Args>
+		arena_index new_slot(Args&&... args)
+		{
+			if (mp_Slots && m_FreeHead == arena_nil && m_Used == m_Capacity)
+				return grow_emplace(std::forward<Args>(args)...);
+
+			const arena_index n = take_slot();
+
+			try {
+				alloc_traits::construct(m_ValueAlloc, std::addressof(mp_Slots[n].value()), std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				put_slot(n);
+				throw;
+			}
+
+			return n;
+		}
+
+		void free_slot(arena_index n) noexcept
+		{
+			alloc_traits::destroy(m_ValueAlloc, std::addressof(mp_Slots[n].value()));
+			put_slot(n);
+		}
+
+		// ================= Search =================
+
+		template<typename K>
+		arena_index find_index(const K& key) const noexcept
+		{
+			arena_index i = root();
+
+			while (i != arena_nil)
+			{
+				const key_type& k = key_of(i);
+
+				if (m_Comp(key, k))
+					i = mp_Slots[i].m_Left;
+				else if (m_Comp(k, key))
+					i = mp_Slots[i].m_Right;
+				else
+					return i;
+			}
+
+			return arena_nil;
+		}
+
+		// first slot with key >= key (Upper: key > key), or the header
+		template<bool Upper, typename K>
+		arena_index bound_index(const K& key) const noexcept
+		{
+			arena_index i = root();
+			arena_index result = arena_nil;
+
+			while (i != arena_nil)
+			{
+				const bool go_left = Upper ? m_Comp(key, key_of(i)) : !m_Comp(key_of(i), key);
+
+				if (go_left)
+				{
+					result = i;
+					i = mp_Slots[i].m_Left;
+				}
+				else
+				{
+					i = mp_Slots[i].m_Right;
+				}
+			}
+
+			return result;
+		}
+
+		/// Where a key goes: under parent (the header for an empty
+		/// tree), on the as_left side, or the slot already holding it.
+		/// valid == false: a hint that didn't fit, search from the root.
+		struct position {
+			arena_index parent{};
+			bool        as_left{};
+			arena_index existing{};
+			bool        valid{ true };
+		};
+
+		template<typename K>
+		position find_position(const K& key) const noexcept
+		{
+			arena_index parent = arena_nil;
+			arena_index i = root();
+			bool as_left = true;
+
+			while (i != arena_nil)
+			{
+				parent = i;
+				const key_type& k = key_of(i);
+
+				if (m_Comp(key, k))
+				{
+					as_left = true;
+					i = mp_Slots[i].m_Left;
+				}
+				else if (m_Comp(k, key))
+				{
+					as_left = false;
+					i = mp_Slots[i].m_Right;
+				}
+				else
+				{
+					return { arena_nil, false, i };
+				}
+			}
+
+			return { parent, as_left, arena_nil };
+		}
+
+		// right before next (next == header: after the rightmost)
+		position position_before(arena_index next) const noexcept
+		{
+			if (next == arena_nil)
+			{
+				return m_Size ? position{ mp_Slots[0].m_Right, false } : position{ arena_nil, true };
+			}
+
+			if (mp_Slots[next].m_Left == arena_nil) return { next, true };
+
+			return { ArenaMax(mp_Slots, mp_Slots[next].m_Left), false };
+		}
+
+		// same checks of tree_base::DoHintPosition, on indices
+		position hint_position(arena_index hint, const key_type& key) const noexcept
+		{
+			if (empty()) return { arena_nil, true };
+
+			if (hint == arena_nil || m_Comp(key, key_of(hint)))
+			{
+				// key goes before hint: right after its predecessor?
+				if (hint == m_Leftmost) return position_before(hint);
+
+				const arena_index prev = ArenaPredecessor(mp_Slots, hint);
+
+				if (m_Comp(key_of(prev), key)) return position_before(hint);
+				if (!m_Comp(key, key_of(prev))) return { arena_nil, false, prev };
+
+				return { arena_nil, false, arena_nil, false };
+			}
+
+			if (!m_Comp(key_of(hint), key)) return { arena_nil, false, hint };
+
+			// key goes after hint: right before its successor?
+			const arena_index next = ArenaSuccessor(mp_Slots, hint);
+
+			if (next == arena_nil || m_Comp(key, key_of(next))) return position_before(next);
+			if (!m_Comp(key_of(next), key)) return { arena_nil, false, next };
+
+			return { arena_nil, false, arena_nil, false };
+		}
+
+		// ================= Insert =================
+
+		template<typename U>
+		std::pair<iterator, bool> insert_impl(U&& v)
+		{
+			const position pos = find_position(m_KeyExtractor(v));
+
+			if (pos.existing != arena_nil) return { iterator{ &mp_Slots, pos.existing }, false };
+
+			return { iterator{ &mp_Slots, link_new(pos, std::forward<U>(v)) }, true };
+		}
+
+		// pos holds indices: still right after the arena grows
+		template<class... Args>
+		arena_index link_new(const position& pos, Args&&... args)
+		{
+			const arena_index n = new_slot(std::forward<Args>(args)...);
+			link_slot(n, pos);
+			return n;
+		}
+
+		// hooks the built slot n at pos (red), keeps the header
+		// caches and restores the RB invariants
+		void link_slot(arena_index n, const position& pos) noexcept
+		{
+			node_type& x = mp_Slots[n];
+			x.m_Left = x.m_Right = arena_nil;
+			x.m_Parent = pos.parent;   // red
+
+			node_type& header = mp_Slots[0];
+
+			if (pos.parent == arena_nil)
+			{
+				header.m_Left = header.m_Right = n;
+				m_Leftmost = n;
+			}
+			else if (pos.as_left)
+			{
+				mp_Slots[pos.parent].m_Left = n;
+				if (pos.parent == m_Leftmost) m_Leftmost = n;
+			}
+			else
+			{
+				mp_Slots[pos.parent].m_Right = n;
+				if (pos.parent == header.m_Right) header.m_Right = n;
+			}
+
+			++m_Size;
+			insert_fixup(n);
+		}
+
+		// ================= Rotations =================
+
+		// parent p (the header for the root) now points to to
+		// instead of from
+		void replace_child(arena_index p, arena_index from, arena_index to) noexcept
+		{
+			if (p == arena_nil || mp_Slots[p].m_Left == from)
+				mp_Slots[p].m_Left = to;
+			else
+				mp_Slots[p].m_Right = to;
+		}
+
+		void rotate_left(arena_index x) noexcept
+		{
+			const arena_index y = mp_Slots[x].m_Right;
+			const arena_index w = mp_Slots[y].m_Left;
+			const arena_index p = mp_Slots[x].parent();
+
+			mp_Slots[x].m_Right = w;
+			if (w != arena_nil) mp_Slots[w].set_parent(x);
+
+			mp_Slots[y].m_Left = x;
+			mp_Slots[y].set_parent(p);
+			replace_child(p, x, y);
+			mp_Slots[x].set_parent(y);
+		}
+
+		void rotate_right(arena_index x) noexcept
+		{
+			const arena_index y = mp_Slots[x].m_Left;
+			const arena_index w = mp_Slots[y].m_Right;
+			const arena_index p = mp_Slots[x].parent();
+
+			mp_Slots[x].m_Left = w;
+			if (w != arena_nil) mp_Slots[w].set_parent(x);
+
+			mp_Slots[y].m_Right = x;
+			mp_Slots[y].set_parent(p);
+			replace_child(p, x, y);
+			mp_Slots[x].set_parent(y);
+		}
+
+		// b takes a's place under a's parent
+		void transplant(arena_index a, arena_index b) noexcept
+		{
+			const arena_index p = mp_Slots[a].parent();
+			replace_child(p, a, b);
+			if (b != arena_nil) mp_Slots[b].set_parent(p);
+		}
+
+		// ================= Fixups =================
+		// same cases of rb_tree::insert_fixup / erase_fixup
+
+		void insert_fixup(arena_index x) noexcept
+		{
+			arena_index px = mp_Slots[x].parent();
+
+			while (px != arena_nil && color_of(px) == RBRed)
+			{
+				// a red parent is never the root: gx exists
+				const arena_index gx = mp_Slots[px].parent();
+				const bool parent_is_left = px == mp_Slots[gx].m_Left;
+				const arena_index ux = parent_is_left ? mp_Slots[gx].m_Right : mp_Slots[gx].m_Left;
+
+				// unlucky: uncle is red, recolor and move up
+				if (color_of(ux) == RBRed)
+				{
+					set_color(px, RBBk);
+					set_color(ux, RBBk);
+					set_color(gx, RBRed);
+
+					x = gx;
+					px = mp_Slots[x].parent();
+					continue;
+				}
+
+				// uncle black, x on the inner side: turn it outer
+				if (parent_is_left && x == mp_Slots[px].m_Right)
+				{
+					rotate_left(px);
+					std::swap(x, px);
+				}
+				else if (!parent_is_left && x == mp_Slots[px].m_Left)
+				{
+					rotate_right(px);
+					std::swap(x, px);
+				}
+
+				// outer side: one rotation at gx ends it
+				if (parent_is_left)
+					rotate_right(gx);
+				else
+					rotate_left(gx);
+
+				set_color(gx, RBRed);
+				set_color(px, RBBk);
+				break;
+			}
+
+			set_color(root(), RBBk);
+		}
+
+		/// CLRS erase: y is the slot physically removed from its
+		/// position (z itself or its successor), x the child taking its
+		/// place; x may be the null link, its parent is tracked apart.
+		void erase_slot(arena_index z) noexcept
+		{
+			node_type& header = mp_Slots[0];
+
+			if (z == m_Leftmost) m_Leftmost = ArenaSuccessor(mp_Slots, z);
+			if (z == header.m_Right) header.m_Right = ArenaPredecessor(mp_Slots, z);
+
+			arena_index y = z;
+			RBColor y_original_color = color_of(y);
+			arena_index x = arena_nil;
+			arena_index x_parent = arena_nil;
+
+			if (mp_Slots[z].m_Left == arena_nil)
+			{
+				x = mp_Slots[z].m_Right;
+				x_parent = mp_Slots[z].parent();
+				transplant(z, x);
+			}
+			else if (mp_Slots[z].m_Right == arena_nil)
+			{
+				x = mp_Slots[z].m_Left;
+				x_parent = mp_Slots[z].parent();
+				transplant(z, x);
+			}
+			else
+			{
+				y = ArenaMin(mp_Slots, mp_Slots[z].m_Right);
+				y_original_color = color_of(y);
+				x = mp_Slots[y].m_Right;
+
+				if (mp_Slots[y].parent() == z)
+				{
+					x_parent = y;
+				}
+				else
+				{
+					x_parent = mp_Slots[y].parent();
+					transplant(y, x);
+
+					mp_Slots[y].m_Right = mp_Slots[z].m_Right;
+					mp_Slots[mp_Slots[y].m_Right].set_parent(y);
+				}
+
+				transplant(z, y);
+
+				mp_Slots[y].m_Left = mp_Slots[z].m_Left;
+				mp_Slots[mp_Slots[y].m_Left].set_parent(y);
+
+				// y takes z place and color
+				set_color(y, color_of(z));
+			}
+
+			--m_Size;
+			free_slot(z);
+
+			if (y_original_color == RBBk)
+				erase_fixup(x, x_parent);
+		}
+
+		void erase_fixup(arena_index x, arena_index px) noexcept
+		{
+			while (x != root() && color_of(x) == RBBk)
+			{
+				const bool IsXLeftChild = x == mp_Slots[px].m_Left;
+				arena_index bx = IsXLeftChild ? mp_Slots[px].m_Right : mp_Slots[px].m_Left;
+
+				// red brother: rotate it above px, now the brother is black
+				if (color_of(bx) == RBRed)
+				{
+					set_color(bx, RBBk);
+					set_color(px, RBRed);
+
+					if (IsXLeftChild)
+					{
+						rotate_left(px);
+						bx = mp_Slots[px].m_Right;
+					}
+					else
+					{
+						rotate_right(px);
+						bx = mp_Slots[px].m_Left;
+					}
+				}
+
+				arena_index sameX = IsXLeftChild ? mp_Slots[bx].m_Left : mp_Slots[bx].m_Right;
+				arena_index oppoX = IsXLeftChild ? mp_Slots[bx].m_Right : mp_Slots[bx].m_Left;
+
+				// brother and nephews black: move the problem up
+				if (color_of(sameX) == RBBk && color_of(oppoX) == RBBk)
+				{
+					set_color(bx, RBRed);
+					x = px;
+					px = mp_Slots[px].parent();
+					continue;
+				}
+
+				// only the near nephew is red: turn it into the far one
+				if (color_of(oppoX) == RBBk)
+				{
+					set_color(sameX, RBBk);
+					set_color(bx, RBRed);
+
+					if (IsXLeftChild)
+					{
+						rotate_right(bx);
+						bx = mp_Slots[px].m_Right;
+					}
+					else
+					{
+						rotate_left(bx);
+						bx = mp_Slots[px].m_Left;
+					}
+
+					oppoX = IsXLeftChild ? mp_Slots[bx].m_Right : mp_Slots[bx].m_Left;
+				}
+
+				// far nephew red: one rotation ends it
+				set_color(bx, color_of(px));
+				set_color(px, RBBk);
+				set_color(oppoX, RBBk);
+
+				if (IsXLeftChild)
+					rotate_left(px);
+				else
+					rotate_right(px);
+
+				x = root();
+				break;
+			}
+
+			set_color(x, RBBk);
+		}
+
+		// ================= Sorted build =================
+
+		/// Values go to slots 1..n in input order, then the links of a
+		/// perfectly balanced tree are laid over them: in-order walk ==
+		/// memory order. Colors as rb_tree::build_sorted: black, but
+		/// the deepest level when it is incomplete.
+		template<typename It>
+		void build_sorted(It first, It last)
+		{
+			if constexpr (std::forward_iterator<It>)
+				reserve(static_cast<size_type>(std::distance(first, last)));
+
+			arena_index n = 0;
+
+			try {
+				for (; first != last; ++first)
+				{
+					const arena_index i = take_slot();
+					alloc_traits::construct(m_ValueAlloc, std::addressof(mp_Slots[i].value()), *first);
+					++n;
+				}
+			}
+			catch (...)
+			{
+				for (arena_index i = 1; i <= n; ++i)
+					alloc_traits::destroy(m_ValueAlloc, std::addressof(mp_Slots[i].value()));
+				if (mp_Slots) m_Used = 1;
+				throw;
+			}
+
+			if (n == 0) return;
+
+			const int levels = static_cast<int>(std::bit_width(n));
+			const int full_levels = static_cast<int>(std::bit_width(n + 1u)) - 1;
+			const int red_depth = levels > full_levels ? levels - 1 : -1;
+
+			const arena_index root_idx = link_range(1, n + 1, arena_nil, 0, red_depth);
+
+			mp_Slots[0].m_Left = root_idx;
+			mp_Slots[0].m_Right = n;
+			m_Leftmost = 1;
+			m_Size = n;
+		}
+
+		// links slots [lo, hi) as a balanced subtree under parent
+		arena_index link_range(arena_index lo, arena_index hi, arena_index parent, int depth, int red_depth) noexcept
+		{
+			if (lo >= hi) return arena_nil;
+
+			const arena_index mid = lo + (hi - lo) / 2;
+			node_type& m = mp_Slots[mid];
+
+			m.m_Parent = parent;
+			m.set_color(depth == red_depth ? RBRed : RBBk);
+			m.m_Left = link_range(lo, mid, mid, depth + 1, red_depth);
+			m.m_Right = link_range(mid + 1, hi, mid, depth + 1, red_depth);
+
+			return mid;
+		}
+
+		// ================= Verification =================
+
+		// black height of the subtree, -1 on a broken invariant
+		int verify_rec(arena_index i, size_type& count) const noexcept
+		{
+			if (i == arena_nil) return 1;
+
+			const node_type& n = mp_Slots[i];
+			if (n.is_free()) return -1;
+
+			++count;
+
+			for (arena_index c : { n.m_Left, n.m_Right })
+			{
+				if (c == arena_nil) continue;
+				if (mp_Slots[c].parent() != i) return -1;
+				if (n.color() == RBRed && mp_Slots[c].color() == RBRed) return -1;
+			}
+
+			const int hl = verify_rec(n.m_Left, count);
+			const int hr = verify_rec(n.m_Right, count);
+
+			if (hl < 0 || hl != hr) return -1;
+
+			return hl + (n.color() == RBBk ? 1 : 0);
+		}
+	};
+
+	/// No pointer into itself: the tree relocates with its bytes when
+	/// its allocator and comparator do (stateless ones always can).
+	template<typename T, typename KeyOfValue, typename Compare, typename A>
+	struct is_trivially_relocatable<arena_rb_tree<T, KeyOfValue, Compare, A>>
+		: std::bool_constant<
+			(std::is_empty_v<A> || is_trivially_relocatable_v<A>) &&
+			(std::is_empty_v<Compare> || is_trivially_relocatable_v<Compare>)> {
+	};
+}
+
+#endif // !MSTL_ARENA_TREE_H
@@ -34,6 +34,20 @@ namespace mstl {
 		}
 	};
 
+	/// ---------------------------------------------------------------
+	/// avl order statistic node
+	/// ---------------------------------------------------------------
+	/// avl_node plus the size of its subtree: using it as NodeT
+	/// enables rank(), select(), index_of() and O(log n) distance()
+
+	template<typename T>
+	struct avl_os_node : public avl_node<T> {
+
+		std::size_t m_Count{ 1 };
+
+		using avl_node<T>::avl_node;
+	};
+
 	/// ---------------------------------------------------------------
 	/// AVL Tree
 	/// ---------------------------------------------------------------
@@ -54,6 +68,9 @@ namespace mstl {
 		using node_alloc = typename base_type::node_alloc;
 		using node_traits = typename base_type::node_traits;
 
+		// the join based algorithms call back DoJoin & co.
+		friend base_type;
+
 	public:
 
 		using key_type = typename base_type::key_type;
@@ -91,12 +108,30 @@ namespace mstl {
 				insert(v);
 		}
 
+		// [first, last) must be sorted by key and without duplicates:
+		// built bottom-up in O(n), see tree_base::DoBuildSorted
+		template<std::input_iterator It>
+		avl_tree(sorted_unique_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: base_type(a, c)
+		{
+			build_sorted(first, last);
+		}
+
+		template<std::input_iterator It>
+		static avl_tree from_sorted(It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+		{
+			return avl_tree(sorted_unique, first, last, a, c);
+		}
+
 		// ============= Copy semantics =================
 
+		// node for node, heights included, see tree_base::DoCloneFrom
 		avl_tree(const avl_tree& other)
 			: base_type(other.m_ValueAlloc, other.m_Comp) {
 
-			for (const auto& v : other) insert(v);
+			this->DoCloneFrom(other, [](node_type* n, const node_type* src) {
+				n->m_Height = src->m_Height;
+			});
 		}
 
 		avl_tree& operator=(const avl_tree& other) {
@@ -110,7 +145,10 @@ namespace mstl {
 
 		// ============= Move semantics =================
 
-		avl_tree(const avl_tree&& other) noexcept {
+		// starts from a copy of other's allocator (a default
+		// constructed one may allocate), then takes the nodes
+		avl_tree(avl_tree&& other) noexcept
+			: base_type(other.m_ValueAlloc, other.m_Comp) {
 
 			swap(other);
 		}
@@ -139,20 +177,83 @@ namespace mstl {
 			return { iterator{ n }, ok };
 		}
 
+		// O(1) amortized search when v goes right before or after
+		// hint, the usual descent otherwise (see DoHintPosition)
+		template<typename U>
+		iterator insert(const_iterator hint, U&& v) {
+
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->m_KeyExtractor(v), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+
+			if (pos.existing) return iterator{ pos.existing };
+
+			node_type* n = create_node(std::forward<U>(v), pos.parent);
+			link_node(n, pos);
+
+			return iterator{ n };
+		}
+
+		// the value is built once, in the node: on a duplicate
+		// key the node is dropped
 		template<class... Args>
 		std::pair<iterator, bool> emplace(Args&&... args)
 		{
-			value_type temp(std::forward<Args>(args)...);
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
 
-			auto [n, ok] = insert_impl(std::move(temp));
+			auto [p, ok] = insert_node(n);
+			if (!ok) this->DoDestroyNode(n);
 
-			return { iterator{ n }, ok };
+			return { iterator{ p }, ok };
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->DoKeyOf(n), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->DoKeyOf(n));
+
+			if (pos.existing)
+			{
+				this->DoDestroyNode(n);
+				return iterator{ pos.existing };
+			}
+
+			link_node(n, pos);
+			return iterator{ n };
+		}
+
+		// args build the value only when key is not here (try_emplace)
+		template<class... Args>
+		std::pair<iterator, bool> emplace_if_absent(const key_type& key, Args&&... args)
+		{
+			auto pos = this->DoFindInsertPosition(key);
+			if (pos.existing) return { iterator{ pos.existing }, false };
+
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			link_node(n, pos);
+
+			return { iterator{ n }, true };
 		}
 
 		// erase by key
 		size_type erase(const key_type& key) {
 
-			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->mp_Root, key, this->m_KeyExtractor, this->m_Comp);
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
+			if (!z) return 0;
+			erase_node(z);
+			return 1;
+		}
+
+		// transparent comparators only (see TransparentCompare)
+		template<typename K> requires base_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) {
+
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
 			if (!z) return 0;
 			erase_node(z);
 			return 1;
@@ -161,8 +262,8 @@ namespace mstl {
 		// erase by iterator -> returns successor
 		iterator erase(iterator pos) {
 
-			base_node_type* z = pos.curr;
-			if (!z) return this->end();
+			base_node_type* z = this->DoIterNode(pos);
+			if (z == this->DoHeader()) return this->end();
 			base_node_type* s = mstl::TreeSuccessor<base_node_type>(z);
 			erase_node(z);
 			return iterator{ s };
@@ -170,82 +271,225 @@ namespace mstl {
 
 		void swap(avl_tree& other) noexcept {
 			using std::swap;
-			swap(this->m_ValueAlloc, other.m_ValueAlloc);
-			swap(this->m_NodeAlloc, other.m_NodeAlloc);
-			swap(this->m_Comp, other.m_Comp);
-			swap(this->m_Size, other.m_Size);
-			swap(this->mp_Root, other.mp_Root);
+			this->DoSwap(other);
+		}
+
+		// ================= Join / Split =================
+		// see tree_base, "Join based algorithms". The trees involved
+		// must have equal allocators and comparators.
+
+		// every key of left < every key of right (unchecked), O(log n)
+		static avl_tree join(avl_tree&& left, avl_tree&& right) noexcept
+		{
+			avl_tree out(std::move(left));
+			out.DoJoinWith(out, nullptr, right);
+			return out;
+		}
+
+		// every key of left < key of pivot < every key of right
+		template<typename U>
+		static avl_tree join(avl_tree&& left, U&& pivot, avl_tree&& right)
+		{
+			avl_tree out(std::move(left));
+			node_type* k = out.DoCreateNode(std::forward<U>(pivot));
+			out.DoJoinWith(out, k, right);
+			return out;
+		}
+
+		// *this keeps the keys < key, the keys >= key are returned.
+		// O(log n) relinking, plus the size recount of DoSplitInto
+		avl_tree split(const key_type& key)
+		{
+			avl_tree out(this->m_ValueAlloc, this->m_Comp);
+			this->DoSplitInto(*this, key, out);
+			return out;
+		}
+
+		// as std::set::merge: the keys missing here move from other,
+		// the others stay there. Nodes are relinked, not copied
+		void merge(avl_tree& other) noexcept
+		{
+			if (this != &other) this->DoMergeFrom(*this, other);
+		}
+
+		// every node of other moves here, on equal keys ours stay
+		void union_with(avl_tree&& other) noexcept
+		{
+			if (this != &other) this->DoUnionWith(*this, other);
+		}
+
+		// keeps the keys that are also in other
+		void intersection_with(const avl_tree& other) noexcept
+		{
+			if (this != &other) this->DoIntersectionWith(*this, other);
+		}
+
+		// drops the keys that are in other
+		void difference_with(const avl_tree& other) noexcept
+		{
+			if (this == &other) clear();
+			else this->DoDifferenceWith(*this, other);
 		}
 
 		// ================= Observers =================
 
-		const node_type* root() const noexcept { return this->mp_Root; }
+		const node_type* root() const noexcept { return this->DoRoot(); }
 
 		alloc_type get_allocator() const { return this->m_ValueAlloc; }
 
 		// ================= Utility =================
 
 		void inorder_print() const noexcept {
-			inorder_print_rec(this->mp_Root, nullptr, "root");
+			inorder_print_rec(this->DoRoot(), nullptr, "root");
 		}
 
 	private:
 
 		// ================= Helpers =================
 
+		template<typename It>
+		void build_sorted(It first, It last)
+		{
+			// the bottom-up build already knows every subtree height
+			this->DoBuildSorted(first, last, [](node_type* n, int, int height) {
+				n->m_Height = height;
+			});
+		}
+
 		template<typename U>
 		std::pair<base_node_type*, bool> insert_impl(U&& v)
 		{
-			base_node_type* parent = nullptr;
-			base_node_type* current = this->mp_Root;
+			// find insertion position, by key
 
-			// find insertion position
+			auto pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+			if (pos.existing) return { pos.existing, false };
 
-			while (current)
-			{
-				parent = current;
-				const value_type& val = static_cast<const node_type*>(current)->m_Val;
+			// create node and link it (the header is the parent of the
+			// first one), tree_base keeps leftmost/rightmost and size
+			node_type* new_node = create_node(std::forward<U>(v), pos.parent);
+			link_node(new_node, pos);
 
-				if (this->m_Comp(v, val))
-				{
-					current = current->mp_Left;
-				}
-				else if (this->m_Comp(val, v))
-				{
-					current = current->mp_Right;
-				}
-				else
-				{
-					return { current, false };
-				}
-			}
+			return { new_node, true };
+		}
 
-			// create node
-			node_type* new_node = create_node(std::forward<U>(v), parent);
+		/// Links a detached node (merge, emplace): nothing is allocated.
+		/// If the key is already here returns that node, n is left alone.
+		std::pair<base_node_type*, bool> insert_node(node_type* n) noexcept
+		{
+			auto pos = this->DoFindInsertPosition(this->DoKeyOf(n));
+			if (pos.existing) return { pos.existing, false };
 
-			// insert as child of parent
-			if (!parent)
-			{
-				// update root
-				this->mp_Root = new_node;
-			}
-			else if (this->m_Comp(v, static_cast<const node_type*>(parent)->m_Val))
+			link_node(n, pos);
+			return { n, true };
+		}
+
+		// links a new node at a position found by DoFindInsertPosition
+		// or DoHintPosition, then rebalances
+		void link_node(node_type* n, const typename base_type::insert_position& pos) noexcept
+		{
+			n->m_Height = 1;
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+			rebalance_upward(n->mp_Parent);
+		}
+
+		// ================= Join =================
+		/// The rank of a piece is its height, already in the nodes:
+		/// join is O(|h(l) - h(r)| + 1).
+
+		using join_piece = typename base_type::join_piece;
+
+		int DoRootRank(base_node_type* root) const noexcept { return get_height(root); }
+
+		int DoChildRank(const join_piece&, base_node_type* child) const noexcept { return get_height(child); }
+
+		void DoFixRoot() noexcept {}
+
+		// k becomes the (detached) parent of l and r
+		static node_type* link(base_node_type* l, base_node_type* k, base_node_type* r) noexcept
+		{
+			node_type* n = static_cast<node_type*>(k);
+
+			n->mp_Left = l;
+			n->mp_Right = r;
+			n->mp_Parent = nullptr;
+			if (l) l->mp_Parent = n;
+			if (r) r->mp_Parent = n;
+			update_height(n);
+
+			if constexpr (base_type::has_order_statistics)
+				mstl::TreeUpdateCount<node_type>(n);
+
+			return n;
+		}
+
+		/// h(l) > h(r) + 1: walks down the right spine of l to the first
+		/// subtree c with h(c) <= h(r) + 1, k takes its place with c and
+		/// r as children; going back up at most one single or double
+		/// rotation per level restores the balance.
+		base_node_type* join_right(base_node_type* l, base_node_type* k, base_node_type* r) noexcept
+		{
+			base_node_type* ll = l->mp_Left;
+			base_node_type* c = l->mp_Right;
+
+			if (get_height(c) <= get_height(r) + 1)
 			{
-				parent->mp_Left = new_node;
+				node_type* t = link(c, k, r);
+				link(ll, l, t);
+
+				if (get_height(t) <= get_height(ll) + 1) return l;
+
+				rotate_right(t);
+				return rotate_left(static_cast<node_type*>(l));
 			}
-			else
+
+			base_node_type* t = join_right(c, k, r);
+			link(ll, l, t);
+
+			if (get_height(t) <= get_height(ll) + 1) return l;
+
+			return rotate_left(static_cast<node_type*>(l));
+		}
+
+		// mirror of join_right, h(r) > h(l) + 1
+		base_node_type* join_left(base_node_type* l, base_node_type* k, base_node_type* r) noexcept
+		{
+			base_node_type* rr = r->mp_Right;
+			base_node_type* c = r->mp_Left;
+
+			if (get_height(c) <= get_height(l) + 1)
 			{
-				parent->mp_Right = new_node;
+				node_type* t = link(l, k, c);
+				link(t, r, rr);
+
+				if (get_height(t) <= get_height(rr) + 1) return r;
+
+				rotate_left(t);
+				return rotate_right(static_cast<node_type*>(r));
 			}
 
-			++this->m_Size;
+			base_node_type* t = join_left(l, k, c);
+			link(t, r, rr);
 
-			// rebalance
-			rebalance_upward(static_cast<node_type*>(new_node->mp_Parent));
+			if (get_height(t) <= get_height(rr) + 1) return r;
 
-			return { new_node, true };
+			return rotate_right(static_cast<node_type*>(r));
+		}
+
+		join_piece DoJoin(join_piece l, base_node_type* k, join_piece r) noexcept
+		{
+			base_node_type* t = nullptr;
+
+			if (l.rank > r.rank + 1)
+				t = join_right(l.root, k, r.root);
+			else if (r.rank > l.rank + 1)
+				t = join_left(l.root, k, r.root);
+			else
+				t = link(l.root, k, r.root);
+
+			t->mp_Parent = nullptr;
+			return { t, get_height(t) };
 		}
- 
+
 		template<class U>
 		node_type* create_node(U&& v, base_node_type* parent)
 		{
@@ -298,7 +542,7 @@ namespace mstl {
 
 		node_type* rotate_left(node_type* n) noexcept {
 
-			node_type* new_root = static_cast<node_type*>(mstl::TreeRotateLeft<base_node_type>(n));
+			node_type* new_root = static_cast<node_type*>(this->DoRotateLeft(n));
 			update_height(n);
 			update_height(new_root);
 			return new_root;
@@ -306,17 +550,30 @@ namespace mstl {
 
 		node_type* rotate_right(node_type* n) noexcept {
 
-			node_type* new_root = static_cast<node_type*>(mstl::TreeRotateRight<base_node_type>(n));
+			node_type* new_root = static_cast<node_type*>(this->DoRotateRight(n));
 			update_height(n);
 			update_height(new_root);
 			return new_root;
 		}
 
-		void rebalance_upward(node_type* n) noexcept
+		/// Walks up towards the root (the header has no height, stop
+		/// there). Once a subtree is back to its old height nothing
+		/// above changes: stop, so an insert costs O(1) amortized past
+		/// the search. Subtree counts need the whole path.
+		void rebalance_upward(base_node_type* from) noexcept
 		{
-			for (node_type* p = n; p; p = static_cast<node_type*>(p->mp_Parent))
+			for (base_node_type* b = from; !mstl::TreeIsHeader(b); b = b->mp_Parent)
 			{
+				node_type* p = static_cast<node_type*>(b);
+				const int old_height = p->m_Height;
+
 				update_height(p);
+
+				if constexpr (base_type::has_order_statistics)
+				{
+					mstl::TreeUpdateCount<node_type>(p);
+				}
+
 				int bf = get_balance_factor(p);
 
 				// left heavy
@@ -329,14 +586,8 @@ namespace mstl {
 						rotate_left(left);
 					}
 
-					node_type* new_root = rotate_right(p);
-
-					if (!new_root->mp_Parent)
-					{
-						this->mp_Root = new_root;
-					}
-
-					p = new_root;
+					// a rotation at the root updates the header
+					b = rotate_right(p);
 				}
 				// right heavy
 				else if (bf < -1)
@@ -348,14 +599,12 @@ namespace mstl {
 						rotate_right(right);
 					}
 
-					node_type* new_root = rotate_left(p);
-
-					if (!new_root->mp_Parent)
-					{
-						this->mp_Root = new_root;
-					}
+					b = rotate_left(p);
+				}
 
-					p = new_root;
+				if constexpr (!base_type::has_order_statistics)
+				{
+					if (get_height(b) == old_height) break;
 				}
 			}
 		}
@@ -364,19 +613,21 @@ namespace mstl {
 		{
 			if (!z) return;
 
+			this->DoDetachExtremes(z);
+
 			node_type* node_to_remove = static_cast<node_type*>(z);
-			node_type* rebalance_from = nullptr;
+			base_node_type* rebalance_from = nullptr;
 
 			// case 1 child or no children
 			if (!node_to_remove->mp_Left)
 			{
-				rebalance_from = static_cast<node_type*>(node_to_remove->mp_Parent);
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_remove, node_to_remove->mp_Right);
+				rebalance_from = node_to_remove->mp_Parent;
+				mstl::TreeTransplant<base_node_type>(node_to_remove, node_to_remove->mp_Right);
 			}
 			else if (!node_to_remove->mp_Right)
 			{
-				rebalance_from = static_cast<node_type*>(node_to_remove->mp_Parent);
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_remove, node_to_remove->mp_Left);
+				rebalance_from = node_to_remove->mp_Parent;
+				mstl::TreeTransplant<base_node_type>(node_to_remove, node_to_remove->mp_Left);
 			}
 			else
 			{
@@ -390,7 +641,7 @@ namespace mstl {
 				}
 				else
 				{
-					rebalance_from = static_cast<node_type*>(s->mp_Parent);
+					rebalance_from = s->mp_Parent;
 				}
 
 				if (s->mp_Parent != node_to_remove)
@@ -399,7 +650,7 @@ namespace mstl {
 					// replace s with its right child
 					// successor can't have left child
 					// otherwise it wouldn't be the successor
-					mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, s, s->mp_Right);
+					mstl::TreeTransplant<base_node_type>(s, s->mp_Right);
 
 					// transfer z right subtree to s right subtree
 					// s doesn't have left child for now 
@@ -411,13 +662,15 @@ namespace mstl {
 					s->mp_Right->mp_Parent = s;
 				}
 
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_remove, s);
+				mstl::TreeTransplant<base_node_type>(node_to_remove, s);
 
 				s->mp_Left = node_to_remove->mp_Left;
 				if (s->mp_Left)
 					s->mp_Left->mp_Parent = s;
 
-				update_height(s);
+				// s takes the old height of z position: rebalance_upward
+				// stops as soon as a height is unchanged
+				s->m_Height = node_to_remove->m_Height;
 			}
 
 			this->DoDestroyNode(node_to_remove);
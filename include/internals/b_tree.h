@@ -0,0 +1,1113 @@
+#ifndef MSTL_B_TREE_H
+#define MSTL_B_TREE_H
+
+#include "tree.h"
+#include <new>
+#include <cstdint>
+#include <algorithm>
+#include <initializer_list>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// B-tree node
+	/// ---------------------------------------------------------------
+	/// Every node keeps up to N values in sorted order; internal
+	/// nodes add N + 1 child pointers. Leaves (the vast majority of
+	/// nodes) don't pay for the child array.
+	///
+	/// Values live in raw storage and are relocated (move construct
+	/// + destroy) when shifted, so pair<const K, V> works as well.
+
+	template<typename V, std::size_t N>
+	struct btree_node {
+
+		using value_type = V;
+
+		static constexpr std::size_t capacity = N;
+
+		btree_node*   mp_Parent{};
+		std::uint16_t m_Position{};   // index in the parent's children
+		std::uint16_t m_Count{};      // values in use
+		bool          m_Leaf{ true };
+
+		alignas(V) unsigned char m_Storage[N * sizeof(V)];
+
+		V* values() noexcept { return std::launder(reinterpret_cast<V*>(m_Storage)); }
+		const V* values() const noexcept { return std::launder(reinterpret_cast<const V*>(m_Storage)); }
+
+		V& value(std::size_t i) noexcept { return values()[i]; }
+		const V& value(std::size_t i) const noexcept { return values()[i]; }
+
+		btree_node*& child(std::size_t i) noexcept;
+		btree_node* child(std::size_t i) const noexcept;
+	};
+
+	template<typename V, std::size_t N>
+	struct btree_internal_node : btree_node<V, N> {
+
+		btree_node<V, N>* mp_Children[N + 1]{};
+	};
+
+	template<typename V, std::size_t N>
+	inline btree_node<V, N>*& btree_node<V, N>::child(std::size_t i) noexcept {
+		return static_cast<btree_internal_node<V, N>*>(this)->mp_Children[i];
+	}
+
+	template<typename V, std::size_t N>
+	inline btree_node<V, N>* btree_node<V, N>::child(std::size_t i) const noexcept {
+		return static_cast<const btree_internal_node<V, N>*>(this)->mp_Children[i];
+	}
+
+	/// Values per node so that a leaf fills CacheLines cache lines
+	/// (at least 3, a B-tree of order 2 would just be a slow bst)
+	template<typename V, std::size_t CacheLines>
+	inline constexpr std::size_t btree_node_values = [] {
+		constexpr std::size_t header = 2 * sizeof(void*);
+		constexpr std::size_t bytes = CacheLines * 64;
+		constexpr std::size_t n = bytes > header ? (bytes - header) / sizeof(V) : 0;
+		return n < 3 ? std::size_t{ 3 } : (n > 0xFFFF ? std::size_t{ 0xFFFF } : n);
+	}();
+
+	/// ---------------------------------------------------------------
+	/// B-tree iterator
+	/// ---------------------------------------------------------------
+	/// (node, position) pair. end() is one past the last value of the
+	/// rightmost leaf, so --end() is O(1). Inserting or erasing
+	/// invalidates every iterator (values move between nodes).
+
+	template<typename node_t, bool IsConst>
+	class btree_iterator {
+
+		using node_type = node_t;
+
+		node_type* mp_Node{};
+		std::size_t m_Pos{};
+
+	public:
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type        = typename node_t::value_type;
+		using difference_type   = std::ptrdiff_t;
+		using reference         = std::conditional_t<IsConst, const value_type&, value_type&>;
+		using pointer           = std::conditional_t<IsConst, const value_type*, value_type*>;
+
+		btree_iterator() = default;
+
+		btree_iterator(node_type* n, std::size_t pos) noexcept : mp_Node{ n }, m_Pos{ pos } {}
+
+		template<bool C = IsConst, typename = std::enable_if_t<C>>
+		btree_iterator(const btree_iterator<node_t, false>& other) noexcept
+			: mp_Node{ other.mp_Node }, m_Pos{ other.m_Pos } {
+		}
+
+		reference operator*()  const { return mp_Node->value(m_Pos); }
+		pointer   operator->() const { return std::addressof(mp_Node->value(m_Pos)); }
+
+		friend bool operator==(const btree_iterator& a, const btree_iterator& b) {
+			return a.mp_Node == b.mp_Node && a.m_Pos == b.m_Pos;
+		}
+		friend bool operator!=(const btree_iterator& a, const btree_iterator& b) { return !(a == b); }
+
+		btree_iterator& operator++() noexcept {
+
+			if (!mp_Node->m_Leaf)
+			{
+				// leftmost value of the right subtree
+				mp_Node = mp_Node->child(m_Pos + 1);
+				while (!mp_Node->m_Leaf) mp_Node = mp_Node->child(0);
+				m_Pos = 0;
+				return *this;
+			}
+
+			if (++m_Pos < mp_Node->m_Count) return *this;
+
+			// past the leaf: first ancestor with a value on the right,
+			// none means we were on the last value (stay on end())
+			node_type* n = mp_Node;
+			std::size_t pos = m_Pos;
+
+			while (pos == n->m_Count && n->mp_Parent)
+			{
+				pos = n->m_Position;
+				n = n->mp_Parent;
+			}
+
+			if (pos < n->m_Count)
+			{
+				mp_Node = n;
+				m_Pos = pos;
+			}
+
+			return *this;
+		}
+
+		btree_iterator operator++(int) noexcept {
+			btree_iterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		btree_iterator& operator--() noexcept {
+
+			if (!mp_Node->m_Leaf)
+			{
+				// rightmost value of the left subtree
+				mp_Node = mp_Node->child(m_Pos);
+				while (!mp_Node->m_Leaf) mp_Node = mp_Node->child(mp_Node->m_Count);
+				m_Pos = mp_Node->m_Count - 1u;
+				return *this;
+			}
+
+			if (m_Pos > 0)
+			{
+				--m_Pos;
+				return *this;
+			}
+
+			while (mp_Node->mp_Parent && mp_Node->m_Position == 0)
+				mp_Node = mp_Node->mp_Parent;
+
+			m_Pos = mp_Node->m_Position - 1u;
+			mp_Node = mp_Node->mp_Parent;
+			return *this;
+		}
+
+		btree_iterator operator--(int) noexcept {
+			btree_iterator tmp = *this;
+			--(*this);
+			return tmp;
+		}
+
+	private:
+
+		template<typename T, typename KeyOfValue, typename Compare, typename A, std::size_t CacheLines>
+		friend class btree;
+
+		template<typename, bool>
+		friend class btree_iterator;
+	};
+
+	/// ---------------------------------------------------------------
+	/// B-tree
+	/// ---------------------------------------------------------------
+	/// Ordered unique container with many values per node: a lookup
+	/// touches log_B(n) nodes, each a few adjacent cache lines,
+	/// instead of log_2(n) scattered rb nodes.
+	///
+	/// Same KeyOfValue / compare / allocator parameters and the same
+	/// public interface as rb_tree (ctors, insert, emplace, erase,
+	/// lookups, iterators), so it can back map-like wrappers.
+	///
+	/// Invariants (N = values per node, m = (N - 1) / 2):
+	/// 1. All leaves are at the same depth.
+	/// 2. Every node but the root holds m..N values.
+	/// 3. An internal node with k values has k + 1 children and the
+	///    values of child i are between value i - 1 and value i.
+	///
+	/// [!] values are relocated inside and between nodes: a move (or,
+	///     for const keys, copy) constructor throwing during a split or
+	///     a merge is not recovered from. Use nothrow relocatable values.
+	/// ---------------------------------------------------------------
+
+	template<
+		typename T,
+		typename KeyOfValue = identity_key<T>,
+		typename compare = std::less<std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>>,
+		typename A = std::allocator<T>,
+		std::size_t CacheLines = 4
+	>
+	class btree {
+
+	public:
+
+		using value_type      = T;
+		using key_type        = std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>;
+		using key_compare     = compare;
+		using value_compare   = key_compare;
+		using alloc_type      = A;
+		using alloc_traits    = std::allocator_traits<A>;
+		using size_type       = typename alloc_traits::size_type;
+		using difference_type = std::ptrdiff_t;
+
+		static constexpr std::size_t node_values = btree_node_values<T, CacheLines>;
+
+		using node_type     = btree_node<T, node_values>;
+		using internal_type = btree_internal_node<T, node_values>;
+
+		using iterator       = btree_iterator<node_type, false>;
+		using const_iterator = btree_iterator<node_type, true>;
+
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	private:
+
+		using leaf_alloc      = typename alloc_traits::template rebind_alloc<node_type>;
+		using leaf_traits     = std::allocator_traits<leaf_alloc>;
+		using internal_alloc  = typename alloc_traits::template rebind_alloc<internal_type>;
+		using internal_traits = std::allocator_traits<internal_alloc>;
+
+		static constexpr std::size_t min_values = (node_values - 1) / 2;
+
+		[[no_unique_address]] alloc_type     m_ValueAlloc{};
+		[[no_unique_address]] leaf_alloc     m_LeafAlloc{ m_ValueAlloc };
+		[[no_unique_address]] internal_alloc m_InternalAlloc{ m_ValueAlloc };
+		[[no_unique_address]] key_compare    m_Comp{};
+		[[no_unique_address]] KeyOfValue     m_KeyExtractor{};
+
+		node_type* mp_Root{};
+		node_type* mp_Leftmost{};    // begin()
+		node_type* mp_Rightmost{};   // end() is (mp_Rightmost, count)
+		size_type  m_Size{};
+
+	public:
+
+		// ================= Ctors =================
+
+		explicit btree(const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: m_ValueAlloc{ a }
+			, m_LeafAlloc{ m_ValueAlloc }
+			, m_InternalAlloc{ m_ValueAlloc }
+			, m_Comp{ c } {
+		}
+
+		template<std::input_iterator It>
+		btree(It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: btree(a, c)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		btree(std::initializer_list<T> il, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: btree(il.begin(), il.end(), a, c) {
+		}
+
+		// sorted input always appends to the rightmost leaf: every
+		// insert is a single node search, no full descent
+		template<std::input_iterator It>
+		btree(sorted_unique_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: btree(a, c)
+		{
+			for (; first != last; ++first)
+				append_back(*first);
+		}
+
+		// ============= Copy semantics =================
+
+		// node by node clone: same shape, no comparison
+		btree(const btree& other)
+			: btree(alloc_traits::select_on_container_copy_construction(other.m_ValueAlloc), other.m_Comp)
+		{
+			if (!other.mp_Root) return;
+
+			mp_Root = clone_rec(other.mp_Root, nullptr);
+			m_Size = other.m_Size;
+
+			mp_Leftmost = mp_Root;
+			while (!mp_Leftmost->m_Leaf) mp_Leftmost = mp_Leftmost->child(0);
+
+			mp_Rightmost = mp_Root;
+			while (!mp_Rightmost->m_Leaf) mp_Rightmost = mp_Rightmost->child(mp_Rightmost->m_Count);
+		}
+
+		btree& operator=(const btree& other)
+		{
+			if (this == &other) return *this;
+			btree tmp(other);
+			swap(tmp);
+			return *this;
+		}
+
+		// ============= Move semantics =================
+
+		btree(btree&& other) noexcept
+			: m_ValueAlloc{ std::move(other.m_ValueAlloc) }
+			, m_LeafAlloc{ m_ValueAlloc }
+			, m_InternalAlloc{ m_ValueAlloc }
+			, m_Comp{ std::move(other.m_Comp) }
+			, m_KeyExtractor{ std::move(other.m_KeyExtractor) }
+			, mp_Root{ std::exchange(other.mp_Root, nullptr) }
+			, mp_Leftmost{ std::exchange(other.mp_Leftmost, nullptr) }
+			, mp_Rightmost{ std::exchange(other.mp_Rightmost, nullptr) }
+			, m_Size{ std::exchange(other.m_Size, 0) } {
+		}
+
+		btree& operator=(btree&& other) noexcept
+		{
+			if (this != &other) swap(other);
+			return *this;
+		}
+
+		~btree() { clear(); }
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return iterator{ mp_Leftmost, 0 }; }
+		const_iterator begin() const noexcept { return const_iterator{ mp_Leftmost, 0 }; }
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		iterator end() noexcept { return iterator{ mp_Rightmost, mp_Rightmost ? mp_Rightmost->m_Count : 0u }; }
+		const_iterator end() const noexcept { return const_iterator{ mp_Rightmost, mp_Rightmost ? mp_Rightmost->m_Count : 0u }; }
+		const_iterator cend() const noexcept { return end(); }
+
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return rend(); }
+
+		// ================= Capacity =================
+
+		size_type size() const noexcept { return m_Size; }
+
+		bool empty() const noexcept { return m_Size == 0; }
+
+		// ================= Lookups =================
+
+		iterator find(const key_type& key) noexcept {
+			auto [n, i] = find_pos(key);
+			return n ? iterator{ n, i } : end();
+		}
+
+		const_iterator find(const key_type& key) const noexcept {
+			auto [n, i] = find_pos(key);
+			return n ? const_iterator{ n, i } : end();
+		}
+
+		bool contains(const key_type& key) const noexcept {
+			return find_pos(key).first != nullptr;
+		}
+
+		iterator lower_bound(const key_type& key) noexcept {
+			return bound<false, iterator>(key);
+		}
+
+		const_iterator lower_bound(const key_type& key) const noexcept {
+			return const_cast<btree*>(this)->template bound<false, iterator>(key);
+		}
+
+		iterator upper_bound(const key_type& key) noexcept {
+			return bound<true, iterator>(key);
+		}
+
+		const_iterator upper_bound(const key_type& key) const noexcept {
+			return const_cast<btree*>(this)->template bound<true, iterator>(key);
+		}
+
+		std::pair<iterator, iterator> equal_range(const key_type& key) noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ================= Modifiers =================
+
+		void clear() noexcept
+		{
+			if (mp_Root) destroy_rec(mp_Root);
+			mp_Root = mp_Leftmost = mp_Rightmost = nullptr;
+			m_Size = 0;
+		}
+
+		template<typename U>
+		std::pair<iterator, bool> insert(U&& v)
+		{
+			if constexpr (std::is_same_v<std::remove_cvref_t<U>, value_type>)
+			{
+				return insert_impl(std::forward<U>(v));
+			}
+			else
+			{
+				// convertible input (e.g. pair<K, V> for pair<const K, V>):
+				// build the value first, the key must outlive the search
+				return insert_impl(value_type(std::forward<U>(v)));
+			}
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			value_type temp(std::forward<Args>(args)...);
+			return insert_impl(std::move(temp));
+		}
+
+		// lookup first: the value is built from args only for a new
+		// key (try_emplace, operator[])
+		template<class... Args>
+		std::pair<iterator, bool> emplace_if_absent(const key_type& key, Args&&... args)
+		{
+			if (!mp_Root) return { insert_first(std::forward<Args>(args)...), true };
+
+			node_type* n = mp_Root;
+
+			for (;;)
+			{
+				const size_type i = lower_index(n, key);
+
+				if (i < n->m_Count && !m_Comp(key, key_of(n->value(i))))
+					return { iterator{ n, i }, false };
+
+				if (n->m_Leaf) return { insert_leaf(n, i, std::forward<Args>(args)...), true };
+
+				n = n->child(i);
+			}
+		}
+
+		// erase by key
+		size_type erase(const key_type& key)
+		{
+			auto [n, i] = find_pos(key);
+			if (!n) return 0;
+
+			iterator none{};
+			erase_at(n, i, none);
+			return 1;
+		}
+
+		// erase by iterator -> returns successor
+		iterator erase(const_iterator pos)
+		{
+			if (pos == cend()) return end();
+
+			iterator next{ pos.mp_Node, pos.m_Pos };
+			++next;
+
+			const bool last = next == end();
+
+			// the successor may move while rebalancing: erase_at tracks it
+			erase_at(pos.mp_Node, pos.m_Pos, next);
+
+			return last ? end() : next;
+		}
+
+		void swap(btree& other) noexcept
+		{
+			using std::swap;
+			swap(m_ValueAlloc, other.m_ValueAlloc);
+			swap(m_LeafAlloc, other.m_LeafAlloc);
+			swap(m_InternalAlloc, other.m_InternalAlloc);
+			swap(m_Comp, other.m_Comp);
+			swap(m_KeyExtractor, other.m_KeyExtractor);
+			swap(mp_Root, other.mp_Root);
+			swap(mp_Leftmost, other.mp_Leftmost);
+			swap(mp_Rightmost, other.mp_Rightmost);
+			swap(m_Size, other.m_Size);
+		}
+
+		// ================= Observers =================
+
+		const node_type* root() const noexcept { return mp_Root; }
+
+		key_compare key_comp() const { return m_Comp; }
+
+		alloc_type get_allocator() const { return m_ValueAlloc; }
+
+		// ================= Utility =================
+
+		// checks the invariants above, plus parent links and size
+		bool verify() const noexcept
+		{
+			if (!mp_Root) return m_Size == 0 && !mp_Leftmost && !mp_Rightmost;
+			if (mp_Root->mp_Parent) return false;
+
+			int leaf_depth = -1;
+			size_type count = 0;
+
+			if (!verify_rec(mp_Root, nullptr, nullptr, 0, leaf_depth, count)) return false;
+			if (count != m_Size) return false;
+
+			const node_type* l = mp_Root;
+			while (!l->m_Leaf) l = l->child(0);
+			const node_type* r = mp_Root;
+			while (!r->m_Leaf) r = r->child(r->m_Count);
+
+			return l == mp_Leftmost && r == mp_Rightmost;
+		}
+
+	private:
+
+		// ================= Helpers =================
+
+		const key_type& key_of(const value_type& v) const noexcept { return m_KeyExtractor(v); }
+
+		// first index in n whose key is not less than key
+		size_type lower_index(const node_type* n, const key_type& key) const noexcept
+		{
+			size_type lo = 0;
+			size_type hi = n->m_Count;
+
+			while (lo < hi)
+			{
+				const size_type mid = (lo + hi) / 2;
+				if (m_Comp(key_of(n->value(mid)), key)) lo = mid + 1;
+				else hi = mid;
+			}
+
+			return lo;
+		}
+
+		// first index in n whose key is greater than key
+		size_type upper_index(const node_type* n, const key_type& key) const noexcept
+		{
+			size_type lo = 0;
+			size_type hi = n->m_Count;
+
+			while (lo < hi)
+			{
+				const size_type mid = (lo + hi) / 2;
+				if (!m_Comp(key, key_of(n->value(mid)))) lo = mid + 1;
+				else hi = mid;
+			}
+
+			return lo;
+		}
+
+		std::pair<node_type*, size_type> find_pos(const key_type& key) const noexcept
+		{
+			node_type* n = mp_Root;
+
+			while (n)
+			{
+				const size_type i = lower_index(n, key);
+
+				if (i < n->m_Count && !m_Comp(key, key_of(n->value(i))))
+					return { n, i };
+
+				n = n->m_Leaf ? nullptr : n->child(i);
+			}
+
+			return { nullptr, 0 };
+		}
+
+		/// Descends once: the bound is in the leaf reached, or else it is
+		/// the deepest ancestor value seen on the right of the path.
+		template<bool Upper, typename It>
+		It bound(const key_type& key) noexcept
+		{
+			It result = end();
+			node_type* n = mp_Root;
+
+			while (n)
+			{
+				const size_type i = Upper ? upper_index(n, key) : lower_index(n, key);
+
+				if (i < n->m_Count) result = It{ n, i };
+
+				n = n->m_Leaf ? nullptr : n->child(i);
+			}
+
+			return result;
+		}
+
+		// ================= Node lifecycle =================
+
+		node_type* create_leaf()
+		{
+			// default-init: the value storage stays untouched
+			node_type* n = leaf_traits::allocate(m_LeafAlloc, 1);
+			::new (static_cast<void*>(n)) node_type;
+			return n;
+		}
+
+		node_type* create_internal()
+		{
+			internal_type* n = internal_traits::allocate(m_InternalAlloc, 1);
+			::new (static_cast<void*>(n)) internal_type;
+			n->m_Leaf = false;
+			return n;
+		}
+
+		// frees the node only, values must be gone already
+		void free_node(node_type* n) noexcept
+		{
+			if (n->m_Leaf)
+			{
+				n->~node_type();
+				leaf_traits::deallocate(m_LeafAlloc, n, 1);
+			}
+			else
+			{
+				internal_type* in = static_cast<internal_type*>(n);
+				in->~internal_type();
+				internal_traits::deallocate(m_InternalAlloc, in, 1);
+			}
+		}
+
+		void destroy_rec(node_type* n) noexcept
+		{
+			if (!n->m_Leaf)
+			{
+				for (size_type i = 0; i <= n->m_Count; ++i)
+					if (n->child(i)) destroy_rec(n->child(i));
+			}
+
+			for (size_type i = 0; i < n->m_Count; ++i)
+				alloc_traits::destroy(m_ValueAlloc, std::addressof(n->value(i)));
+
+			free_node(n);
+		}
+
+		node_type* clone_rec(const node_type* src, node_type* parent)
+		{
+			node_type* n = src->m_Leaf ? create_leaf() : create_internal();
+			n->mp_Parent = parent;
+			n->m_Position = src->m_Position;
+
+			try {
+
+				for (size_type i = 0; i < src->m_Count; ++i)
+				{
+					alloc_traits::construct(m_ValueAlloc, std::addressof(n->value(i)), src->value(i));
+					++n->m_Count;
+				}
+
+				if (!src->m_Leaf)
+				{
+					for (size_type i = 0; i <= src->m_Count; ++i)
+						n->child(i) = clone_rec(src->child(i), n);
+				}
+			}
+			catch (...)
+			{
+				// children not cloned yet are still null
+				destroy_rec(n);
+				throw;
+			}
+
+			return n;
+		}
+
+		// ================= Relocation =================
+
+		void relocate(value_type* dst, value_type* src)
+		{
+			alloc_traits::construct(m_ValueAlloc, dst, std::move_if_noexcept(*src));
+			alloc_traits::destroy(m_ValueAlloc, src);
+		}
+
+		// moves values [first, count) one slot to the right
+		void shift_values_right(node_type* n, size_type first)
+		{
+			for (size_type j = n->m_Count; j > first; --j)
+				relocate(std::addressof(n->value(j)), std::addressof(n->value(j - 1)));
+		}
+
+		// moves values (first, count) one slot to the left
+		void shift_values_left(node_type* n, size_type first)
+		{
+			for (size_type j = first; j + 1 < n->m_Count; ++j)
+				relocate(std::addressof(n->value(j)), std::addressof(n->value(j + 1)));
+		}
+
+		static void set_child(node_type* n, size_type i, node_type* c) noexcept
+		{
+			n->child(i) = c;
+			c->mp_Parent = n;
+			c->m_Position = static_cast<std::uint16_t>(i);
+		}
+
+		// ================= Insertion =================
+
+		// the key of v is only read by the search, before v is moved
+		template<typename U>
+		std::pair<iterator, bool> insert_impl(U&& v)
+		{
+			return emplace_if_absent(key_of(v), std::forward<U>(v));
+		}
+
+		template<class... Args>
+		iterator insert_first(Args&&... args)
+		{
+			node_type* n = create_leaf();
+
+			try {
+				alloc_traits::construct(m_ValueAlloc, std::addressof(n->value(0)), std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				free_node(n);
+				throw;
+			}
+
+			n->m_Count = 1;
+			mp_Root = mp_Leftmost = mp_Rightmost = n;
+			m_Size = 1;
+
+			return iterator{ n, 0 };
+		}
+
+		// sorted construction: v goes after the current maximum
+		template<typename U>
+		void append_back(U&& v)
+		{
+			if (mp_Rightmost && !m_Comp(key_of(mp_Rightmost->value(mp_Rightmost->m_Count - 1u)), key_of(v)))
+			{
+				// not strictly increasing: fall back to a regular insert
+				insert(std::forward<U>(v));
+				return;
+			}
+
+			if (!mp_Root)
+			{
+				insert_first(std::forward<U>(v));
+				return;
+			}
+
+			insert_leaf(mp_Rightmost, mp_Rightmost->m_Count, std::forward<U>(v));
+		}
+
+		template<class... Args>
+		iterator insert_leaf(node_type* n, size_type i, Args&&... args)
+		{
+			if (n->m_Count == node_values) split(n, i);
+
+			shift_values_right(n, i);
+
+			try {
+				alloc_traits::construct(m_ValueAlloc, std::addressof(n->value(i)), std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				++n->m_Count;
+				shift_values_left(n, i);
+				--n->m_Count;
+				throw;
+			}
+
+			++n->m_Count;
+			++m_Size;
+
+			return iterator{ n, i };
+		}
+
+		/// Splits the full node n around its median: the upper half goes
+		/// to a new right sibling and the median moves up to the parent
+		/// (split first if full, the root grows a new level).
+		/// (n, i) is updated to where a value meant for slot i goes.
+		void split(node_type*& n, size_type& i)
+		{
+			if (n->mp_Parent && n->mp_Parent->m_Count == node_values)
+			{
+				size_type unused = n->m_Position;
+				node_type* p = n->mp_Parent;
+				split(p, unused);
+			}
+
+			node_type* r = n->m_Leaf ? create_leaf() : create_internal();
+
+			if (!n->mp_Parent)
+			{
+				node_type* root = nullptr;
+
+				try {
+					root = create_internal();
+				}
+				catch (...)
+				{
+					free_node(r);
+					throw;
+				}
+
+				set_child(root, 0, n);
+				mp_Root = root;
+			}
+
+			node_type* p = n->mp_Parent;
+			const size_type k = n->m_Position;
+			const size_type mid = node_values / 2;
+
+			// upper half -> r
+			for (size_type j = mid + 1; j < node_values; ++j)
+				relocate(std::addressof(r->value(j - mid - 1)), std::addressof(n->value(j)));
+
+			if (!n->m_Leaf)
+			{
+				for (size_type j = mid + 1; j <= node_values; ++j)
+					set_child(r, j - mid - 1, n->child(j));
+			}
+
+			r->m_Count = static_cast<std::uint16_t>(node_values - mid - 1);
+
+			// median -> parent slot k, r becomes child k + 1
+			for (size_type j = p->m_Count; j > k; --j)
+				set_child(p, j + 1, p->child(j));
+
+			shift_values_right(p, k);
+			relocate(std::addressof(p->value(k)), std::addressof(n->value(mid)));
+			set_child(p, k + 1, r);
+			++p->m_Count;
+
+			n->m_Count = static_cast<std::uint16_t>(mid);
+
+			if (n == mp_Rightmost) mp_Rightmost = r;
+
+			if (i > mid)
+			{
+				i -= mid + 1;
+				n = r;
+			}
+		}
+
+		// ================= Erase =================
+
+		// moves the tracked iterator when the value it points to moves
+		static void retarget(iterator& track, node_type* from, size_type from_pos, node_type* to, size_type to_pos) noexcept
+		{
+			if (track.mp_Node == from && track.m_Pos == from_pos)
+			{
+				track.mp_Node = to;
+				track.m_Pos = to_pos;
+			}
+		}
+
+		/// Removes the value at (n, i). Values of internal nodes are
+		/// replaced by their predecessor (always in a leaf), then the
+		/// leaf is refilled from a sibling or merged with it, going up
+		/// as long as nodes underflow.
+		/// track follows the value it points to across the moves.
+		void erase_at(node_type* n, size_type i, iterator& track)
+		{
+			alloc_traits::destroy(m_ValueAlloc, std::addressof(n->value(i)));
+
+			if (!n->m_Leaf)
+			{
+				node_type* leaf = n->child(i);
+				while (!leaf->m_Leaf) leaf = leaf->child(leaf->m_Count);
+
+				const size_type last = leaf->m_Count - 1u;
+				relocate(std::addressof(n->value(i)), std::addressof(leaf->value(last)));
+				retarget(track, leaf, last, n, i);
+
+				n = leaf;
+				i = last;
+			}
+			else
+			{
+				// the hole is filled from the right
+				for (size_type j = i + 1; j < n->m_Count; ++j)
+				{
+					relocate(std::addressof(n->value(j - 1)), std::addressof(n->value(j)));
+					retarget(track, n, j, n, j - 1);
+				}
+			}
+
+			--n->m_Count;
+			--m_Size;
+
+			rebalance(n, track);
+		}
+
+		void rebalance(node_type* n, iterator& track)
+		{
+			while (n != mp_Root && n->m_Count < min_values)
+			{
+				node_type* p = n->mp_Parent;
+				const size_type k = n->m_Position;
+
+				node_type* left = k > 0 ? p->child(k - 1) : nullptr;
+				node_type* right = k < p->m_Count ? p->child(k + 1) : nullptr;
+
+				if (left && left->m_Count > min_values)
+				{
+					borrow_from_left(p, k, track);
+					return;
+				}
+
+				if (right && right->m_Count > min_values)
+				{
+					borrow_from_right(p, k, track);
+					return;
+				}
+
+				merge_children(p, left ? k - 1 : k, track);
+				n = p;
+			}
+
+			if (mp_Root->m_Count == 0)
+			{
+				node_type* old = mp_Root;
+
+				if (old->m_Leaf)
+				{
+					mp_Root = mp_Leftmost = mp_Rightmost = nullptr;
+				}
+				else
+				{
+					mp_Root = old->child(0);
+					mp_Root->mp_Parent = nullptr;
+					mp_Root->m_Position = 0;
+				}
+
+				free_node(old);
+			}
+		}
+
+		// parent value k - 1 comes down into child k,
+		// the last value of child k - 1 goes up in its place
+		void borrow_from_left(node_type* p, size_type k, iterator& track)
+		{
+			node_type* n = p->child(k);
+			node_type* left = p->child(k - 1);
+
+			for (size_type j = n->m_Count; j > 0; --j)
+			{
+				relocate(std::addressof(n->value(j)), std::addressof(n->value(j - 1)));
+				retarget(track, n, j - 1, n, j);
+			}
+
+			if (!n->m_Leaf)
+			{
+				for (size_type j = n->m_Count + 1u; j > 0; --j)
+					set_child(n, j, n->child(j - 1));
+				set_child(n, 0, left->child(left->m_Count));
+			}
+
+			relocate(std::addressof(n->value(0)), std::addressof(p->value(k - 1)));
+			retarget(track, p, k - 1, n, 0);
+
+			const size_type last = left->m_Count - 1u;
+			relocate(std::addressof(p->value(k - 1)), std::addressof(left->value(last)));
+			retarget(track, left, last, p, k - 1);
+
+			--left->m_Count;
+			++n->m_Count;
+		}
+
+		// parent value k comes down at the end of child k,
+		// the first value of child k + 1 goes up in its place
+		void borrow_from_right(node_type* p, size_type k, iterator& track)
+		{
+			node_type* n = p->child(k);
+			node_type* right = p->child(k + 1);
+
+			relocate(std::addressof(n->value(n->m_Count)), std::addressof(p->value(k)));
+			retarget(track, p, k, n, n->m_Count);
+
+			relocate(std::addressof(p->value(k)), std::addressof(right->value(0)));
+			retarget(track, right, 0, p, k);
+
+			for (size_type j = 1; j < right->m_Count; ++j)
+			{
+				relocate(std::addressof(right->value(j - 1)), std::addressof(right->value(j)));
+				retarget(track, right, j, right, j - 1);
+			}
+
+			if (!n->m_Leaf)
+			{
+				set_child(n, n->m_Count + 1u, right->child(0));
+				for (size_type j = 1; j <= right->m_Count; ++j)
+					set_child(right, j - 1, right->child(j));
+			}
+
+			++n->m_Count;
+			--right->m_Count;
+		}
+
+		// child k + 1 and the parent value k are appended to child k
+		void merge_children(node_type* p, size_type k, iterator& track)
+		{
+			node_type* left = p->child(k);
+			node_type* right = p->child(k + 1);
+			const size_type base = left->m_Count;
+
+			relocate(std::addressof(left->value(base)), std::addressof(p->value(k)));
+			retarget(track, p, k, left, base);
+
+			for (size_type j = 0; j < right->m_Count; ++j)
+			{
+				relocate(std::addressof(left->value(base + 1 + j)), std::addressof(right->value(j)));
+				retarget(track, right, j, left, base + 1 + j);
+			}
+
+			if (!left->m_Leaf)
+			{
+				for (size_type j = 0; j <= right->m_Count; ++j)
+					set_child(left, base + 1 + j, right->child(j));
+			}
+
+			left->m_Count = static_cast<std::uint16_t>(base + 1 + right->m_Count);
+
+			// close the gap in the parent
+			for (size_type j = k + 1; j < p->m_Count; ++j)
+			{
+				relocate(std::addressof(p->value(j - 1)), std::addressof(p->value(j)));
+				retarget(track, p, j, p, j - 1);
+			}
+
+			for (size_type j = k + 2; j <= p->m_Count; ++j)
+				set_child(p, j - 1, p->child(j));
+
+			--p->m_Count;
+
+			if (right == mp_Rightmost) mp_Rightmost = left;
+
+			right->m_Count = 0;
+			free_node(right);
+		}
+
+		// ================= Verify =================
+
+		bool verify_rec(const node_type* n, const value_type* lo, const value_type* hi,
+			int depth, int& leaf_depth, size_type& count) const noexcept
+		{
+			if (n != mp_Root && n->m_Count < min_values) return false;
+			if (n->m_Count > node_values) return false;
+
+			for (size_type i = 0; i < n->m_Count; ++i)
+			{
+				const key_type& k = key_of(n->value(i));
+				if (i > 0 && !m_Comp(key_of(n->value(i - 1)), k)) return false;
+				if (lo && !m_Comp(key_of(*lo), k)) return false;
+				if (hi && !m_Comp(k, key_of(*hi))) return false;
+			}
+
+			count += n->m_Count;
+
+			if (n->m_Leaf)
+			{
+				if (leaf_depth < 0) leaf_depth = depth;
+				return leaf_depth == depth;
+			}
+
+			for (size_type i = 0; i <= n->m_Count; ++i)
+			{
+				const node_type* c = n->child(i);
+				if (!c || c->mp_Parent != n || c->m_Position != i) return false;
+
+				const value_type* clo = i > 0 ? std::addressof(n->value(i - 1)) : lo;
+				const value_type* chi = i < n->m_Count ? std::addressof(n->value(i)) : hi;
+
+				if (!verify_rec(c, clo, chi, depth + 1, leaf_depth, count)) return false;
+			}
+
+			return true;
+		}
+	};
+
+	template<typename T, typename K, typename C, typename A, std::size_t L>
+	bool operator==(const btree<T, K, C, A, L>& a, const btree<T, K, C, A, L>& b)
+	{
+		if (a.size() != b.size()) return false;
+		return std::equal(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template<typename T, typename K, typename C, typename A, std::size_t L>
+	bool operator!=(const btree<T, K, C, A, L>& a, const btree<T, K, C, A, L>& b)
+	{
+		return !(a == b);
+	}
+
+	template<typename T, typename K, typename C, typename A, std::size_t L>
+	void swap(btree<T, K, C, A, L>& a, btree<T, K, C, A, L>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // !MSTL_B_TREE_H
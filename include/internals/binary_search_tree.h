@@ -68,12 +68,22 @@ namespace mstl {
 				insert(v);
 		}
 
+		// [first, last) must be sorted by key and without duplicates:
+		// built bottom-up in O(n), see tree_base::DoBuildSorted
+		template<std::input_iterator It>
+		bst_tree(sorted_unique_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: base_type(a, c)
+		{
+			this->DoBuildSorted(first, last, [](node_type*, int, int) {});
+		}
+
 		// ============= Copy semantics =================
 
+		// node for node, same shape as other, see tree_base::DoCloneFrom
 		bst_tree(const bst_tree& other)
 			: base_type(other.m_ValueAlloc, other.m_Comp) {
 
-			for (const auto& v : other) insert(v);
+			this->DoCloneFrom(other, [](node_type*, const node_type*) {});
 		}
 
 		bst_tree& operator=(const bst_tree& other) {
@@ -87,7 +97,10 @@ namespace mstl {
 
 		// ============= Move semantics =================
 
-		bst_tree(const bst_tree&& other) noexcept {
+		// starts from a copy of other's allocator (a default
+		// constructed one may allocate), then takes the nodes
+		bst_tree(bst_tree&& other) noexcept
+			: base_type(other.m_ValueAlloc, other.m_Comp) {
 
 			swap(other);
 		}
@@ -124,20 +137,91 @@ namespace mstl {
 			return { iterator{ n }, ok };
 		}
 
+		// O(1) amortized when v goes right before or after hint,
+		// the usual descent otherwise (see DoHintPosition)
+		template<typename U>
+		iterator insert(const_iterator hint, U&& v) {
+
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->m_KeyExtractor(v), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+
+			if (pos.existing) return iterator{ pos.existing };
+
+			node_type* n = create_node(std::forward<U>(v), pos.parent);
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+
+			return iterator{ n };
+		}
+
+		// the value is built once, in the node: on a duplicate
+		// key the node is dropped
 		template<class... Args>
 		std::pair<iterator, bool> emplace(Args&&... args)
 		{
-			value_type temp(std::forward<Args>(args)...);
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
 
-			auto [n, ok] = insert_impl(std::move(temp));
+			auto pos = this->DoFindInsertPosition(this->DoKeyOf(n));
 
-			return { iterator{ n }, ok };
+			if (pos.existing)
+			{
+				this->DoDestroyNode(n);
+				return { iterator{ pos.existing }, false };
+			}
+
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+
+			return { iterator{ n }, true };
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->DoKeyOf(n), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->DoKeyOf(n));
+
+			if (pos.existing)
+			{
+				this->DoDestroyNode(n);
+				return iterator{ pos.existing };
+			}
+
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+
+			return iterator{ n };
+		}
+
+		// args build the value only when key is not here (try_emplace)
+		template<class... Args>
+		std::pair<iterator, bool> emplace_if_absent(const key_type& key, Args&&... args)
+		{
+			auto pos = this->DoFindInsertPosition(key);
+			if (pos.existing) return { iterator{ pos.existing }, false };
+
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+
+			return { iterator{ n }, true };
 		}
 
 		// erase by key
 		size_type erase(const key_type& key) {
 			
-			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->mp_Root, key, this->m_KeyExtractor, this->m_Comp);
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
+			if (!z) return 0;
+			erase_node(z);
+			return 1;
+		}
+
+		// transparent comparators only (see TransparentCompare)
+		template<typename K> requires base_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) {
+
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
 			if (!z) return 0;
 			erase_node(z);
 			return 1;
@@ -146,8 +230,8 @@ namespace mstl {
 		// erase by iterator -> returns successor
 		iterator erase(iterator pos) {
 			
-			base_node_type* z = pos.curr;
-			if (!z) return this->end();
+			base_node_type* z = this->DoIterNode(pos);
+			if (z == this->DoHeader()) return this->end();
 			base_node_type* s = mstl::TreeSuccessor<base_node_type>(z);
 			erase_node(z);
 			return iterator{ s };
@@ -155,23 +239,19 @@ namespace mstl {
 
 		void swap(bst_tree& other) noexcept {
 			using std::swap;
-			swap(this->m_ValueAlloc, other.m_ValueAlloc);
-			swap(this->m_NodeAlloc, other.m_NodeAlloc);
-			swap(this->m_Comp, other.m_Comp);
-			swap(this->m_Size, other.m_Size);
-			swap(this->mp_Root, other.mp_Root);
+			this->DoSwap(other);
 		}
 
 		// ================= Observers =================
 
-		const node_type* root() const noexcept { return this->mp_Root; }
+		const node_type* root() const noexcept { return this->DoRoot(); }
 
 		alloc_type get_allocator() const { return this->m_ValueAlloc; }
 
 		// ================= Utility =================
 
 		void inorder_print() const noexcept {
-			inorder_print_rec(this->mp_Root, nullptr, "root");
+			inorder_print_rec(this->DoRoot(), nullptr, "root");
 		}
 
 	private:
@@ -181,49 +261,17 @@ namespace mstl {
 		template<typename U>
 		std::pair<base_node_type*, bool> insert_impl(U&& v)
 		{
-			base_node_type* parent  = nullptr;
-			base_node_type* current = this->mp_Root;
+			// using comp on the keys, find a place
+			// where to insert the new node (or the duplicate)
+			auto pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+			if (pos.existing) return { pos.existing, false };
 
-			while (current)
-			{
-				parent = current;
+			node_type* n = create_node(std::forward<U>(v), pos.parent);
 
-				const value_type& val = static_cast<const node_type*>(current)->m_Val;
+			// link it (the header is the parent of the first node),
+			// tree_base keeps leftmost/rightmost and size
+			this->DoAttachNode(n, pos.parent, pos.as_left);
 
-				// using comp, find a place
-				// where to insert the new node
-				if (this->m_Comp(v, val))
-				{
-					current = current->mp_Left;
-				}
-				else if (this->m_Comp(val, v))
-				{
-					current = current->mp_Right;
-				}
-				else
-				{
-					// it's a duplicate
-					// return 
-					return { current, false };
-				}
-			}
-
-			node_type* n = create_node(std::forward<U>(v), parent);
-
-			if (!parent)
-			{
-				this->mp_Root = n;
-			}
-			else if (this->m_Comp(n->m_Val, static_cast<node_type*>(parent)->m_Val))
-			{
-				parent->mp_Left = n;
-			}
-			else 
-			{
-				parent->mp_Right = n;
-			}
-
-			++this->m_Size; 
 			return { n, true };
 		}
 
@@ -256,14 +304,16 @@ namespace mstl {
 		{
 			if (!z) return;
 
+			this->DoDetachExtremes(z);
+
 			// case 1,2
 			if (!z->mp_Left)
 			{
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, z, z->mp_Right); // if nullptr ok
+				mstl::TreeTransplant<base_node_type>(z, z->mp_Right); // if nullptr ok
 			}
 			else if (!z->mp_Right)
 			{
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, z, z->mp_Left);
+				mstl::TreeTransplant<base_node_type>(z, z->mp_Left);
 			}
 			else
 			{
@@ -282,7 +332,7 @@ namespace mstl {
 					// replace s with its right child
 					// successor can't have left child
 					// otherwise it wouldn't be the successor
-					mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, s, s->mp_Right);
+					mstl::TreeTransplant<base_node_type>(s, s->mp_Right);
 
 					// transfer z right subtree to s right subtree
 					// s doesn't have left child for now 
@@ -296,7 +346,7 @@ namespace mstl {
 
 				// now substitute z with successor
 				// and attach z left subtree to s
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, z, s);
+				mstl::TreeTransplant<base_node_type>(z, s);
 
 				s->mp_Left = z->mp_Left;
 				if (s->mp_Left)
@@ -0,0 +1,78 @@
+#ifndef MSTL_LINK_H
+#define MSTL_LINK_H
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// linkbase: the prev/succ pair of a circular doubly linked list
+	/// ---------------------------------------------------------------
+	/// Base of the list nodes (link<T>) and hook embedded in the
+	/// elements of an intrusive_list. A list is a ring closed by a
+	/// master linkbase, so no helper below deals with null.
+	/// Null prev/succ mean "not in a list" (intrusive hooks).
+
+	struct linkbase {
+
+		linkbase* prev{};
+		linkbase* succ{};
+	};
+
+	/// ---------------------------------------------------------------
+	/// Non-templated relinking helpers, shared by list and
+	/// intrusive_list
+	/// ---------------------------------------------------------------
+
+	// links n before pos
+	inline void ListLinkBefore(linkbase* pos, linkbase* n) noexcept {
+		n->succ = pos;
+		n->prev = pos->prev;
+		pos->prev->succ = n;
+		pos->prev = n;
+	}
+
+	// takes n out of its ring (n keeps its stale pointers)
+	inline void ListUnlink(linkbase* n) noexcept {
+		n->prev->succ = n->succ;
+		n->succ->prev = n->prev;
+	}
+
+	// moves [first, last) before pos (pos not inside the range),
+	// within a ring or from one ring to another
+	inline void ListTransfer(linkbase* pos, linkbase* first, linkbase* last) noexcept {
+
+		if (first == last || pos == last)
+			return;
+
+		linkbase* const lastIn = last->prev;
+
+		// detach
+		first->prev->succ = last;
+		last->prev = first->prev;
+
+		// attach before pos
+		first->prev = pos->prev;
+		lastIn->succ = pos;
+		pos->prev->succ = first;
+		pos->prev = lastIn;
+	}
+
+	// a master whose ring was moved elsewhere: fixes the neighbours
+	// that still point to the old master (from) to point to to
+	inline void ListAdoptRing(linkbase* to, linkbase* from) noexcept {
+
+		if (from->succ == from)
+		{
+			to->prev = to->succ = to;
+			return;
+		}
+
+		to->prev = from->prev;
+		to->succ = from->succ;
+		to->prev->succ = to;
+		to->succ->prev = to;
+
+		from->prev = from->succ = from;
+	}
+}
+
+#endif // !MSTL_LINK_H
@@ -0,0 +1,1079 @@
+#ifndef MSTL_PERSISTENT_TREE_H
+#define MSTL_PERSISTENT_TREE_H
+
+#include "red_black_tree.h"
+#include "relocate.h"
+#include "trace.h"
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Persistent node
+	/// ---------------------------------------------------------------
+	/// A node is shared by every version (tree or snapshot) reaching
+	/// it: m_Refs counts the links to it, from parent nodes and from
+	/// tree roots. There is no parent link, a shared node has one
+	/// parent per version.
+	///
+	/// A node reached from a root through nodes with m_Refs == 1 only
+	/// belongs to that version: it can be changed in place.
+
+	template<typename T>
+	struct persistent_node {
+
+		using value_type = T;
+
+		persistent_node* mp_Left{};
+		persistent_node* mp_Right{};
+		std::atomic<std::uint32_t> m_Refs{ 1 };
+		RBColor m_Color{ RBRed };
+
+		T m_Val;
+
+		template<class... Args>
+		explicit persistent_node(std::in_place_t, Args&&... args)
+			: m_Val(std::forward<Args>(args)...) {
+		}
+	};
+
+	// longest root to leaf path of the trees below: an RB tree is at
+	// most 2 * log2(n + 1) deep, and n stays under 2^47
+	inline constexpr int persistent_max_depth = 96;
+
+	/// ---------------------------------------------------------------
+	/// Persistent iterator
+	/// ---------------------------------------------------------------
+	/// Forward and const only: the values may be shared with other
+	/// versions. With no parent links the iterator carries the path
+	/// from the root to its node, up to persistent_max_depth pointers
+	/// (only the used part is copied).
+	///
+	/// Valid until the version it walks is modified or destroyed; the
+	/// nodes of an untouched snapshot never change.
+
+	template<typename node_t>
+	class persistent_iterator {
+
+		using node_type = node_t;
+
+		const node_type* mp_Path[persistent_max_depth];   // [0, m_Depth) is root .. current
+		int m_Depth{};                                     // 0 for end()
+
+	public:
+
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = typename node_t::value_type;
+		using difference_type   = std::ptrdiff_t;
+		using reference         = const value_type&;
+		using pointer           = const value_type*;
+
+		persistent_iterator() noexcept {}
+
+		persistent_iterator(const persistent_iterator& other) noexcept : m_Depth{ other.m_Depth } {
+			std::copy_n(other.mp_Path, m_Depth, mp_Path);
+		}
+
+		persistent_iterator& operator=(const persistent_iterator& other) noexcept {
+			m_Depth = other.m_Depth;
+			std::copy_n(other.mp_Path, m_Depth, mp_Path);
+			return *this;
+		}
+
+		reference operator*()  const { return mp_Path[m_Depth - 1]->m_Val; }
+		pointer   operator->() const { return std::addressof(mp_Path[m_Depth - 1]->m_Val); }
+
+		friend bool operator==(const persistent_iterator& a, const persistent_iterator& b) { return a.node() == b.node(); }
+		friend bool operator!=(const persistent_iterator& a, const persistent_iterator& b) { return !(a == b); }
+
+		persistent_iterator& operator++() noexcept {
+
+			const node_type* n = mp_Path[m_Depth - 1];
+
+			if (n->mp_Right)
+			{
+				push_leftmost(n->mp_Right);
+				return *this;
+			}
+
+			// up to the first ancestor reached from its left child
+			while (--m_Depth > 0 && mp_Path[m_Depth - 1]->mp_Right == mp_Path[m_Depth]) {}
+
+			return *this;
+		}
+
+		persistent_iterator operator++(int) noexcept {
+			persistent_iterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+	private:
+
+		template<typename T, typename KeyOfValue, typename Compare, typename A>
+		friend class persistent_rb_tree;
+
+		const node_type* node() const noexcept { return m_Depth ? mp_Path[m_Depth - 1] : nullptr; }
+
+		void push(const node_type* n) noexcept { mp_Path[m_Depth++] = n; }
+
+		void push_leftmost(const node_type* n) noexcept {
+			for (; n; n = n->mp_Left) push(n);
+		}
+	};
+
+	/// ---------------------------------------------------------------
+	/// Persistent RB Tree
+	/// ---------------------------------------------------------------
+	/// Red-black tree with path copying: a copy (snapshot()) shares
+	/// the root, O(1), and from then on each version copies what it
+	/// changes. An insert or erase copies the shared nodes on its path
+	/// plus the few ones its fixup recolors or rotates: O(log n) nodes,
+	/// the rest stays shared. A version not shared (no live snapshot)
+	/// updates in place, as a plain rb_tree.
+	///
+	/// Same invariants and fixup cases of rb_tree, run over the path
+	/// from the root (kept in an array) instead of parent links. All
+	/// that may throw comes first: the path and the nodes the fixup
+	/// will touch are made private (copies of shared nodes, same
+	/// values), then the new node is built; linking and rebalancing
+	/// can't fail. Strong guarantee for insert and erase.
+	///
+	/// Threads: reference counts are atomic, a snapshot can be read,
+	/// copied and destroyed on another thread while its origin keeps
+	/// changing. A single version is not synchronized (one writer, as
+	/// for any container), and the allocator must allow a node to be
+	/// freed from the thread dropping its last reference.
+	///
+	/// [!] values are immutable through iterators: a change goes
+	/// through the tree, which copies the shared path first.
+	/// ---------------------------------------------------------------
+
+	template<
+		typename T,
+		typename KeyOfValue = identity_key<T>,
+		typename compare = std::less<std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>>,
+		typename A = std::allocator<T>
+	>
+	class persistent_rb_tree {
+
+	public:
+
+		using value_type      = T;
+		using key_type        = std::remove_cvref_t<decltype(std::declval<KeyOfValue>()(std::declval<const T&>()))>;
+		using key_compare     = compare;
+		using value_compare   = key_compare;
+		using alloc_type      = A;
+		using alloc_traits    = std::allocator_traits<A>;
+		using size_type       = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using node_type = persistent_node<T>;
+
+		using iterator       = persistent_iterator<node_type>;
+		using const_iterator = iterator;
+
+		using trace = trace_hook_t<persistent_rb_tree>;   // null_trace unless MSTL_TRACE
+
+	private:
+
+		using node_alloc  = typename alloc_traits::template rebind_alloc<node_type>;
+		using node_traits = std::allocator_traits<node_alloc>;
+
+		// root .. node of a modifier, the entries made private on the way
+		using path_type = std::array<node_type*, persistent_max_depth>;
+
+		[[no_unique_address]] alloc_type  m_ValueAlloc{};
+		[[no_unique_address]] node_alloc  m_NodeAlloc{ m_ValueAlloc };
+		[[no_unique_address]] key_compare m_Comp{};
+		[[no_unique_address]] KeyOfValue  m_KeyExtractor{};
+
+		node_type* mp_Root{};
+		size_type  m_Size{};
+
+	public:
+
+		// ================= Ctors =================
+
+		explicit persistent_rb_tree(const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: m_ValueAlloc{ a }
+			, m_NodeAlloc{ m_ValueAlloc }
+			, m_Comp{ c } {
+		}
+
+		template<std::input_iterator It>
+		persistent_rb_tree(It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: persistent_rb_tree(a, c)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		persistent_rb_tree(std::initializer_list<T> il, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: persistent_rb_tree(il.begin(), il.end(), a, c) {
+		}
+
+		// ============= Copy semantics =================
+
+		// O(1): the nodes are shared, so is the allocator that frees
+		// them (no select_on_container_copy_construction)
+		persistent_rb_tree(const persistent_rb_tree& other)
+			: m_ValueAlloc{ other.m_ValueAlloc }
+			, m_NodeAlloc{ m_ValueAlloc }
+			, m_Comp{ other.m_Comp }
+			, m_KeyExtractor{ other.m_KeyExtractor }
+			, mp_Root{ retain(other.mp_Root) }
+			, m_Size{ other.m_Size } {
+		}
+
+		persistent_rb_tree& operator=(const persistent_rb_tree& other)
+		{
+			if (this == &other) return *this;
+
+			key_compare comp = other.m_Comp;
+			node_type* root = retain(other.mp_Root);
+			release(mp_Root);
+
+			m_ValueAlloc = other.m_ValueAlloc;
+			m_NodeAlloc = node_alloc{ m_ValueAlloc };
+			m_Comp = std::move(comp);
+			mp_Root = root;
+			m_Size = other.m_Size;
+			return *this;
+		}
+
+		// ============= Move semantics =================
+
+		persistent_rb_tree(persistent_rb_tree&& other) noexcept
+			: m_ValueAlloc{ std::move(other.m_ValueAlloc) }
+			, m_NodeAlloc{ m_ValueAlloc }
+			, m_Comp{ std::move(other.m_Comp) }
+			, m_KeyExtractor{ std::move(other.m_KeyExtractor) }
+			, mp_Root{ std::exchange(other.mp_Root, nullptr) }
+			, m_Size{ std::exchange(other.m_Size, 0) } {
+		}
+
+		persistent_rb_tree& operator=(persistent_rb_tree&& other) noexcept
+		{
+			if (this != &other) swap(other);
+			return *this;
+		}
+
+		~persistent_rb_tree() { release(mp_Root); }
+
+		// O(1) point-in-time copy, same as the copy constructor
+		persistent_rb_tree snapshot() const { return *this; }
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept
+		{
+			const_iterator it;
+			it.push_leftmost(mp_Root);
+			return it;
+		}
+
+		const_iterator end() const noexcept { return const_iterator{}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		// ================= Capacity =================
+
+		size_type size() const noexcept { return m_Size; }
+
+		bool empty() const noexcept { return m_Size == 0; }
+
+		static constexpr size_type max_size() noexcept { return (size_type{ 1 } << 47) - 1; }
+
+		// ================= Lookups =================
+
+		const_iterator find(const key_type& key) const noexcept { return find_path(key); }
+
+		bool contains(const key_type& key) const noexcept { return find_node(key) != nullptr; }
+
+		const_iterator lower_bound(const key_type& key) const noexcept { return bound_path<false>(key); }
+		const_iterator upper_bound(const key_type& key) const noexcept { return bound_path<true>(key); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ============== Heterogeneous lookups =================
+		// transparent comparators only, see TransparentCompare
+
+		template<typename K>
+		static constexpr bool is_heterogeneous_key = TransparentCompare<key_compare>
+			&& !std::is_convertible_v<const K&, const_iterator>;
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator find(const K& key) const noexcept { return find_path(key); }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		bool contains(const K& key) const noexcept { return find_node(key) != nullptr; }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator lower_bound(const K& key) const noexcept { return bound_path<false>(key); }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator upper_bound(const K& key) const noexcept { return bound_path<true>(key); }
+
+		template<typename K> requires TransparentCompare<key_compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ================= Modifiers =================
+
+		// drops this version's root: nodes still reached by a
+		// snapshot stay alive
+		void clear() noexcept
+		{
+			release(mp_Root);
+			mp_Root = nullptr;
+			m_Size = 0;
+		}
+
+		template<typename U>
+		std::pair<const_iterator, bool> insert(U&& v)
+		{
+			if constexpr (std::is_same_v<std::remove_cvref_t<U>, value_type>)
+			{
+				return emplace_if_absent(m_KeyExtractor(v), std::forward<U>(v));
+			}
+			else
+			{
+				// convertible input (e.g. pair<K, V> for pair<const K, V>):
+				// build the value first, the key must outlive the search
+				value_type tmp(std::forward<U>(v));
+				return emplace_if_absent(m_KeyExtractor(tmp), std::move(tmp));
+			}
+		}
+
+		// the value is built in its node, dropped on a duplicate key
+		template<class... Args>
+		std::pair<const_iterator, bool> emplace(Args&&... args)
+		{
+			node_type* x = create_node(std::forward<Args>(args)...);
+
+			position pos;
+			find_position(key_of(x), pos);
+
+			if (pos.found)
+			{
+				destroy_node(x);
+				return { path_iterator(pos.path, pos.depth), false };
+			}
+
+			try {
+				prepare_link(pos);
+			}
+			catch (...)
+			{
+				destroy_node(x);
+				throw;
+			}
+
+			return { link_node(pos, x), true };
+		}
+
+		// lookup first: the value is built from args only for a new
+		// key (try_emplace)
+		template<typename K, class... Args>
+		std::pair<const_iterator, bool> emplace_if_absent(const K& key, Args&&... args)
+		{
+			position pos;
+			find_position(key, pos);
+
+			if (pos.found) return { path_iterator(pos.path, pos.depth), false };
+
+			prepare_link(pos);
+
+			node_type* x = create_node(std::forward<Args>(args)...);
+			return { link_node(pos, x), true };
+		}
+
+		/// One search for insert_or_assign: an existing value is made
+		/// private to this version (the shared nodes on its path are
+		/// copied) and passed to assign, which must keep its key; a
+		/// missing key gets a value built from args.
+		template<typename K, typename Assign, class... Args>
+		std::pair<const_iterator, bool> assign_or_emplace(const K& key, Assign&& assign, Args&&... args)
+		{
+			position pos;
+			find_position(key, pos);
+
+			if (pos.found)
+			{
+				make_path_private(pos.path, pos.depth);
+				assign(pos.path[pos.depth - 1]->m_Val);
+				return { path_iterator(pos.path, pos.depth), false };
+			}
+
+			prepare_link(pos);
+
+			node_type* x = create_node(std::forward<Args>(args)...);
+			return { link_node(pos, x), true };
+		}
+
+		size_type erase(const key_type& key) { return erase_key(key); }
+
+		template<typename K> requires is_heterogeneous_key<K>
+		size_type erase(const K& key) { return erase_key(key); }
+
+		void swap(persistent_rb_tree& other) noexcept
+		{
+			using std::swap;
+
+			swap(m_ValueAlloc, other.m_ValueAlloc);
+			m_NodeAlloc = node_alloc{ m_ValueAlloc };
+			other.m_NodeAlloc = node_alloc{ other.m_ValueAlloc };
+
+			swap(m_Comp, other.m_Comp);
+			swap(m_KeyExtractor, other.m_KeyExtractor);
+			swap(mp_Root, other.mp_Root);
+			swap(m_Size, other.m_Size);
+		}
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Comp; }
+
+		alloc_type get_allocator() const { return m_ValueAlloc; }
+
+		// ================= Debug =================
+
+		/// RB invariants, live reference counts, key order and size.
+		bool verify() const noexcept
+		{
+			if (mp_Root && mp_Root->m_Color != RBBk) return false;
+
+			size_type count = 0;
+			if (verify_rec(mp_Root, count) < 0 || count != m_Size) return false;
+
+			// keys strictly increasing in order
+			const value_type* prev = nullptr;
+
+			for (const value_type& v : *this)
+			{
+				if (prev && !m_Comp(m_KeyExtractor(*prev), m_KeyExtractor(v))) return false;
+				prev = std::addressof(v);
+			}
+
+			return true;
+		}
+
+		friend bool operator==(const persistent_rb_tree& a, const persistent_rb_tree& b)
+		{
+			if (a.size() != b.size()) return false;
+			if (a.mp_Root == b.mp_Root) return true;   // same version
+			return std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+
+		friend bool operator!=(const persistent_rb_tree& a, const persistent_rb_tree& b) { return !(a == b); }
+
+	private:
+
+		// ================= Nodes =================
+
+		const key_type& key_of(const node_type* n) const noexcept { return m_KeyExtractor(n->m_Val); }
+
+		static RBColor color_of(const node_type* n) noexcept {
+			return n ? n->m_Color : RBBk; // leaves are always black
+		}
+
+		template<class... Args>
+		node_type* create_node(Args&&... args)
+		{
+			node_type* n = node_traits::allocate(m_NodeAlloc, 1);
+
+			try {
+				node_traits::construct(m_NodeAlloc, n, std::in_place, std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				node_traits::deallocate(m_NodeAlloc, n, 1);
+				throw;
+			}
+
+			trace::on_allocate(sizeof(node_type));
+			return n;
+		}
+
+		void destroy_node(node_type* n) noexcept
+		{
+			node_traits::destroy(m_NodeAlloc, n);
+			node_traits::deallocate(m_NodeAlloc, n, 1);
+			trace::on_deallocate(sizeof(node_type));
+		}
+
+		// ================= Sharing =================
+
+		static node_type* retain(node_type* n) noexcept
+		{
+			if (n) n->m_Refs.fetch_add(1, std::memory_order_relaxed);
+			return n;
+		}
+
+		// drops one link to n; the last one destroys the node and
+		// drops its own links (recursion depth <= tree height)
+		void release(node_type* n) noexcept
+		{
+			while (n && n->m_Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				release(n->mp_Left);
+				node_type* right = n->mp_Right;
+				destroy_node(n);
+				n = right;
+			}
+		}
+
+		/// link is mp_Root or a child link of a private node: returns
+		/// its node once private, a copy (same value, links and color)
+		/// replacing it when another version reaches it too.
+		/// acquire: the last reader dropping its reference (release)
+		/// is done with the node before it is written here.
+		node_type* make_private(node_type*& link)
+		{
+			node_type* n = link;
+
+			if (n->m_Refs.load(std::memory_order_acquire) == 1) return n;
+
+			node_type* c = create_node(n->m_Val);
+			c->mp_Left = retain(n->mp_Left);
+			c->mp_Right = retain(n->mp_Right);
+			c->m_Color = n->m_Color;
+
+			link = c;
+			release(n);
+			return c;
+		}
+
+		// the link to path[k]: mp_Root or a child link of path[k - 1]
+		node_type*& link_to(path_type& path, int k) noexcept
+		{
+			if (k == 0) return mp_Root;
+			node_type* p = path[k - 1];
+			return p->mp_Left == path[k] ? p->mp_Left : p->mp_Right;
+		}
+
+		// path[0, depth) becomes private, top-down: a copied parent
+		// adds a reference to its children, so they are checked after
+		void make_path_private(path_type& path, int depth)
+		{
+			for (int k = 0; k < depth; ++k)
+				path[k] = make_private(link_to(path, k));
+		}
+
+		// ================= Search =================
+
+		template<typename K>
+		const node_type* find_node(const K& key) const noexcept
+		{
+			const node_type* n = mp_Root;
+
+			while (n)
+			{
+				const key_type& k = key_of(n);
+
+				if (m_Comp(key, k))
+					n = n->mp_Left;
+				else if (m_Comp(k, key))
+					n = n->mp_Right;
+				else
+					return n;
+			}
+
+			return nullptr;
+		}
+
+		template<typename K>
+		const_iterator find_path(const K& key) const noexcept
+		{
+			const_iterator it;
+
+			for (const node_type* n = mp_Root; n; )
+			{
+				it.push(n);
+				const key_type& k = key_of(n);
+
+				if (m_Comp(key, k))
+					n = n->mp_Left;
+				else if (m_Comp(k, key))
+					n = n->mp_Right;
+				else
+					return it;
+			}
+
+			return const_iterator{};
+		}
+
+		// first node with key >= key (Upper: key > key): the path is
+		// cut back to the last node where the search went left
+		template<bool Upper, typename K>
+		const_iterator bound_path(const K& key) const noexcept
+		{
+			const_iterator it;
+			int result = 0;
+
+			for (const node_type* n = mp_Root; n; )
+			{
+				it.push(n);
+				const bool go_left = Upper ? m_Comp(key, key_of(n)) : !m_Comp(key_of(n), key);
+
+				if (go_left)
+				{
+					result = it.m_Depth;
+					n = n->mp_Left;
+				}
+				else
+				{
+					n = n->mp_Right;
+				}
+			}
+
+			it.m_Depth = result;
+			return it;
+		}
+
+		const_iterator path_iterator(const path_type& path, int depth) const noexcept
+		{
+			const_iterator it;
+			for (int k = 0; k < depth; ++k) it.push(path[k]);
+			return it;
+		}
+
+		/// Where a key is or goes: path[0, depth) from the root down to
+		/// the node holding it (found) or to its future parent.
+		struct position {
+			path_type path;
+			int       depth{};
+			bool      as_left{};
+			bool      found{};
+		};
+
+		// read only: an existing or missing key changes nothing
+		template<typename K>
+		void find_position(const K& key, position& pos) const noexcept
+		{
+			node_type* n = mp_Root;
+
+			while (n)
+			{
+				pos.path[pos.depth++] = n;
+				const key_type& k = key_of(n);
+
+				if (m_Comp(key, k))
+				{
+					pos.as_left = true;
+					n = n->mp_Left;
+				}
+				else if (m_Comp(k, key))
+				{
+					pos.as_left = false;
+					n = n->mp_Right;
+				}
+				else
+				{
+					pos.found = true;
+					return;
+				}
+			}
+		}
+
+		// ================= Insert =================
+
+		/// The throwing half of an insert at pos: the path becomes
+		/// private, and so do the red uncles insert_fixup will recolor
+		/// (its dry run: colors on the path only change below the
+		/// level being checked). The tree keeps its content.
+		void prepare_link(position& pos)
+		{
+			if (m_Size >= max_size())
+				throw std::length_error{ "mstl::persistent_rb_tree: size exceeds max_size" };
+
+			path_type& path = pos.path;
+			make_path_private(path, pos.depth);
+
+			// the new red node goes at level pos.depth
+			for (int i = pos.depth; i >= 2 && path[i - 1]->m_Color == RBRed; i -= 2)
+			{
+				node_type* gx = path[i - 2];
+				node_type*& ux = path[i - 1] == gx->mp_Left ? gx->mp_Right : gx->mp_Left;
+
+				if (color_of(ux) != RBRed) break;
+				make_private(ux);
+			}
+		}
+
+		// the nothrow half: hooks x at pos (red), rebalances and
+		// returns the iterator to x, rebuilt from the part of the path
+		// the rotations left in place
+		const_iterator link_node(position& pos, node_type* x) noexcept
+		{
+			path_type& path = pos.path;
+
+			if (pos.depth == 0)
+				mp_Root = x;
+			else if (pos.as_left)
+				path[pos.depth - 1]->mp_Left = x;
+			else
+				path[pos.depth - 1]->mp_Right = x;
+
+			path[pos.depth] = x;
+			++m_Size;
+
+			const int valid = insert_fixup(path, pos.depth);
+
+			const_iterator it = path_iterator(path, valid);
+
+			for (const node_type* n = path[valid - 1]; n != x; )
+			{
+				n = m_Comp(key_of(x), key_of(n)) ? n->mp_Left : n->mp_Right;
+				it.push(n);
+			}
+
+			return it;
+		}
+
+		// ================= Rotations =================
+		// link: the private link to the rotated node, it gets the
+		// node taking its place
+
+		static void rotate_left(node_type*& link) noexcept
+		{
+			node_type* x = link;
+			node_type* y = x->mp_Right;
+
+			x->mp_Right = y->mp_Left;
+			y->mp_Left = x;
+			link = y;
+		}
+
+		static void rotate_right(node_type*& link) noexcept
+		{
+			node_type* x = link;
+			node_type* y = x->mp_Left;
+
+			x->mp_Left = y->mp_Right;
+			y->mp_Right = x;
+			link = y;
+		}
+
+		// ================= Fixups =================
+		// same cases of rb_tree::insert_fixup / erase_fixup, the
+		// parent of path[i] being path[i - 1]
+
+		/// Returns how many entries of the path still lead down to the
+		/// new node: all of them, or, after the final rotation, those
+		/// down to the node now heading gx's old subtree.
+		int insert_fixup(path_type& path, int i) noexcept
+		{
+			const int depth = i + 1;
+
+			while (i > 0 && path[i - 1]->m_Color == RBRed)
+			{
+				// a red parent is never the root: gx exists
+				node_type* x = path[i];
+				node_type* px = path[i - 1];
+				node_type* gx = path[i - 2];
+
+				const bool parent_is_left = px == gx->mp_Left;
+				node_type* ux = parent_is_left ? gx->mp_Right : gx->mp_Left;
+
+				// unlucky: uncle is red (made private by prepare_link),
+				// recolor and move up
+				if (color_of(ux) == RBRed)
+				{
+					px->m_Color = RBBk;
+					ux->m_Color = RBBk;
+					gx->m_Color = RBRed;
+
+					i -= 2;
+					continue;
+				}
+
+				// uncle black, x on the inner side: turn it outer
+				if (parent_is_left && x == px->mp_Right)
+				{
+					rotate_left(gx->mp_Left);
+					px = x;
+				}
+				else if (!parent_is_left && x == px->mp_Left)
+				{
+					rotate_right(gx->mp_Right);
+					px = x;
+				}
+
+				// outer side: one rotation at gx ends it
+				node_type*& gx_link = link_to(path, i - 2);
+
+				if (parent_is_left)
+					rotate_right(gx_link);
+				else
+					rotate_left(gx_link);
+
+				gx->m_Color = RBRed;
+				px->m_Color = RBBk;
+
+				path[i - 2] = gx_link;
+				mp_Root->m_Color = RBBk;
+				return i - 1;
+			}
+
+			mp_Root->m_Color = RBBk;
+			return depth;
+		}
+
+		// ================= Erase =================
+
+		template<typename K>
+		size_type erase_key(const K& key)
+		{
+			position pos;
+			find_position(key, pos);
+
+			if (!pos.found) return 0;
+
+			path_type& path = pos.path;
+			int depth = pos.depth;
+			const int d = depth - 1;   // level of the erased node
+
+			make_path_private(path, depth);
+
+			// two children: the successor y leaves its place for z's,
+			// the path goes on down to it
+			if (path[d]->mp_Left && path[d]->mp_Right)
+			{
+				path[depth] = make_private(path[d]->mp_Right);
+				++depth;
+
+				while (path[depth - 1]->mp_Left)
+				{
+					path[depth] = make_private(path[depth - 1]->mp_Left);
+					++depth;
+				}
+			}
+
+			prepare_erase_fixup(path, depth, d);
+			erase_node(path, depth, d);
+			return 1;
+		}
+
+		/// Dry run of erase_fixup before anything moves: every node it
+		/// will recolor or rotate becomes private. Levels and colors
+		/// are read before the unlink, which keeps both: x takes the
+		/// level of the node leaving (y, or z), y takes z's color.
+		///   - red brother: brother, its child on x's side (the next
+		///     brother) and that child's children;
+		///   - black brother and nephews: brother, then one level up;
+		///   - a red nephew: brother and both nephews;
+		///   - x red in the end: x.
+		void prepare_erase_fixup(path_type& path, int depth, int d)
+		{
+			node_type* z = path[d];
+			const bool two_children = z->mp_Left && z->mp_Right;
+
+			node_type* removed = two_children ? path[depth - 1] : z;
+			if (removed->m_Color == RBRed) return;   // no fixup
+
+			// the link x will leave from, and its level after the unlink
+			node_type*& x_link = two_children ? removed->mp_Right : (z->mp_Left ? z->mp_Left : z->mp_Right);
+			int i = depth - 1;
+
+			if (color_of(x_link) == RBRed)
+			{
+				make_private(x_link);
+				return;
+			}
+
+			auto make_children_private = [&](node_type* n) {
+				if (n->mp_Left) make_private(n->mp_Left);
+				if (n->mp_Right) make_private(n->mp_Right);
+			};
+
+			while (i > 0)
+			{
+				node_type* px = path[i - 1];
+				const bool IsXLeftChild = path[i] == px->mp_Left;
+				node_type* bx = make_private(IsXLeftChild ? px->mp_Right : px->mp_Left);
+
+				if (bx->m_Color == RBRed)
+				{
+					node_type* next = make_private(IsXLeftChild ? bx->mp_Left : bx->mp_Right);
+					make_children_private(next);
+					return;
+				}
+
+				if (color_of(bx->mp_Left) == RBBk && color_of(bx->mp_Right) == RBBk)
+				{
+					--i;
+					if (path[i]->m_Color == RBRed) return;   // private already
+					continue;
+				}
+
+				make_children_private(bx);
+				return;
+			}
+		}
+
+		/// CLRS erase over the private path: z = path[d] leaves, y =
+		/// path[depth - 1] (its successor, when z has two children)
+		/// takes its place and color; x, the child taking the place
+		/// of the node leaving, ends at level i of the path.
+		/// z's links move to other nodes, its children keep their
+		/// reference counts.
+		void erase_node(path_type& path, int depth, int d) noexcept
+		{
+			node_type* z = path[d];
+			node_type* x = nullptr;
+			RBColor y_original_color = z->m_Color;
+			int i = d;
+
+			if (!z->mp_Left || !z->mp_Right)
+			{
+				x = z->mp_Left ? z->mp_Left : z->mp_Right;
+				link_to(path, d) = x;
+			}
+			else
+			{
+				const int e = depth - 1;
+				node_type* y = path[e];
+
+				y_original_color = y->m_Color;
+				x = y->mp_Right;
+
+				if (e > d + 1)
+				{
+					path[e - 1]->mp_Left = x;
+					y->mp_Right = z->mp_Right;
+				}
+
+				y->mp_Left = z->mp_Left;
+				y->m_Color = z->m_Color;
+
+				link_to(path, d) = y;
+				path[d] = y;
+				i = e;
+			}
+
+			--m_Size;
+			destroy_node(z);
+
+			if (y_original_color == RBBk)
+				erase_fixup(path, i, x);
+		}
+
+		void erase_fixup(path_type& path, int i, node_type* x) noexcept
+		{
+			while (i > 0 && color_of(x) == RBBk)
+			{
+				node_type* px = path[i - 1];
+				const bool IsXLeftChild = x == px->mp_Left;
+				node_type* bx = IsXLeftChild ? px->mp_Right : px->mp_Left;
+
+				// red brother: rotate it above px, now the brother is black
+				if (bx->m_Color == RBRed)
+				{
+					bx->m_Color = RBBk;
+					px->m_Color = RBRed;
+
+					if (IsXLeftChild)
+						rotate_left(link_to(path, i - 1));
+					else
+						rotate_right(link_to(path, i - 1));
+
+					// bx took px's level, px and x go one down
+					path[i - 1] = bx;
+					path[i] = px;
+					++i;
+
+					bx = IsXLeftChild ? px->mp_Right : px->mp_Left;
+				}
+
+				node_type* sameX = IsXLeftChild ? bx->mp_Left : bx->mp_Right;
+				node_type* oppoX = IsXLeftChild ? bx->mp_Right : bx->mp_Left;
+
+				// brother and nephews black: move the problem up
+				if (color_of(sameX) == RBBk && color_of(oppoX) == RBBk)
+				{
+					bx->m_Color = RBRed;
+					x = px;
+					--i;
+					continue;
+				}
+
+				// only the near nephew is red: turn it into the far one
+				if (color_of(oppoX) == RBBk)
+				{
+					sameX->m_Color = RBBk;
+					bx->m_Color = RBRed;
+
+					if (IsXLeftChild)
+					{
+						rotate_right(px->mp_Right);
+						bx = px->mp_Right;
+					}
+					else
+					{
+						rotate_left(px->mp_Left);
+						bx = px->mp_Left;
+					}
+
+					oppoX = IsXLeftChild ? bx->mp_Right : bx->mp_Left;
+				}
+
+				// far nephew red: one rotation ends it
+				bx->m_Color = px->m_Color;
+				px->m_Color = RBBk;
+				oppoX->m_Color = RBBk;
+
+				if (IsXLeftChild)
+					rotate_left(link_to(path, i - 1));
+				else
+					rotate_right(link_to(path, i - 1));
+
+				x = mp_Root;
+				break;
+			}
+
+			if (x) x->m_Color = RBBk;
+		}
+
+		// ================= Verification =================
+
+		// black height of the subtree, -1 on a broken invariant
+		int verify_rec(const node_type* n, size_type& count) const noexcept
+		{
+			if (!n) return 1;
+
+			if (n->m_Refs.load(std::memory_order_relaxed) == 0) return -1;
+			if (n->m_Color == RBRed && (color_of(n->mp_Left) == RBRed || color_of(n->mp_Right) == RBRed)) return -1;
+
+			++count;
+
+			const int hl = verify_rec(n->mp_Left, count);
+			const int hr = verify_rec(n->mp_Right, count);
+
+			if (hl < 0 || hl != hr) return -1;
+
+			return hl + (n->m_Color == RBBk ? 1 : 0);
+		}
+	};
+
+	/// Only a root pointer: the tree relocates with its bytes when
+	/// its allocator and comparator do (stateless ones always can).
+	template<typename T, typename KeyOfValue, typename Compare, typename A>
+	struct is_trivially_relocatable<persistent_rb_tree<T, KeyOfValue, Compare, A>>
+		: std::bool_constant<
+			(std::is_empty_v<A> || is_trivially_relocatable_v<A>) &&
+			(std::is_empty_v<Compare> || is_trivially_relocatable_v<Compare>)> {
+	};
+}
+
+#endif // !MSTL_PERSISTENT_TREE_H
@@ -3,6 +3,8 @@
 
 #include "tree.h"
 #include "cassert"
+#include <algorithm>
+#include <cstdint>
 
 namespace mstl {
 
@@ -47,6 +49,70 @@ namespace mstl {
 		}
 	};
 
+	/// ---------------------------------------------------------------
+	/// rb order statistic node
+	/// ---------------------------------------------------------------
+	/// rb_node plus the size of its subtree: using it as NodeT
+	/// enables rank(), select(), index_of() and O(log n) distance()
+	/// (one more word per node, kept through rotations and fixups)
+
+	template<typename T>
+	struct rb_os_node : rb_node<T> {
+
+		std::size_t m_Count{ 1 };
+
+		using rb_node<T>::rb_node;
+	};
+
+	/// ---------------------------------------------------------------
+	/// rb compact node
+	/// ---------------------------------------------------------------
+	/// Same tree, the color kept in bit 0 of the parent word (a node
+	/// is at least pointer aligned): three words per node instead of
+	/// three plus a padded color byte, 24 bytes of links instead of
+	/// 32 on 64-bit. Parent and color are reached through accessors,
+	/// the shared helpers use them via TreeParent / TreeSetParent.
+	/// The price is a mask on every climb to the parent.
+
+	struct rb_compact_node_base {
+		rb_compact_node_base* mp_Left{};
+		rb_compact_node_base* mp_Right{};
+		std::uintptr_t m_ParentColor{};     // parent | color (RBRed == 0)
+
+		rb_compact_node_base* parent() const noexcept {
+			return reinterpret_cast<rb_compact_node_base*>(m_ParentColor & ~std::uintptr_t{ 1 });
+		}
+
+		void set_parent(rb_compact_node_base* p) noexcept {
+			m_ParentColor = reinterpret_cast<std::uintptr_t>(p) | (m_ParentColor & 1);
+		}
+
+		RBColor color() const noexcept { return static_cast<RBColor>(m_ParentColor & 1); }
+
+		void set_color(RBColor c) noexcept {
+			m_ParentColor = (m_ParentColor & ~std::uintptr_t{ 1 }) | c;
+		}
+	};
+
+	static_assert(alignof(rb_compact_node_base) >= 2, "bit 0 of the parent word must be free");
+
+	template<typename T>
+	struct rb_compact_node : rb_compact_node_base {
+
+		using value_type = T;
+		using base_type = rb_compact_node_base;
+		T m_Val;
+
+		explicit rb_compact_node(const T& v) : rb_compact_node_base{}, m_Val(v) {}
+		explicit rb_compact_node(T&& v) : rb_compact_node_base{}, m_Val(std::move(v)) {}
+
+		template<class... Args>
+		explicit rb_compact_node(std::in_place_t, Args&&... args)
+			: rb_compact_node_base{}
+			, m_Val(std::forward<Args>(args)...) {
+		}
+	};
+
 	/// ---------------------------------------------------------------
 	/// RB Tree
 	/// ---------------------------------------------------------------
@@ -74,6 +140,9 @@ namespace mstl {
 		using node_alloc     = typename base_type::node_alloc;
 		using node_traits    = typename base_type::node_traits;
 
+		// the join based algorithms call back DoJoin & co.
+		friend base_type;
+
 	public:
 
 		using key_type        = typename base_type::key_type;
@@ -111,12 +180,38 @@ namespace mstl {
 				insert(v);
 		}
 
+		// [first, last) must be sorted by key and without duplicates:
+		// built bottom-up in O(n), see tree_base::DoBuildSorted
+		template<std::input_iterator It>
+		rb_tree(sorted_unique_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: base_type(a, c)
+		{
+			build_sorted(first, last);
+		}
+
+		// [first, last) sorted by key, equal keys allowed (multiset)
+		template<std::input_iterator It>
+		rb_tree(sorted_equivalent_t, It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+			: base_type(a, c)
+		{
+			build_sorted(first, last);
+		}
+
+		template<std::input_iterator It>
+		static rb_tree from_sorted(It first, It last, const alloc_type& a = alloc_type{}, const compare& c = compare{})
+		{
+			return rb_tree(sorted_unique, first, last, a, c);
+		}
+
 		// ============= Copy semantics =================
 
+		// node for node, colors included, see tree_base::DoCloneFrom
 		rb_tree(const rb_tree& other)
 			: base_type(other.m_ValueAlloc, other.m_Comp)
 		{
-			for (const auto& v : other) insert(v);
+			this->DoCloneFrom(other, [](node_type* n, const node_type* src) {
+				set_color(n, color_of(src));
+			});
 		}
 
 		rb_tree& operator=(const rb_tree& other)
@@ -129,7 +224,10 @@ namespace mstl {
 
 		// ============= Move semantics =================
 
+		// starts from a copy of other's allocator (a default
+		// constructed one may allocate), then takes the nodes
 		rb_tree(rb_tree&& other) noexcept
+			: base_type(other.m_ValueAlloc, other.m_Comp)
 		{
 			swap(other);
 		}
@@ -157,28 +255,255 @@ namespace mstl {
 			return { iterator{ n }, ok };
 		}
 
+		// O(1) amortized when v goes right before or after hint,
+		// the usual descent otherwise (see DoHintPosition)
+		template<typename U>
+		iterator insert(const_iterator hint, U&& v)
+		{
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->m_KeyExtractor(v), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+
+			if (pos.existing) return iterator{ pos.existing };
+
+			node_type* n = create_node(std::forward<U>(v), pos.parent);
+			link_node(n, pos);
+			return iterator{ n };
+		}
+
+		// the value is built once, in the node: on a duplicate
+		// key the node is dropped (as std::map::emplace)
 		template<class... Args>
 		std::pair<iterator, bool> emplace(Args&&... args)
 		{
-			value_type temp(std::forward<Args>(args)...);
-			auto [n, ok] = insert_impl(std::move(temp));
-			return { iterator{ n }, ok };
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			auto [p, ok] = insert_node(n);
+			if (!ok) this->DoDestroyNode(n);
+			return { iterator{ p }, ok };
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->DoKeyOf(n), true);
+
+			if (!pos.parent && !pos.existing)
+				pos = this->DoFindInsertPosition(this->DoKeyOf(n));
+
+			if (pos.existing)
+			{
+				this->DoDestroyNode(n);
+				return iterator{ pos.existing };
+			}
+
+			link_node(n, pos);
+			return iterator{ n };
+		}
+
+		// args build the value only when key is not here (try_emplace):
+		// nothing is constructed nor allocated on a hit
+		template<class... Args>
+		std::pair<iterator, bool> emplace_if_absent(const key_type& key, Args&&... args)
+		{
+			auto pos = this->DoFindInsertPosition(key);
+			if (pos.existing) return { iterator{ pos.existing }, false };
+
+			node_type* n = this->DoCreateNode(std::in_place, std::forward<Args>(args)...);
+			link_node(n, pos);
+			return { iterator{ n }, true };
+		}
+
+		/// Range insert. A sorted multi-pass range (checked in O(m))
+		/// skips the descents: into an empty tree it is the bottom-up
+		/// build, O(m), otherwise it is built apart and united, O(m
+		/// log(n / m + 1)). Anything else is inserted with the previous
+		/// position as hint, so mostly ascending input stays cheap.
+		template<std::input_iterator It>
+		void insert_range_unique(It first, It last)
+		{
+			if constexpr (std::forward_iterator<It>)
+			{
+				const auto& key_ex = this->m_KeyExtractor;
+				auto not_less = [&](const auto& a, const auto& b) { return !this->m_Comp(key_ex(a), key_ex(b)); };
+
+				if (std::adjacent_find(first, last, not_less) == last)
+				{
+					if (empty())
+					{
+						build_sorted(first, last);
+					}
+					else
+					{
+						union_with(rb_tree(sorted_unique, first, last, this->m_ValueAlloc, this->m_Comp));
+					}
+					return;
+				}
+			}
+
+			const_iterator hint = this->end();
+
+			for (; first != last; ++first)
+				hint = std::next(insert(hint, *first));
+		}
+
+		// ================= Equal keys (multiset) =================
+		// equal keys are kept in insertion order, a new one goes
+		// after those already in
+
+		template<typename U>
+		iterator insert_equal(U&& v)
+		{
+			return iterator{ insert_node_equal(this->DoCreateNode(std::forward<U>(v))) };
+		}
+
+		template<typename U>
+		iterator insert_equal(const_iterator hint, U&& v)
+		{
+			return iterator{ insert_node_equal(hint, this->DoCreateNode(std::forward<U>(v))) };
+		}
+
+		template<class... Args>
+		iterator emplace_equal(Args&&... args)
+		{
+			return iterator{ insert_node_equal(this->DoCreateNode(std::in_place, std::forward<Args>(args)...)) };
+		}
+
+		template<class... Args>
+		iterator emplace_hint_equal(const_iterator hint, Args&&... args)
+		{
+			return iterator{ insert_node_equal(hint, this->DoCreateNode(std::in_place, std::forward<Args>(args)...)) };
+		}
+
+		// sorted input into an empty tree: O(m) build, see above.
+		template<std::input_iterator It>
+		void insert_range_equal(It first, It last)
+		{
+			if constexpr (std::forward_iterator<It>)
+			{
+				const auto& key_ex = this->m_KeyExtractor;
+				auto less = [&](const auto& a, const auto& b) { return this->m_Comp(key_ex(a), key_ex(b)); };
+
+				if (empty() && std::is_sorted(first, last, less))
+				{
+					build_sorted(first, last);
+					return;
+				}
+			}
+
+			// end() as hint: appends stay O(1), equal keys keep the
+			// input order (a hint may place a key before its equals)
+			for (; first != last; ++first)
+				insert_equal(this->cend(), *first);
+		}
+
+		size_type erase_equal(const key_type& key)
+		{
+			return erase_span(this->equal_range(key));
+		}
+
+		template<typename K> requires base_type::template is_heterogeneous_key<K>
+		size_type erase_equal(const K& key)
+		{
+			return erase_span(this->equal_range(key));
+		}
+
+		// every node of other moves here, relinked: O(m log(n + m))
+		void merge_equal(rb_tree& other) noexcept
+		{
+			if (this == &other) return;
+
+			assert(get_allocator() == other.get_allocator() && "rb_tree: merge of trees with unequal allocators");
+
+			base_node_type* root = other.DoRoot();
+			other.DoResetHeader();
+			other.m_Size = 0;
+
+			move_equal_rec(root);
+		}
+
+		// ================= Node handles =================
+
+		using node_handle = typename base_type::node_handle;
+
+		struct insert_return_type {
+			iterator position;
+			bool inserted;
+			node_handle node;
+		};
+
+		// unlinks the node at pos, no deallocation
+		node_handle extract(const_iterator pos) noexcept
+		{
+			base_node_type* z = this->DoIterNode(pos);
+			unlink_node(z);
+			return this->DoMakeHandle(z);
+		}
+
+		node_handle extract(const key_type& key) noexcept
+		{
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
+			if (!z) return {};
+			unlink_node(z);
+			return this->DoMakeHandle(z);
+		}
+
+		template<typename K> requires base_type::template is_heterogeneous_key<K>
+		node_handle extract(const K& key) noexcept
+		{
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
+			if (!z) return {};
+			unlink_node(z);
+			return this->DoMakeHandle(z);
+		}
+
+		// on a duplicate key the node stays in the returned handle
+		insert_return_type insert(node_handle&& nh) noexcept
+		{
+			if (nh.empty()) return { this->end(), false, {} };
+
+			auto [n, ok] = insert_node(this->DoHandleNode(nh));
+
+			if (!ok) return { iterator{ n }, false, std::move(nh) };
+
+			this->DoReleaseHandle(nh);
+			return { iterator{ n }, true, {} };
+		}
+
+		iterator insert_equal(node_handle&& nh) noexcept
+		{
+			if (nh.empty()) return this->end();
+
+			base_node_type* n = insert_node_equal(this->DoHandleNode(nh));
+			this->DoReleaseHandle(nh);
+			return iterator{ n };
 		}
 
 		// erase by key
 		size_type erase(const key_type& key)
 		{
-			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->mp_Root, key, this->m_KeyExtractor, this->m_Comp);
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
+			if (!z) return 0;
+			erase_node(z);
+			return 1;
+		}
+
+		// transparent comparators only (see TransparentCompare)
+		template<typename K> requires base_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key)
+		{
+			base_node_type* z = mstl::TreeFind<node_type, base_node_type>(this->DoRoot(), key, this->m_KeyExtractor, this->m_Comp);
 			if (!z) return 0;
 			erase_node(z);
 			return 1;
 		}
 
 		// erase by iterator -> returns successor
-		iterator erase(iterator pos)
+		iterator erase(const_iterator pos)
 		{
-			base_node_type* z = pos.curr;
-			if (!z) return this->end();
+			base_node_type* z = this->DoIterNode(pos);
+			if (z == this->DoHeader()) return this->end();
 			base_node_type* s = mstl::TreeSuccessor<base_node_type>(z);
 			erase_node(z);
 			return iterator{ s };
@@ -187,23 +512,76 @@ namespace mstl {
 		void swap(rb_tree& other) noexcept
 		{
 			using std::swap;
-			swap(this->m_ValueAlloc, other.m_ValueAlloc);
-			swap(this->m_NodeAlloc, other.m_NodeAlloc);
-			swap(this->m_Comp, other.m_Comp);
-			swap(this->m_Size, other.m_Size);
-			swap(this->mp_Root, other.mp_Root);
+			this->DoSwap(other);
+		}
+
+		// ================= Join / Split =================
+		// see tree_base, "Join based algorithms". The trees involved
+		// must have equal allocators and comparators.
+
+		// every key of left < every key of right (unchecked), O(log n)
+		static rb_tree join(rb_tree&& left, rb_tree&& right) noexcept
+		{
+			rb_tree out(std::move(left));
+			out.DoJoinWith(out, nullptr, right);
+			return out;
+		}
+
+		// every key of left < key of pivot < every key of right
+		template<typename U>
+		static rb_tree join(rb_tree&& left, U&& pivot, rb_tree&& right)
+		{
+			rb_tree out(std::move(left));
+			node_type* k = out.DoCreateNode(std::forward<U>(pivot));
+			out.DoJoinWith(out, k, right);
+			return out;
+		}
+
+		// *this keeps the keys < key, the keys >= key are returned.
+		// O(log n) relinking, plus the size recount of DoSplitInto
+		rb_tree split(const key_type& key)
+		{
+			rb_tree out(this->m_ValueAlloc, this->m_Comp);
+			this->DoSplitInto(*this, key, out);
+			return out;
+		}
+
+		// as std::set::merge: the keys missing here move from other,
+		// the others stay there. Nodes are relinked, not copied
+		void merge(rb_tree& other) noexcept
+		{
+			if (this != &other) this->DoMergeFrom(*this, other);
+		}
+
+		// every node of other moves here, on equal keys ours stay
+		void union_with(rb_tree&& other) noexcept
+		{
+			if (this != &other) this->DoUnionWith(*this, other);
+		}
+
+		// keeps the keys that are also in other
+		void intersection_with(const rb_tree& other) noexcept
+		{
+			if (this != &other) this->DoIntersectionWith(*this, other);
+		}
+
+		// drops the keys that are in other
+		void difference_with(const rb_tree& other) noexcept
+		{
+			if (this == &other) clear();
+			else this->DoDifferenceWith(*this, other);
 		}
 
 		// ================= Observers =================
 
-		const node_type* root() const noexcept { return this->mp_Root; }
+		const node_type* root() const noexcept { return this->DoRoot(); }
 
 		alloc_type get_allocator() const { return this->m_ValueAlloc; }
 
 		// ================= Utility =================
 
 		void inorder_print() const noexcept {
-			inorder_print_rec(this->mp_Root, nullptr, "root");
+			inorder_print_rec(this->DoRoot(), nullptr, "root");
 		}
 
 		bool IsRBTree() const noexcept
@@ -218,66 +596,248 @@ namespace mstl {
 		static RBColor color_of(const base_node_type* n) noexcept
 		{
 			if (!n) return RBBk; // leaves are always black
-			return static_cast<const node_type*>(n)->m_Color;
+
+			if constexpr (PackedParentNode<base_node_type>)
+				return n->color();
+			else
+				return n->m_Color;
 		}
 
 		static void set_color(base_node_type* n, RBColor c) noexcept
 		{
-			if (n) static_cast<node_type*>(n)->m_Color = c;
+			if (!n) return;
+
+			if constexpr (PackedParentNode<base_node_type>)
+				n->set_color(c);
+			else
+				n->m_Color = c;
 		}
 
-		template<typename U>
-		std::pair<base_node_type*, bool> insert_impl(U&& v)
+		/// In a perfectly balanced tree of n nodes every level is full
+		/// except, maybe, the deepest one: painting that level red (and
+		/// everything else black) gives the same black height on all
+		/// paths. Returns that depth, or -1 when the last level is full.
+		static int balanced_red_depth(size_type n) noexcept
 		{
-			base_node_type* parent = nullptr;
-			base_node_type* current = this->mp_Root;
+			const int levels = static_cast<int>(std::bit_width(n));              // ceil(log2(n + 1))
+			const int full_levels = static_cast<int>(std::bit_width(n + 1)) - 1; // floor(log2(n + 1))
+			return levels > full_levels ? levels - 1 : -1;
+		}
 
-			const auto& key_ex = this->m_KeyExtractor;
-			const auto& comp = this->m_Comp;
+		template<typename It>
+		void build_sorted(It first, It last)
+		{
+			int red_depth = -1;
+			bool red_depth_known = false;
 
-			while (current)
-			{
-				parent = current;
-				const value_type& val = static_cast<const node_type*>(current)->m_Val;
+			this->DoBuildSorted(first, last, [&](node_type* n, int depth, int) {
 
-				if (comp(key_ex(v), key_ex(val)))
-				{
-					current = current->mp_Left;
-				}
-				else if (comp(key_ex(val), key_ex(v)))
+				// m_Size is already the final size here
+				if (!red_depth_known)
 				{
-					current = current->mp_Right;
+					red_depth = balanced_red_depth(this->m_Size);
+					red_depth_known = true;
 				}
-				else
-				{
-					return { current, false };
-				}
-			}
 
-			// create node
-			node_type* new_node = create_node(std::forward<U>(v), parent);
+				set_color(n, depth == red_depth ? RBRed : RBBk);
+			});
+		}
+
+		template<typename U>
+		std::pair<base_node_type*, bool> insert_impl(U&& v)
+		{
+			auto pos = this->DoFindInsertPosition(this->m_KeyExtractor(v));
+			if (pos.existing) return { pos.existing, false };
+
+			node_type* new_node = create_node(std::forward<U>(v), pos.parent);
+
+			// insert as child of parent (the header if it is the first),
+			// tree_base keeps leftmost/rightmost and size, then fixup
+			link_node(new_node, pos);
+
+			return { new_node, true };
+		}
+
+		/// Links a detached node (merge, emplace): nothing is allocated.
+		/// If the key is already here returns that node, n is left alone.
+		std::pair<base_node_type*, bool> insert_node(node_type* n) noexcept
+		{
+			auto pos = this->DoFindInsertPosition(this->DoKeyOf(n));
+			if (pos.existing) return { pos.existing, false };
+
+			link_node(n, pos);
+			return { n, true };
+		}
+
+		// links a new node at a position found by DoFindInsertPosition
+		// or DoHintPosition
+		void link_node(node_type* n, const typename base_type::insert_position& pos) noexcept
+		{
+			set_color(n, RBRed);
+			this->DoAttachNode(n, pos.parent, pos.as_left);
+			insert_fixup(n);
+		}
 
-			// insert as child of parent
-			if (!parent)
+		// after the equal keys already in (upper bound position)
+		base_node_type* insert_node_equal(node_type* n) noexcept
+		{
+			typename base_type::insert_position pos{ this->DoHeader(), false };
+			const auto& key = this->DoKeyOf(n);
+
+			for (base_node_type* current = this->DoRoot(); current; )
 			{
-				// update root
-				this->mp_Root = new_node;
+				pos.parent = current;
+				pos.as_left = this->m_Comp(key, this->DoKeyOf(current));
+				current = pos.as_left ? current->mp_Left : current->mp_Right;
 			}
-			else if (comp(key_ex(v), key_ex(static_cast<const node_type*>(parent)->m_Val)))
+
+			link_node(n, pos);
+			return n;
+		}
+
+		base_node_type* insert_node_equal(const_iterator hint, node_type* n) noexcept
+		{
+			auto pos = this->DoHintPosition(this->DoIterNode(hint), this->DoKeyOf(n), false);
+
+			if (!pos.parent) return insert_node_equal(n);
+
+			link_node(n, pos);
+			return n;
+		}
+
+		// in order, so equal keys of other keep their order
+		void move_equal_rec(base_node_type* n) noexcept
+		{
+			if (!n) return;
+
+			base_node_type* l = n->mp_Left;
+			base_node_type* r = n->mp_Right;
+
+			move_equal_rec(l);
+			insert_node_equal(static_cast<node_type*>(n));
+			move_equal_rec(r);
+		}
+
+		// ================= Join =================
+		/// The rank of a piece is its black height, root included: it
+		/// is computed once on the whole tree (left spine) then derived
+		/// going down and returned by every join, so join stays
+		/// O(|bh(l) - bh(r)| + 1). Pieces may have a red root.
+
+		using join_piece = typename base_type::join_piece;
+
+		static int black_height(const base_node_type* n) noexcept
+		{
+			int bh = 0;
+			for (; n; n = n->mp_Left)
+				if (color_of(n) == RBBk) ++bh;
+			return bh;
+		}
+
+		int DoRootRank(base_node_type* root) const noexcept { return black_height(root); }
+
+		int DoChildRank(const join_piece& parent, base_node_type*) const noexcept
+		{
+			return parent.rank - (color_of(parent.root) == RBBk ? 1 : 0);
+		}
+
+		void DoFixRoot() noexcept { set_color(this->DoRoot(), RBBk); }
+
+		// k becomes the (detached) parent of l and r
+		static base_node_type* link(base_node_type* l, base_node_type* k, base_node_type* r, RBColor c) noexcept
+		{
+			k->mp_Left = l;
+			k->mp_Right = r;
+			mstl::TreeSetParent(k, nullptr);
+			if (l) mstl::TreeSetParent(l, k);
+			if (r) mstl::TreeSetParent(r, k);
+			set_color(k, c);
+
+			if constexpr (base_type::has_order_statistics)
+				mstl::TreeUpdateCount<node_type>(k);
+
+			return k;
+		}
+
+		/// bh(l) > bh(r), both roots black: walks down the right spine
+		/// of l to the black node with the black height of r, k (red)
+		/// takes its place with it and r as children. A red-red pair
+		/// is fixed one level up by a rotation, as in insert_fixup.
+		base_node_type* join_right(base_node_type* l, int bhl, base_node_type* k, base_node_type* r, int bhr) noexcept
+		{
+			if (color_of(l) == RBBk && bhl == bhr)
+				return link(l, k, r, RBRed);
+
+			const int child_bh = bhl - (color_of(l) == RBBk ? 1 : 0);
+			base_node_type* c = join_right(l->mp_Right, child_bh, k, r, bhr);
+
+			l->mp_Right = c;
+			mstl::TreeSetParent(c, l);
+
+			if constexpr (base_type::has_order_statistics)
+				mstl::TreeUpdateCount<node_type>(l);
+
+			if (color_of(l) == RBBk && color_of(c) == RBRed && color_of(c->mp_Right) == RBRed)
 			{
-				parent->mp_Left = new_node;
+				set_color(c->mp_Right, RBBk);
+				return this->DoRotateLeft(l);
 			}
-			else
+
+			return l;
+		}
+
+		// mirror of join_right, bh(r) > bh(l)
+		base_node_type* join_left(base_node_type* l, int bhl, base_node_type* k, base_node_type* r, int bhr) noexcept
+		{
+			if (color_of(r) == RBBk && bhl == bhr)
+				return link(l, k, r, RBRed);
+
+			const int child_bh = bhr - (color_of(r) == RBBk ? 1 : 0);
+			base_node_type* c = join_left(l, bhl, k, r->mp_Left, child_bh);
+
+			r->mp_Left = c;
+			mstl::TreeSetParent(c, r);
+
+			if constexpr (base_type::has_order_statistics)
+				mstl::TreeUpdateCount<node_type>(r);
+
+			if (color_of(r) == RBBk && color_of(c) == RBRed && color_of(c->mp_Left) == RBRed)
 			{
-				parent->mp_Right = new_node;
+				set_color(c->mp_Left, RBBk);
+				return this->DoRotateRight(r);
 			}
 
-			++this->m_Size;
+			return r;
+		}
 
-			// fixup color
-			insert_fixup(new_node);
+		join_piece DoJoin(join_piece l, base_node_type* k, join_piece r) noexcept
+		{
+			// painting a root black is always allowed
+			if (color_of(l.root) == RBRed) { set_color(l.root, RBBk); ++l.rank; }
+			if (color_of(r.root) == RBRed) { set_color(r.root, RBBk); ++r.rank; }
 
-			return { new_node, true };
+			if (l.rank != r.rank)
+			{
+				const bool taller_left = l.rank > r.rank;
+				const int bh = taller_left ? l.rank : r.rank;
+
+				base_node_type* t = taller_left
+					? join_right(l.root, l.rank, k, r.root, r.rank)
+					: join_left(l.root, l.rank, k, r.root, r.rank);
+
+				mstl::TreeSetParent(t, nullptr);
+
+				// red-red left at the root
+				if (color_of(t) == RBRed && color_of(taller_left ? t->mp_Right : t->mp_Left) == RBRed)
+				{
+					set_color(t, RBBk);
+					return { t, bh + 1 };
+				}
+
+				return { t, bh };
+			}
+
+			return { link(l.root, k, r.root, RBRed), l.rank };
 		}
 
 		// Could be better to initialize the color to black, directly?
@@ -289,11 +849,11 @@ namespace mstl {
 			try {
 
 				node_traits::construct(this->m_NodeAlloc, n, std::forward<U>(v));
-				n->mp_Parent = parent;
+				mstl::TreeSetParent<base_node_type>(n, parent);
 				n->mp_Left = n->mp_Right = nullptr;
 
 				// default color
-				n->m_Color = RBRed;
+				set_color(n, RBRed);
 			}
 			catch (...)
 			{
@@ -306,15 +866,14 @@ namespace mstl {
 
 		void insert_fixup(base_node_type* x) noexcept
 		{
-			base_node_type* px = x->mp_Parent;
+			base_node_type* px = mstl::TreeParent(x);
 				
 			// until I return to root or I have red child and red parent
-			while (px && color_of(px) == RBRed)
+			// (the parent of the root is the header: stop there)
+			while (!mstl::TreeIsHeader(px) && color_of(px) == RBRed)
 			{
-				base_node_type* gx = px->mp_Parent;
-					
-				// if gx not valid px is root
-				if (!gx) break;
+				// px is red so it isn't the root, gx is a real node
+				base_node_type* gx = mstl::TreeParent(px);
 
 				bool IsXLeftChild = x == px->mp_Left ? true : false;
 
@@ -340,11 +899,11 @@ namespace mstl {
 				{
 					if (!IsXLeftChild)
 					{
-						mstl::TreeRotateLeft<base_node_type>(px);
+						this->DoRotateLeft(px);
 					}
 					else
 					{
-						mstl::TreeRotateRight<base_node_type>(px);
+						this->DoRotateRight(px);
 					}
 
 					base_node_type* tmp = x;
@@ -354,28 +913,24 @@ namespace mstl {
 				}
 
 				// fortunate case: uncle is black and opposite side of x
+				// (a rotation at the root updates the header)
 				if (color_of(ux) == RBBk) // && (IsXLeftChild != IsUncleLeftChild)
 				{
-					base_node_type* new_root = nullptr;
-
 					if (IsXLeftChild)
 					{
 						// right rotation
-						new_root = mstl::TreeRotateRight<base_node_type>(gx);
+						this->DoRotateRight(gx);
 					}
 					else
 					{
 						// left rotation
-						new_root = mstl::TreeRotateLeft<base_node_type>(gx);
+						this->DoRotateLeft(gx);
 					}
 
 					// recolor
 					set_color(gx, RBRed);
 					set_color(px, RBBk);
 
-					if (!new_root->mp_Parent)
-						this->mp_Root = static_cast<node_type*>(new_root);
-
 					break;
 				}
 
@@ -386,214 +941,182 @@ namespace mstl {
 				set_color(ux, RBBk);
 				set_color(gx, RBRed);
 
-				px = gx->mp_Parent;
+				px = mstl::TreeParent(gx);
 				x = gx;
 			}
 
-			if (this->mp_Root)
-			{
-				set_color(this->mp_Root, RBBk);
-			}
+			set_color(this->DoRoot(), RBBk);
 		}
 
-		// For an optimization I can choose a successor or predecessor based on
-		// its color?
-		void erase_node(base_node_type* x)
+		size_type erase_span(std::pair<iterator, iterator> r)
 		{
-			if (!x) return;
+			size_type n = 0;
 
-			node_type* node_to_delete = static_cast<node_type*>(x);
+			for (; r.first != r.second; ++n)
+				r.first = erase(r.first);
 
-			base_node_type* removed_node = x;
-			RBColor rn_original_color = x->m_Color;
-			base_node_type* rn_substitute = nullptr;
+			return n;
+		}
+
+		void erase_node(base_node_type* z)
+		{
+			if (!z) return;
+
+			unlink_node(z);
+			this->DoDestroyNode(static_cast<node_type*>(z));
+		}
 
-			if (!node_to_delete->mp_Left)
+		/// Erase follows CLRS: y is the node physically removed from
+		/// its position (z itself or its successor), x the child that
+		/// takes y place. x may be a nullptr leaf, so its parent is
+		/// tracked apart for the fixup. z is not destroyed (extract).
+		void unlink_node(base_node_type* z) noexcept
+		{
+			this->DoDetachExtremes(z);
+
+			base_node_type* y = z;
+			RBColor y_original_color = color_of(y);
+			base_node_type* x = nullptr;
+			base_node_type* x_parent = nullptr;
+
+			if (!z->mp_Left)
 			{
-				rn_substitute = node_to_delete->mp_Right;
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_delete, node_to_delete->mp_Right);
+				x = z->mp_Right;
+				x_parent = mstl::TreeParent(z);
+				mstl::TreeTransplant<base_node_type>(z, z->mp_Right);
 			}
-			else if (!node_to_delete->mp_Right)
+			else if (!z->mp_Right)
 			{
-				rn_substitute = node_to_delete->mp_Left;
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_delete, node_to_delete->mp_Left);
+				x = z->mp_Left;
+				x_parent = mstl::TreeParent(z);
+				mstl::TreeTransplant<base_node_type>(z, z->mp_Left);
 			}
 			else
 			{
-				// Use the successor
-				base_node_type* s = mstl::TreeSuccessor<base_node_type>(x);
-					
-				removed_node = s;
-				rn_original_color = s->m_Color;
-
-				// successor has at the most one child
-				// and it has no left child, otherwise it wouldn't be
+				// Use the successor:
+				// it has no left child, otherwise it wouldn't be
 				// the successor
+				y = mstl::TreeMin<base_node_type>(z->mp_Right);
+				y_original_color = color_of(y);
+				x = y->mp_Right;
 
-				rn_substitute = s->mp_Right;
-
-				if (removed_node->mp_Parent == node_to_delete)
+				if (mstl::TreeParent(y) == z)
 				{
-					if (rn_substitute) rn_substitute->mp_Parent = removed_node;
+					x_parent = y;
 				}
-
-				// it isn't a direct child
 				else
 				{
-					mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, s, s->mp_Right);
+					x_parent = mstl::TreeParent(y);
+					mstl::TreeTransplant<base_node_type>(y, y->mp_Right);
 
-					s->mp_Right = node_to_delete->mp_Right;
-
-					assert(s->mp_Right && "[bst_erase_node]: case 2 children, right subtree of erased must be valid since successor isn't direct child");
-
-					s->mp_Right->mp_Parent = s;
+					y->mp_Right = z->mp_Right;
+					mstl::TreeSetParent(y->mp_Right, y);
 				}
 
-				mstl::TreeTransplant<node_type, base_node_type>(this->mp_Root, node_to_delete, s);
+				mstl::TreeTransplant<base_node_type>(z, y);
 
-				s->mp_Left = node_to_delete->mp_Left;
-				if (s->mp_Left) s->mp_Left->mp_Parent = s;
+				y->mp_Left = z->mp_Left;
+				mstl::TreeSetParent(y->mp_Left, y);
 
-				// Keep the original color
-				set_color(removed_node, node_to_delete->m_Color);
+				// y takes z place and color
+				set_color(y, color_of(z));
 			}
 
-			this->DoDestroyNode(node_to_delete);
 			--this->m_Size;
 
-			base_node_type leafSentinel{};
-			leafSentinel.m_Color = RBBk;
-			base_node_type* ptr_leafSentinel = &leafSentinel;
+			// subtree sizes (order statistics), before any rotation
+			this->DoFixCountsUpward(x_parent);
 
-			// check for fix up
-			if (rn_original_color == RBBk)
+			// removing a black node breaks the black height of x path
+			if (y_original_color == RBBk)
 			{
-				if (!rn_substitute)
-				{
-					leafSentinel.mp_Parent = removed_node;
-					erase_fixup(ptr_leafSentinel);
-				}
-				else
-				{
-					erase_fixup(rn_substitute);
-				}	
-			}		
+				erase_fixup(x, x_parent);
+			}
 		}
 
-		void erase_fixup(base_node_type* double_black)
+		/// x carries an extra black. Push it up until it meets a red
+		/// node (painted black) or the root, or remove it with the
+		/// rotations of the "red far nephew" case.
+		void erase_fixup(base_node_type* x, base_node_type* px) noexcept
 		{
-			while (double_black && double_black->m_Color == RBBk)
+			while (x != this->DoRoot() && color_of(x) == RBBk)
 			{
-				// parent of double black
-				base_node_type* px = double_black->mp_Parent;
-
-				// if px is not valid double_black is the root
-				if (!px) break;
-
-				bool IsDBLeftChild = double_black == px->mp_Left ? true : false;
-
-				// brother of double black
-				base_node_type* bx = IsDBLeftChild ? px->mp_Right : px->mp_Left;
+				const bool IsXLeftChild = x == px->mp_Left;
 
-				// children of brother
-				base_node_type* sameX{};
-				base_node_type* oppoX{};
+				// brother of x: never a leaf, x side misses a black
+				base_node_type* bx = IsXLeftChild ? px->mp_Right : px->mp_Left;
 
-				if (bx)
+				// red brother: rotate it above px, now the brother is black
+				if (color_of(bx) == RBRed)
 				{
-					sameX = IsDBLeftChild ? bx->mp_Left : bx->mp_Right;
-					oppoX = IsDBLeftChild ? bx->mp_Right : bx->mp_Left;
-				}
-
-				// worstCase: brother of double_black is red, but the siblings are black
-				if (bx && bx->m_Color == RBRed)
-				{
-					// if px is the root, now it became bx
-					if (!px->mp_Parent) this->mp_Root = static_cast<node_type*>(bx);
+					set_color(bx, RBBk);
+					set_color(px, RBRed);
 
-					// rotate 
-					if (IsDBLeftChild)
+					if (IsXLeftChild)
 					{
-						mstl::TreeRotateLeft<base_node_type>(px);
+						this->DoRotateLeft(px);
+						bx = px->mp_Right;
 					}
 					else
 					{
-						mstl::TreeRotateRight<base_node_type>(px);
+						this->DoRotateRight(px);
+						bx = px->mp_Left;
 					}
-
-					// recolor
-					set_color(px, RBRed);
-					set_color(bx, RBBk);
-
-					// update brother
-					bx = px->mp_Right;
 				}
 
-				// bad case: brother and siblings are black
-				if ((!sameX || (sameX && sameX->m_Color == RBBk))
-					&& (!oppoX || (oppoX && oppoX->m_Color == RBBk)))
+				// nephews of the same side and of the opposite side of x
+				base_node_type* sameX = IsXLeftChild ? bx->mp_Left : bx->mp_Right;
+				base_node_type* oppoX = IsXLeftChild ? bx->mp_Right : bx->mp_Left;
+
+				// bad case: brother and nephews are black, move the problem up
+				if (color_of(sameX) == RBBk && color_of(oppoX) == RBBk)
 				{
 					set_color(bx, RBRed);
-					double_black = px;
-
-					if (double_black->m_Color == RBRed)
-					{
-						set_color(double_black, RBBk);
-						break;
-					}
+					x = px;
+					px = mstl::TreeParent(px);
+					continue;
 				}
-				else
-				{
-
-					// semi fortunate case: nephew of the same side is red, but the other is black
 
-					if ((sameX && sameX->m_Color == RBRed) && (!oppoX || (oppoX && oppoX->m_Color == RBBk)))
-					{
-						if (IsDBLeftChild)
-						{
-							mstl::TreeRotateRight<base_node_type>(bx);
-						}
-						else
-						{
-							mstl::TreeRotateLeft<base_node_type>(bx);
-						}
-
-						set_color(sameX, RBBk);
-						set_color(bx, RBRed);
-
-						//base_node_type* tmp = sameX;
-						bx = sameX;
-					}
-
-					// technically no need of tests ?
-					// if (oppoX && oppoX->m_Color == RBRed)
+				// semi fortunate case: only the near nephew is red,
+				// turn it into the far one
+				if (color_of(oppoX) == RBBk)
+				{
+					set_color(sameX, RBBk);
+					set_color(bx, RBRed);
 
-					// fortunate case: double_black (uncle) has a RED nephew at the opposite side
-					if (IsDBLeftChild)
+					if (IsXLeftChild)
 					{
-						mstl::TreeRotateLeft<base_node_type>(px);
+						this->DoRotateRight(bx);
+						bx = px->mp_Right;
 					}
 					else
 					{
-						mstl::TreeRotateRight<base_node_type>(px);
+						this->DoRotateLeft(bx);
+						bx = px->mp_Left;
 					}
 
-					// recolor
-					set_color(oppoX, RBBk);
-					set_color(bx, px->m_Color);
-					set_color(px, RBBk);
-					set_color(double_black, RBBk);
-						
-					if (!bx->mp_Parent)
-					{
-						this->mp_Root = static_cast<node_type*>(bx);
-					}
+					oppoX = IsXLeftChild ? bx->mp_Right : bx->mp_Left;
+				}
 
-					break;
+				// fortunate case: far nephew is red, one rotation ends it
+				set_color(bx, color_of(px));
+				set_color(px, RBBk);
+				set_color(oppoX, RBBk);
+
+				if (IsXLeftChild)
+				{
+					this->DoRotateLeft(px);
+				}
+				else
+				{
+					this->DoRotateRight(px);
 				}
+
+				x = this->DoRoot();
+				break;
 			}
 
-			if (double_black) set_color(double_black, RBBk);
+			set_color(x, RBBk);
 		}
 
 		// RB_Tree Verification
@@ -602,13 +1125,22 @@ namespace mstl {
 			bool ok = true;
 
 			// 1. Root is black
-			if (this->mp_Root && color_of(this->mp_Root) != RBBk) {
+			if (this->DoRoot() && color_of(this->DoRoot()) != RBBk) {
 				std::cerr << "[RB VERIFY] Root is not black!\n";
 				ok = false;
 			}
 
 			int black_height = -1;
-			if (!verify_node_rec(this->mp_Root, 0, black_height)) {
+			if (!verify_node_rec(this->DoRoot(), 0, black_height)) {
+				ok = false;
+			}
+
+			// Header caches
+			const base_node_type* header = this->DoHeader();
+			const base_node_type* root = this->DoRoot();
+			if (this->mp_Leftmost != (root ? mstl::TreeMin(root) : header)
+				|| header->mp_Right != (root ? mstl::TreeMax(root) : header)) {
+				std::cerr << "[RB VERIFY] Cached leftmost/rightmost mismatch\n";
 				ok = false;
 			}
 
@@ -628,11 +1160,11 @@ namespace mstl {
 			}
 
 			// Check parent linkage consistency
-			if (node->mp_Left && node->mp_Left->mp_Parent != node) {
+			if (node->mp_Left && mstl::TreeParent(node->mp_Left) != node) {
 				std::cerr << "[RB VERIFY] Left child parent pointer mismatch at node\n";
 				return false;
 			}
-			if (node->mp_Right && node->mp_Right->mp_Parent != node) {
+			if (node->mp_Right && mstl::TreeParent(node->mp_Right) != node) {
 				std::cerr << "[RB VERIFY] Right child parent pointer mismatch at node\n";
 				return false;
 			}
@@ -686,7 +1218,7 @@ namespace mstl {
 			std::cout << " (" << relation << ")\n";
 
 			// === Color ===
-			std::cout << "Color: " << (n->m_Color == RBBk ? "Black" : "Red") << "\n";
+			std::cout << "Color: " << (color_of(n) == RBBk ? "Black" : "Red") << "\n";
 
 			// === Parent ===
 			if (p) {
@@ -0,0 +1,220 @@
+#ifndef MSTL_RELOCATE_H
+#define MSTL_RELOCATE_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Trivial relocation
+	/// ---------------------------------------------------------------
+	/// Relocating an object = move-constructing it somewhere else and
+	/// destroying the source. For most types (anything that doesn't
+	/// point into itself) that pair is equivalent to copying the bytes,
+	/// so contiguous containers can grow with one memcpy.
+	///
+	/// Defaults to trivially copyable types. Specialize it for types
+	/// known to be safe to move by memcpy, e.g.:
+	///   template<> struct mstl::is_trivially_relocatable<my_handle> : std::true_type {};
+	///
+	/// [!] not every std type qualifies: libstdc++ std::string keeps a
+	///     pointer to its own small buffer.
+
+	template<typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+	template<typename T>
+	inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+	/// True when allocator_traits<A>::construct/destroy would fall back
+	/// to placement new / ~T(): only then bytes may be copied around
+	/// without asking the allocator.
+	template<typename A, typename T>
+	inline constexpr bool alloc_default_construct =
+		!requires(A& a, T* p) { a.construct(p, std::declval<T&&>()); } &&
+		!requires(A& a, T* p) { a.destroy(p); };
+
+	template<typename A, typename T = typename std::allocator_traits<A>::value_type>
+	inline constexpr bool relocate_by_memcpy = is_trivially_relocatable_v<T> && alloc_default_construct<A, T>;
+
+	template<typename A, typename T = typename std::allocator_traits<A>::value_type>
+	inline constexpr bool copy_by_memcpy = std::is_trivially_copyable_v<T> && alloc_default_construct<A, T>;
+
+	/// ---------------------------------------------------------------
+	/// Relocation helpers (shared by the contiguous containers)
+	/// ---------------------------------------------------------------
+
+	/// Geometric growth: doubles cap (starting from first_cap when
+	/// empty) but gives at least room for extra more elements.
+	/// Throws length_error past max_size.
+	template<typename S>
+	inline S NextCapacity(S size, S cap, S extra, S max_size, S first_cap)
+	{
+		if (extra >= max_size - size)
+			throw std::length_error{ "mstl: size exceeds max_size" };
+
+		const S grown = cap ? (cap < max_size / 2 ? 2 * cap : max_size) : first_cap;
+		return std::max(grown, size + extra);
+	}
+
+	/// Copies [src, src + n) into the raw, non-overlapping dst.
+	/// Strong guarantee: on exception dst is left empty.
+	template<typename A, typename T>
+	inline void UninitializedCopyN(A& alloc, const T* src, std::size_t n, T* dst)
+	{
+		using traits = std::allocator_traits<A>;
+
+		if constexpr (copy_by_memcpy<A, T>)
+		{
+			if (n) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+		}
+		else
+		{
+			std::size_t i = 0;
+
+			try {
+				for (; i < n; ++i)
+					traits::construct(alloc, dst + i, src[i]);
+			}
+			catch (...)
+			{
+				while (i > 0) traits::destroy(alloc, dst + --i);
+				throw;
+			}
+		}
+	}
+
+	template<typename A, typename T>
+	inline void DestroyN(A& alloc, T* p, std::size_t n) noexcept
+	{
+		if constexpr (!std::is_trivially_destructible_v<T> || !alloc_default_construct<A, T>)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				std::allocator_traits<A>::destroy(alloc, p + i);
+		}
+	}
+
+	/// Moves (copies, if the move may throw) [src, src + n) into the
+	/// raw, non-overlapping dst. src is left alive.
+	/// Strong guarantee: on exception dst is left empty.
+	template<typename A, typename T>
+	inline void UninitializedMoveIfNoexceptN(A& alloc, T* src, std::size_t n, T* dst)
+	{
+		using traits = std::allocator_traits<A>;
+
+		std::size_t i = 0;
+
+		try {
+			for (; i < n; ++i)
+				traits::construct(alloc, dst + i, std::move_if_noexcept(src[i]));
+		}
+		catch (...)
+		{
+			while (i > 0) traits::destroy(alloc, dst + --i);
+			throw;
+		}
+	}
+
+	/// Relocates [src, src + n) into the raw, non-overlapping dst.
+	/// Afterwards src is raw memory.
+	/// Strong guarantee: elements are moved only when that can't throw
+	/// (copied otherwise) and src is destroyed only once all of dst
+	/// is built, so on exception src is untouched.
+	template<typename A, typename T>
+	inline void RelocateN(A& alloc, T* src, std::size_t n, T* dst)
+	{
+		if constexpr (relocate_by_memcpy<A, T>)
+		{
+			if (n) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+		}
+		else
+		{
+			UninitializedMoveIfNoexceptN(alloc, src, n, dst);
+			DestroyN(alloc, src, n);
+		}
+	}
+
+	/// Growth with new elements: fill(dst + index) builds n elements
+	/// (all or none) in the raw buffer dst, then [src, src + size) is
+	/// relocated around them. fill runs first, so it may read from
+	/// src (e.g. push_back(v[0]) on a full vector). index == size,
+	/// n == 1 is emplace_back. Afterwards src is raw memory.
+	/// Strong guarantee: on exception dst is left empty, src untouched.
+	template<typename A, typename T, typename Fill>
+	inline void RelocateAroundGap(A& alloc, T* src, std::size_t size, std::size_t index, std::size_t n, T* dst, Fill&& fill)
+	{
+		fill(dst + index);
+
+		if constexpr (relocate_by_memcpy<A, T>)
+		{
+			RelocateN(alloc, src, index, dst);
+			RelocateN(alloc, src + index, size - index, dst + index + n);
+		}
+		else
+		{
+			try {
+				UninitializedMoveIfNoexceptN(alloc, src, index, dst);
+			}
+			catch (...)
+			{
+				DestroyN(alloc, dst + index, n);
+				throw;
+			}
+
+			try {
+				UninitializedMoveIfNoexceptN(alloc, src + index, size - index, dst + index + n);
+			}
+			catch (...)
+			{
+				DestroyN(alloc, dst, index + n);
+				throw;
+			}
+
+			DestroyN(alloc, src, size);
+		}
+	}
+
+	/// Insertion without growth: the buffer at elem has room for size
+	/// + n elements, fill(gap) builds n (all or none) at index and
+	/// size grows by n. memcpy types shift the tail and fill the gap;
+	/// the others are built past the end and rotated into place, so
+	/// fill never sees a moved-from slot.
+	/// Strong guarantee if fill throws, basic if a move in rotate does.
+	template<typename A, typename T, typename S, typename Fill>
+	inline void InsertGapInPlace(A&, T* elem, S& size, std::size_t index, std::size_t n, Fill&& fill)
+	{
+		T* gap = elem + index;
+
+		if constexpr (relocate_by_memcpy<A, T>)
+		{
+			const std::size_t tail = (size - index) * sizeof(T);
+			if (tail) std::memmove(static_cast<void*>(gap + n), static_cast<const void*>(gap), tail);
+
+			try {
+				fill(gap);
+			}
+			catch (...)
+			{
+				if (tail) std::memmove(static_cast<void*>(gap), static_cast<const void*>(gap + n), tail);
+				throw;
+			}
+
+			size += n;
+		}
+		else
+		{
+			const std::size_t old_size = size;
+			fill(elem + old_size);
+			size += n;
+			std::rotate(gap, elem + old_size, elem + size);
+		}
+	}
+}
+
+#endif // !MSTL_RELOCATE_H
@@ -0,0 +1,110 @@
+#ifndef MSTL_TRACE_H
+#define MSTL_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+
+/// Build with -DMSTL_TRACE=1 to count allocations of every container;
+/// by default the hooks are empty inline calls and compile away.
+#ifndef MSTL_TRACE
+#define MSTL_TRACE 0
+#endif
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Allocation tracing
+	/// ---------------------------------------------------------------
+	/// Containers report from their allocation paths (vector_rep,
+	/// list_rep, tree_base) to trace_hook_t<Tag>, Tag being the rep
+	/// type, so every instantiation gets its own counters:
+	///
+	///   mstl::vector<int>::trace::stats().growths
+	///
+	/// growths / bytes_relocated are only reported by the contiguous
+	/// containers, when a reallocation moves the old elements.
+
+	struct trace_stats {
+		std::size_t allocations{};
+		std::size_t deallocations{};
+		std::size_t bytes_allocated{};
+		std::size_t growths{};
+		std::size_t bytes_relocated{};
+	};
+
+	// default hook: does nothing
+	struct null_trace {
+
+		static constexpr bool enabled = false;
+
+		static void on_allocate(std::size_t) noexcept {}
+		static void on_deallocate(std::size_t) noexcept {}
+		static void on_grow(std::size_t) noexcept {}
+
+		static trace_stats stats() noexcept { return {}; }
+		static void reset() noexcept {}
+	};
+
+	// counting hook: relaxed atomics, one set of counters per Tag
+	template<typename Tag>
+	struct counting_trace {
+
+		static constexpr bool enabled = true;
+
+		static void on_allocate(std::size_t bytes) noexcept {
+			m_Allocations.fetch_add(1, std::memory_order_relaxed);
+			m_BytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		static void on_deallocate(std::size_t) noexcept {
+			m_Deallocations.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static void on_grow(std::size_t bytes_relocated) noexcept {
+			m_Growths.fetch_add(1, std::memory_order_relaxed);
+			m_BytesRelocated.fetch_add(bytes_relocated, std::memory_order_relaxed);
+		}
+
+		static trace_stats stats() noexcept {
+			return {
+				m_Allocations.load(std::memory_order_relaxed),
+				m_Deallocations.load(std::memory_order_relaxed),
+				m_BytesAllocated.load(std::memory_order_relaxed),
+				m_Growths.load(std::memory_order_relaxed),
+				m_BytesRelocated.load(std::memory_order_relaxed)
+			};
+		}
+
+		static void reset() noexcept {
+			m_Allocations.store(0, std::memory_order_relaxed);
+			m_Deallocations.store(0, std::memory_order_relaxed);
+			m_BytesAllocated.store(0, std::memory_order_relaxed);
+			m_Growths.store(0, std::memory_order_relaxed);
+			m_BytesRelocated.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static inline std::atomic<std::size_t> m_Allocations{};
+		static inline std::atomic<std::size_t> m_Deallocations{};
+		static inline std::atomic<std::size_t> m_BytesAllocated{};
+		static inline std::atomic<std::size_t> m_Growths{};
+		static inline std::atomic<std::size_t> m_BytesRelocated{};
+	};
+
+	/// Hook used by the containers. Follows MSTL_TRACE, and can be
+	/// specialized to trace (or silence) a single container type:
+	///   template<> struct mstl::trace_hook<mstl::vector_rep<int>> { using type = mstl::counting_trace<mstl::vector_rep<int>>; };
+	template<typename Tag>
+	struct trace_hook {
+#if MSTL_TRACE
+		using type = counting_trace<Tag>;
+#else
+		using type = null_trace;
+#endif
+	};
+
+	template<typename Tag>
+	using trace_hook_t = typename trace_hook<Tag>::type;
+}
+
+#endif // !MSTL_TRACE_H
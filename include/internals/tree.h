@@ -7,6 +7,13 @@
 #include <utility>
 #include <iterator>
 #include <cstddef> 
+#include <vector>
+#include <bit>
+#include <concepts>
+#include <optional>
+#include <cassert>
+#include "trace.h"
+#include "relocate.h"
 
 namespace mstl {
 
@@ -45,6 +52,49 @@ namespace mstl {
 		}
 	};
 
+	/// ---------------------------------------------------------------
+	/// Parent link
+	/// ---------------------------------------------------------------
+	/// The shared helpers read and write the parent through these, so
+	/// a node may keep other bits in the parent word: a base node
+	/// exposing parent() / set_parent() is used through them
+	/// (rb_compact_node stores its color in bit 0), any other one
+	/// through mp_Parent.
+
+	template<typename BaseNodeT>
+	concept PackedParentNode = requires(BaseNodeT* n, const BaseNodeT* cn) {
+		{ cn->parent() } -> std::same_as<BaseNodeT*>;
+		n->set_parent(n);
+	};
+
+	template <typename BaseNodeT>
+	inline BaseNodeT* TreeParent(const BaseNodeT* n) noexcept {
+		if constexpr (PackedParentNode<BaseNodeT>) return n->parent();
+		else return n->mp_Parent;
+	}
+
+	template <typename BaseNodeT>
+	inline void TreeSetParent(BaseNodeT* n, std::type_identity_t<BaseNodeT>* p) noexcept {
+		if constexpr (PackedParentNode<BaseNodeT>) n->set_parent(p);
+		else n->mp_Parent = p;
+	}
+
+	/// ---------------------------------------------------------------
+	/// Sorted input tag
+	/// ---------------------------------------------------------------
+	/// Selects the constructors that trust the input to be sorted by
+	/// key and free of duplicates (same idea of C++23 sorted_unique_t),
+	/// so the tree can be built bottom-up in O(n).
+
+	struct sorted_unique_t { explicit sorted_unique_t() = default; };
+
+	inline constexpr sorted_unique_t sorted_unique{};
+
+	// sorted, equal keys allowed (multiset, C++23 sorted_equivalent_t)
+	struct sorted_equivalent_t { explicit sorted_equivalent_t() = default; };
+
+	inline constexpr sorted_equivalent_t sorted_equivalent{};
+
 	/// ---------------------------------------------------------------
 	/// Key extractors
 	/// ---------------------------------------------------------------
@@ -61,6 +111,18 @@ namespace mstl {
 		constexpr const auto& operator()(const Pair& p) const noexcept { return p.first; }
 	};
 
+	/// ---------------------------------------------------------------
+	/// Heterogeneous lookup
+	/// ---------------------------------------------------------------
+	/// A comparator declaring is_transparent (std::less<>, ...) makes
+	/// the lookups and erase-by-key also take any K comparable with
+	/// the key, e.g. std::string_view or const char* on std::string
+	/// keys: no key_type temporary is built per query. The Tree*
+	/// functions below are already generic on the key type.
+
+	template<typename Compare>
+	concept TransparentCompare = requires { typename Compare::is_transparent; };
+
 	/// ---------------------------------------------------------------
 	/// Tree global functions
 	/// ---------------------------------------------------------------
@@ -87,6 +149,20 @@ namespace mstl {
 		return node;
 	}
 
+	/// Header sentinel layout (see tree_base):
+	///   header.mp_Left   -> root (root.mp_Parent == &header)
+	///   header.mp_Right  -> rightmost node (cached, not a child)
+	///   header.mp_Parent == nullptr, only the header has no parent
+	/// 
+	/// The root being the left child of the header makes rotations and
+	/// transplants at the root update it for free, and the successor of
+	/// the rightmost node is the header, that is end().
+
+	template <typename BaseNodeT>
+	inline bool TreeIsHeader(const BaseNodeT* n) noexcept {
+		return !TreeParent(n);
+	}
+
 	template <typename BaseNodeT>
 	inline BaseNodeT* TreeSuccessor(BaseNodeT* n) noexcept {
 
@@ -99,12 +175,14 @@ namespace mstl {
 		}
 
 		// Case 2: go up until you are left child 
-		auto* p = n->mp_Parent;
+		// (stop at the header: its mp_Right is the rightmost
+		// node, not a real child)
+		auto* p = TreeParent(n);
 
-		while (p && n == p->mp_Right)
+		while (!TreeIsHeader(p) && n == p->mp_Right)
 		{
 			n = p;
-			p = p->mp_Parent;
+			p = TreeParent(p);
 		}
 
 		return p;
@@ -115,53 +193,58 @@ namespace mstl {
 
 		if (!n) return nullptr;
 
+		// --end(): the header caches the rightmost node, O(1)
+		if (TreeIsHeader(n))
+		{
+			return n->mp_Right;
+		}
+
 		if (n->mp_Left)
 		{
 			return TreeMax(n->mp_Left);
 		}
 
-		auto* p = n->mp_Parent;
+		auto* p = TreeParent(n);
 
 		while (p && n == p->mp_Left) 
 		{
 			n = p;
-			p = p->mp_Parent;
+			p = TreeParent(p);
 		}
 
 		return p;
 	}
 
 	// Tree Transplant
-	template <typename RootNodeT, typename BaseNodeT>
-	inline void TreeTransplant(RootNodeT*& root, BaseNodeT* a, BaseNodeT* b) noexcept
+	// (if a is the root its parent is the header and
+	// header.mp_Left, the root, is updated as a left child)
+	template <typename BaseNodeT>
+	inline void TreeTransplant(BaseNodeT* a, BaseNodeT* b) noexcept
 	{
 		if (!a) return;
 
-		if (!a->mp_Parent)
-		{
-			// a was root
-			root = static_cast<RootNodeT*>(b);
-		}
-		else if (a == a->mp_Parent->mp_Left)
+		if (a == TreeParent(a)->mp_Left)
 		{
-			// a was a left child
-			a->mp_Parent->mp_Left = b;
+			// a was a left child (or the root)
+			TreeParent(a)->mp_Left = b;
 		}
 		else
 		{
 			// a was a right child
-			a->mp_Parent->mp_Right = b;
+			TreeParent(a)->mp_Right = b;
 		}
 
 		if (b)
 		{
 			// update parent
-			b->mp_Parent = a->mp_Parent;
+			TreeSetParent(b, TreeParent(a));
 		}
 	}
 
 	// Tree Rotations
 	// both returns the root of the subtree passed
+	// (rotating the root updates header.mp_Left, the left
+	// check must come first since header.mp_Right can be x)
 
 	template <typename BaseNodeT>
 	inline  BaseNodeT* TreeRotateLeft(BaseNodeT* x) noexcept {
@@ -174,27 +257,27 @@ namespace mstl {
 		if (y)
 		{
 			y->mp_Left = x;
-			y->mp_Parent = x->mp_Parent;
+			TreeSetParent(y, TreeParent(x));
 		}
 
 		// adjust parent pointers
-		if (x->mp_Parent)
+		if (TreeParent(x))
 		{
-			if (x->mp_Parent->mp_Left == x)
+			if (TreeParent(x)->mp_Left == x)
 			{
 				// if x was left child
-				x->mp_Parent->mp_Left = y;
+				TreeParent(x)->mp_Left = y;
 			}
 			else
 			{
 				// if x was right child
-				x->mp_Parent->mp_Right = y;
+				TreeParent(x)->mp_Right = y;
 			}	
 		}
 
-		x->mp_Parent = y;
+		TreeSetParent(x, y);
 
-		if (w) w->mp_Parent = x;
+		if (w) TreeSetParent(w, x);
 
 		return y;
 	}
@@ -210,27 +293,27 @@ namespace mstl {
 		if (y)
 		{
 			y->mp_Right = x;
-			y->mp_Parent = x->mp_Parent;
+			TreeSetParent(y, TreeParent(x));
 		}
 
 		// adjust parent pointers
-		if (x->mp_Parent)
+		if (TreeParent(x))
 		{
-			if (x->mp_Parent->mp_Left == x)
+			if (TreeParent(x)->mp_Left == x)
 			{
 				// if x was left child
-				x->mp_Parent->mp_Left = y;
+				TreeParent(x)->mp_Left = y;
 			}
 			else
 			{
 				// if x was right child
-				x->mp_Parent->mp_Right = y;
+				TreeParent(x)->mp_Right = y;
 			}
 		}
 
-		x->mp_Parent = y;
+		TreeSetParent(x, y);
 
-		if (w) w->mp_Parent = x;
+		if (w) TreeSetParent(w, x);
 
 		return y;
 	}
@@ -311,6 +394,75 @@ namespace mstl {
 		return res;
 	}
 
+	/// ---------------------------------------------------------------
+	/// Order statistics
+	/// ---------------------------------------------------------------
+	/// Optional augmentation: a node type exposing m_Count (size of
+	/// the subtree rooted in it) enables rank/select in O(log n).
+	/// Trees check the policy at compile time, so node types without
+	/// m_Count pay nothing (see rb_os_node, avl_os_node).
+
+	template<typename NodeT>
+	concept OrderStatisticNode = requires(const NodeT& n) {
+		{ n.m_Count } -> std::convertible_to<std::size_t>;
+	};
+
+	template <typename NodeT, typename BaseNodeT>
+	inline std::size_t TreeCount(const BaseNodeT* n) noexcept {
+		return n ? static_cast<const NodeT*>(n)->m_Count : 0;
+	}
+
+	template <typename NodeT, typename BaseNodeT>
+	inline void TreeUpdateCount(BaseNodeT* n) noexcept {
+		static_cast<NodeT*>(n)->m_Count = 1 + TreeCount<NodeT>(n->mp_Left) + TreeCount<NodeT>(n->mp_Right);
+	}
+
+	// k-th smallest node (0-based) of the subtree, nullptr if k >= size
+	template <typename NodeT, typename BaseNodeT>
+	inline BaseNodeT* TreeSelect(BaseNodeT* root, std::size_t k) noexcept {
+
+		while (root)
+		{
+			const std::size_t left = TreeCount<NodeT>(root->mp_Left);
+
+			if (k < left)
+			{
+				root = root->mp_Left;
+			}
+			else if (k > left)
+			{
+				k -= left + 1;
+				root = root->mp_Right;
+			}
+			else
+			{
+				return root;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// in-order position of n: count the nodes on its left while
+	// climbing to the header (the header itself has rank == size)
+	template <typename NodeT, typename BaseNodeT>
+	inline std::size_t TreeRank(const BaseNodeT* n) noexcept {
+
+		if (TreeIsHeader(n)) return TreeCount<NodeT>(n->mp_Left);
+
+		std::size_t rank = TreeCount<NodeT>(n->mp_Left);
+
+		for (const BaseNodeT* p = TreeParent(n); !TreeIsHeader(p); n = p, p = TreeParent(p))
+		{
+			if (n == p->mp_Right)
+			{
+				rank += TreeCount<NodeT>(p->mp_Left) + 1;
+			}
+		}
+
+		return rank;
+	}
+
 	/// ---------------------------------------------------------------
 	/// Tree Iterator
 	/// ---------------------------------------------------------------
@@ -361,7 +513,7 @@ namespace mstl {
 			return *this;
 		}
 
-		tree_iterator& operator++(int) noexcept {
+		tree_iterator operator++(int) noexcept {
 
 			tree_iterator tmp = *this;
 			++(*this);
@@ -392,12 +544,93 @@ namespace mstl {
 		friend class tree_iterator;
 	};
 
+	/// ---------------------------------------------------------------
+	/// Node handle
+	/// ---------------------------------------------------------------
+	/// Owns a node taken out of a tree by extract(): the value stays
+	/// in the node and goes back into a tree of the same type through
+	/// insert(node handle), with no allocation and no copy (the trees
+	/// must have equal allocators). Move only, a handle still holding
+	/// a node destroys it. An empty handle holds no allocator either:
+	/// making one never allocates (node_pool_allocator's default
+	/// constructor does).
+
+	template<typename NodeType, typename NodeAlloc, typename Trace>
+	class tree_node_handle {
+
+		using node_traits = std::allocator_traits<NodeAlloc>;
+
+	public:
+
+		using value_type = typename NodeType::value_type;
+
+		tree_node_handle() = default;
+
+		tree_node_handle(tree_node_handle&& other) noexcept
+			: mp_Node{ other.mp_Node }
+			, m_Alloc{ std::move(other.m_Alloc) } {
+			other.mp_Node = nullptr;
+			other.m_Alloc.reset();
+		}
+
+		tree_node_handle& operator=(tree_node_handle&& other) noexcept {
+
+			if (this != &other)
+			{
+				reset();
+				mp_Node = other.mp_Node;
+				m_Alloc = std::move(other.m_Alloc);
+				other.mp_Node = nullptr;
+				other.m_Alloc.reset();
+			}
+			return *this;
+		}
+
+		~tree_node_handle() { reset(); }
+
+		bool empty() const noexcept { return mp_Node == nullptr; }
+		explicit operator bool() const noexcept { return mp_Node != nullptr; }
+
+		// the key can be changed before the node goes back in a tree
+		value_type& value() const noexcept { return mp_Node->m_Val; }
+
+	private:
+
+		NodeType* mp_Node{};
+		std::optional<NodeAlloc> m_Alloc{};   // engaged iff mp_Node
+
+		tree_node_handle(NodeType* n, const NodeAlloc& a) noexcept
+			: mp_Node{ n }
+			, m_Alloc{ a } {
+		}
+
+		void reset() noexcept {
+
+			if (!mp_Node) return;
+
+			node_traits::destroy(*m_Alloc, mp_Node);
+			node_traits::deallocate(*m_Alloc, mp_Node, 1);
+			Trace::on_deallocate(sizeof(NodeType));
+			mp_Node = nullptr;
+			m_Alloc.reset();
+		}
+
+		template<typename, template<class> class, typename, typename, typename>
+		friend class tree_base;
+	};
+
 	/// ---------------------------------------------------------------
 	/// Tree base
 	/// ---------------------------------------------------------------
 	/// Handles allocation, comparison, node destruction.
 	/// It is designed to be inherited by specialized trees
 	/// such as bst_tree, avl_tree, rb_tree, map, multimap, etc.
+	/// 
+	/// Nodes hang from an embedded header node (end()): the root is
+	/// header.mp_Left, header.mp_Right caches the rightmost node and
+	/// mp_Leftmost the leftmost one, so begin(), --end() and rbegin()
+	/// are O(1). Derived trees keep the cache valid through
+	/// DoAttachNode (insert) and DoDetachExtremes (erase).
 	/// ---------------------------------------------------------------
 
 	template<
@@ -423,10 +656,15 @@ namespace mstl {
 		using node_type   = NodeT<value_type>;
 		using node_alloc  = typename alloc_traits::template rebind_alloc<node_type>;
 		using node_traits = std::allocator_traits<node_alloc>;
+		using trace       = trace_hook_t<tree_base>;    // null_trace unless MSTL_TRACE
+		using node_handle = tree_node_handle<node_type, node_alloc, trace>;
 
 		using iterator       = tree_iterator<node_type, false>;
 		using const_iterator = tree_iterator<node_type, true>;
 
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
 
 		// ============== Ctors =================
 
@@ -434,68 +672,81 @@ namespace mstl {
 			: m_ValueAlloc{ alloc_type{} }
 			, m_NodeAlloc{ m_ValueAlloc }
 			, m_Comp{ key_compare{} }
-			, m_Size{ 0 }
-			, mp_Root{ nullptr } {
+			, m_Size{ 0 } {
+			DoResetHeader();
 		}
 
 		explicit tree_base(const alloc_type& i_alloc)
 			: m_ValueAlloc{ i_alloc }
 			, m_NodeAlloc{ m_ValueAlloc }
 			, m_Comp{ key_compare{} }
-			, m_Size{ 0 }
-			, mp_Root{ nullptr } {
+			, m_Size{ 0 } {
+			DoResetHeader();
 		}
 
 		explicit tree_base(const alloc_type& i_alloc, const key_compare& i_comp)
 			: m_ValueAlloc{ i_alloc }
 			, m_NodeAlloc{ m_ValueAlloc }
 			, m_Comp{ i_comp }
-			, m_Size{ 0 }
-			, mp_Root{ nullptr } {
+			, m_Size{ 0 } {
+			DoResetHeader();
 		}
 
+		// the header links back to this object:
+		// derived trees copy/move through their own ctors
+		tree_base(const tree_base&) = delete;
+		tree_base& operator=(const tree_base&) = delete;
+
 		// === Destructor ===
 
 		~tree_base() { DoClear(); }
 
 		// ============== Iterators =================
 
-		iterator begin() noexcept { return iterator{ mstl::TreeMin<base_node_type>(mp_Root) }; }
-		const_iterator begin() const noexcept { return const_iterator{ mstl::TreeMin<base_node_type>(mp_Root) }; }
-		const_iterator cbegin() const noexcept { return const_iterator{ mstl::TreeMin<base_node_type>(mp_Root) }; }
+		iterator begin() noexcept { return iterator{ mp_Leftmost }; }
+		const_iterator begin() const noexcept { return const_iterator{ mp_Leftmost }; }
+		const_iterator cbegin() const noexcept { return const_iterator{ mp_Leftmost }; }
+
+		iterator end() noexcept { return iterator{ DoHeader() }; }
+		const_iterator end() const noexcept { return const_iterator{ DoHeader() }; }
+		const_iterator cend() const noexcept { return const_iterator{ DoHeader() }; }
 
-		iterator end() noexcept { return iterator{ nullptr }; }
-		const_iterator end() const noexcept { return const_iterator{ nullptr }; }
-		const_iterator cend() const noexcept { return const_iterator{ nullptr }; }
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator{ end() }; }
+
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return const_reverse_iterator{ begin() }; }
 
 		// ============== Lookups =================
 
 		iterator find(const key_type& key) noexcept {
-			return iterator{ mstl::TreeFind<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return iterator{ DoNodeOrEnd(mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		const_iterator find(const key_type& key) const noexcept {
-			return const_iterator{ mstl::TreeFind<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return const_iterator{ DoNodeOrEnd(mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		iterator lower_bound(const key_type& key) noexcept {
-			return iterator{ mstl::TreeLowerBound<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return iterator{ DoNodeOrEnd(mstl::TreeLowerBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		const_iterator lower_bound(const key_type& key) const noexcept {
-			return const_iterator{ mstl::TreeLowerBound<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return const_iterator{ DoNodeOrEnd(mstl::TreeLowerBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		iterator upper_bound(const key_type& key) noexcept {
-			return iterator{ mstl::TreeUpperBound<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return iterator{ DoNodeOrEnd(mstl::TreeUpperBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		const_iterator upper_bound(const key_type& key) const noexcept {
-			return const_iterator{ mstl::TreeUpperBound<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) };
+			return const_iterator{ DoNodeOrEnd(mstl::TreeUpperBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
 		}
 
 		bool contains(const key_type& key) const noexcept {
-			return mstl::TreeFind<node_type, base_node_type>(mp_Root, key, m_KeyExtractor, m_Comp) != nullptr;
+			return mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp) != nullptr;
 		}
 
 		std::pair<iterator, iterator> equal_range(const key_type& key) noexcept {
@@ -506,6 +757,94 @@ namespace mstl {
 			return { lower_bound(key), upper_bound(key) };
 		}
 
+		// ============== Heterogeneous lookups =================
+		// transparent comparators only, see TransparentCompare
+
+		// erase(const K&) and extract(const K&) must not catch iterators
+		template<typename K>
+		static constexpr bool is_heterogeneous_key = TransparentCompare<key_compare>
+			&& !std::is_convertible_v<const K&, iterator>
+			&& !std::is_convertible_v<const K&, const_iterator>;
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator find(const K& key) noexcept {
+			return iterator{ DoNodeOrEnd(mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator find(const K& key) const noexcept {
+			return const_iterator{ DoNodeOrEnd(mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator lower_bound(const K& key) noexcept {
+			return iterator{ DoNodeOrEnd(mstl::TreeLowerBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator lower_bound(const K& key) const noexcept {
+			return const_iterator{ DoNodeOrEnd(mstl::TreeLowerBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		iterator upper_bound(const K& key) noexcept {
+			return iterator{ DoNodeOrEnd(mstl::TreeUpperBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		const_iterator upper_bound(const K& key) const noexcept {
+			return const_iterator{ DoNodeOrEnd(mstl::TreeUpperBound<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp)) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		bool contains(const K& key) const noexcept {
+			return mstl::TreeFind<node_type, base_node_type>(DoRoot(), key, m_KeyExtractor, m_Comp) != nullptr;
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		std::pair<iterator, iterator> equal_range(const K& key) noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		template<typename K> requires TransparentCompare<key_compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const noexcept {
+			return { lower_bound(key), upper_bound(key) };
+		}
+
+		// ============== Observers =================
+
+		key_compare key_comp() const { return m_Comp; }
+		value_compare value_comp() const { return m_Comp; }
+
+		// ============== Order statistics =================
+		// available with node types carrying m_Count, O(log n)
+
+		static constexpr bool has_order_statistics = OrderStatisticNode<node_type>;
+
+		// number of elements with key less than key
+		size_type rank(const key_type& key) const noexcept requires has_order_statistics {
+			return index_of(lower_bound(key));
+		}
+
+		// k-th smallest element (0-based), end() if k >= size()
+		iterator select(size_type k) noexcept requires has_order_statistics {
+			return iterator{ DoNodeOrEnd(mstl::TreeSelect<node_type, base_node_type>(DoRoot(), k)) };
+		}
+
+		const_iterator select(size_type k) const noexcept requires has_order_statistics {
+			return const_iterator{ DoNodeOrEnd(mstl::TreeSelect<node_type, base_node_type>(DoRoot(), k)) };
+		}
+
+		// position of it in the sequence, end() gives size()
+		size_type index_of(const_iterator it) const noexcept requires has_order_statistics {
+			return mstl::TreeRank<node_type, base_node_type>(DoIterNode(it));
+		}
+
+		// same as std::distance(first, last), in O(log n)
+		difference_type distance(const_iterator first, const_iterator last) const noexcept requires has_order_statistics {
+			return static_cast<difference_type>(index_of(last)) - static_cast<difference_type>(index_of(first));
+		}
+
 	protected:
 
 		using base_node_type = typename node_type::base_type;
@@ -515,17 +854,710 @@ namespace mstl {
 		[[no_unique_address]] key_compare m_Comp{};
 		[[no_unique_address]] KeyOfValue  m_KeyExtractor{};
 
-		size_type  m_Size{};
-		node_type* mp_Root{};
+		size_type       m_Size{};
+		base_node_type  m_Header{};        // end(), see the layout above
+		base_node_type* mp_Leftmost{};     // begin()
+
+		// ================= Header =================
+
+		base_node_type* DoHeader() const noexcept {
+			return const_cast<base_node_type*>(&m_Header);
+		}
+
+		node_type* DoRoot() const noexcept {
+			return static_cast<node_type*>(m_Header.mp_Left);
+		}
+
+		base_node_type* DoNodeOrEnd(base_node_type* n) const noexcept {
+			return n ? n : DoHeader();
+		}
+
+		// iterators only befriend tree_base
+		static base_node_type* DoIterNode(const_iterator it) noexcept {
+			return it.curr;
+		}
+
+		// empty tree: begin() == end() == header
+		void DoResetHeader() noexcept {
+			m_Header.mp_Left = nullptr;
+			m_Header.mp_Right = DoHeader();
+			mstl::TreeSetParent(&m_Header, nullptr);
+			mp_Leftmost = DoHeader();
+		}
+
+		// hooks a (detached) subtree under the header and
+		// recomputes the cached extremes, O(log n)
+		void DoSetRoot(base_node_type* root) noexcept {
+
+			if (!root)
+			{
+				DoResetHeader();
+				return;
+			}
+
+			m_Header.mp_Left = root;
+			mstl::TreeSetParent(root, DoHeader());
+			m_Header.mp_Right = mstl::TreeMax(root);
+			mp_Leftmost = mstl::TreeMin(root);
+		}
+
+		/// Links a new node as child of parent (the header when the
+		/// tree is empty) and keeps leftmost/rightmost up to date.
+		/// Rebalancing is left to the caller.
+		void DoAttachNode(base_node_type* n, base_node_type* parent, bool as_left) noexcept {
+
+			mstl::TreeSetParent(n, parent);
+			n->mp_Left = n->mp_Right = nullptr;
+
+			if (parent == DoHeader())
+			{
+				m_Header.mp_Left = n;
+				m_Header.mp_Right = n;
+				mp_Leftmost = n;
+			}
+			else if (as_left)
+			{
+				parent->mp_Left = n;
+				if (parent == mp_Leftmost) mp_Leftmost = n;
+			}
+			else
+			{
+				parent->mp_Right = n;
+				if (parent == m_Header.mp_Right) m_Header.mp_Right = n;
+			}
+
+			++m_Size;
+
+			if constexpr (has_order_statistics)
+			{
+				static_cast<node_type*>(n)->m_Count = 1;
+				for (base_node_type* p = parent; !mstl::TreeIsHeader(p); p = mstl::TreeParent(p))
+					++static_cast<node_type*>(p)->m_Count;
+			}
+		}
+
+		// ================= Insert position =================
+
+		struct insert_position {
+			base_node_type* parent{};
+			bool as_left{};
+			base_node_type* existing{};
+		};
+
+		/// Descent from the root, comparing keys only: where key goes,
+		/// or the node that already holds it (existing).
+		insert_position DoFindInsertPosition(const key_type& key) const noexcept {
+
+			insert_position pos{ DoHeader(), false };
+
+			for (base_node_type* current = DoRoot(); current; )
+			{
+				pos.parent = current;
+
+				if (m_Comp(key, DoKeyOf(current)))
+				{
+					pos.as_left = true;
+					current = current->mp_Left;
+				}
+				else if (m_Comp(DoKeyOf(current), key))
+				{
+					pos.as_left = false;
+					current = current->mp_Right;
+				}
+				else
+				{
+					return { nullptr, false, current };
+				}
+			}
+
+			return pos;
+		}
+
+		/// Where a new key can be linked next to a hint, if the hint is
+		/// right: with unique keys key must fall strictly between hint
+		/// and one of its neighbours, with equal keys allowed it goes as
+		/// close as possible before hint. Only the neighbours are looked
+		/// at (TreePredecessor/TreeSuccessor, amortized O(1) on a sorted
+		/// stream): parent == nullptr means a wrong hint, the caller
+		/// descends from the root; existing is set on a duplicate key.
+
+		// a new node right before next (the header: after the rightmost)
+		insert_position DoPositionBefore(base_node_type* next) const noexcept {
+
+			if (next == DoHeader())
+				return { m_Size ? m_Header.mp_Right : DoHeader(), false };
+
+			if (!next->mp_Left)
+				return { next, true };
+
+			// the predecessor of a node with a left subtree has no right child
+			return { mstl::TreeMax(next->mp_Left), false };
+		}
+
+		insert_position DoHintPosition(base_node_type* hint, const key_type& key, bool unique) const noexcept {
+
+			const bool before = hint == DoHeader()
+				|| (unique ? m_Comp(key, DoKeyOf(hint)) : !m_Comp(DoKeyOf(hint), key));
+
+			if (before)
+			{
+				if (hint == mp_Leftmost) return DoPositionBefore(hint);
+
+				base_node_type* prev = mstl::TreePredecessor(hint);
+
+				if (m_Comp(DoKeyOf(prev), key)) return DoPositionBefore(hint);
+				if (m_Comp(key, DoKeyOf(prev))) return {};
+
+				return unique ? insert_position{ nullptr, false, prev } : DoPositionBefore(hint);
+			}
+
+			if (unique && !m_Comp(DoKeyOf(hint), key)) return { nullptr, false, hint };
+
+			base_node_type* next = mstl::TreeSuccessor(hint);
+
+			if (next == DoHeader() || m_Comp(key, DoKeyOf(next))) return DoPositionBefore(next);
+			if (m_Comp(DoKeyOf(next), key)) return {};
+
+			return unique ? insert_position{ nullptr, false, next } : DoPositionBefore(next);
+		}
+
+		// ================= Node handles =================
+
+		node_handle DoMakeHandle(base_node_type* n) const noexcept {
+			return node_handle(static_cast<node_type*>(n), m_NodeAlloc);
+		}
+
+		// the node goes into this tree, which must be able to free it
+		node_type* DoHandleNode(const node_handle& nh) const noexcept {
+			assert(*nh.m_Alloc == m_NodeAlloc && "tree: node handle from a tree with an unequal allocator");
+			return nh.mp_Node;
+		}
+
+		// the node now belongs to the tree
+		static void DoReleaseHandle(node_handle& nh) noexcept {
+			nh.mp_Node = nullptr;
+			nh.m_Alloc.reset();
+		}
+
+		// ================= Augmentation =================
+
+		/// Rotations used by the balanced trees: the shared
+		/// TreeRotate* plus subtree counts, when maintained.
+		base_node_type* DoRotateLeft(base_node_type* x) noexcept {
+
+			base_node_type* y = mstl::TreeRotateLeft<base_node_type>(x);
+
+			if constexpr (has_order_statistics)
+			{
+				mstl::TreeUpdateCount<node_type>(x);
+				mstl::TreeUpdateCount<node_type>(y);
+			}
+
+			return y;
+		}
+
+		base_node_type* DoRotateRight(base_node_type* x) noexcept {
+
+			base_node_type* y = mstl::TreeRotateRight<base_node_type>(x);
+
+			if constexpr (has_order_statistics)
+			{
+				mstl::TreeUpdateCount<node_type>(x);
+				mstl::TreeUpdateCount<node_type>(y);
+			}
+
+			return y;
+		}
+
+		/// After a node is unlinked: recompute the counts from the
+		/// lowest changed position up to the root.
+		void DoFixCountsUpward(base_node_type* from) noexcept {
+
+			if constexpr (has_order_statistics)
+			{
+				for (base_node_type* p = from; !mstl::TreeIsHeader(p); p = mstl::TreeParent(p))
+					mstl::TreeUpdateCount<node_type>(p);
+			}
+		}
+
+		/// Must be called before a node is unlinked: if it is one of the
+		/// extremes its in-order neighbour takes its place.
+		void DoDetachExtremes(base_node_type* n) noexcept {
+
+			if (m_Size == 1)
+			{
+				mp_Leftmost = DoHeader();
+				m_Header.mp_Right = DoHeader();
+				return;
+			}
+
+			if (n == mp_Leftmost) mp_Leftmost = mstl::TreeSuccessor(n);
+			if (n == m_Header.mp_Right) m_Header.mp_Right = mstl::TreePredecessor(n);
+		}
+
+		/// Swaps the whole state with other, root parent pointers
+		/// and cached extremes are re-targeted to the right header.
+		void DoSwap(tree_base& other) noexcept {
+
+			using std::swap;
+			swap(m_ValueAlloc, other.m_ValueAlloc);
+			swap(m_NodeAlloc, other.m_NodeAlloc);
+			swap(m_Comp, other.m_Comp);
+			swap(m_KeyExtractor, other.m_KeyExtractor);
+			swap(m_Size, other.m_Size);
+
+			base_node_type* root = m_Header.mp_Left;
+			base_node_type* leftmost = mp_Leftmost;
+			base_node_type* rightmost = m_Header.mp_Right;
+
+			DoAdopt(other.m_Header.mp_Left, other.mp_Leftmost, other.m_Header.mp_Right);
+			other.DoAdopt(root, leftmost, rightmost);
+		}
+
+		// ================= Join based algorithms =================
+		/// Split and the set operations written once on top of the join
+		/// of the balanced tree (Blelloch, Ferizovic, Sun, "Just Join for
+		/// Parallel Ordered Sets"): join(l, k, r) links two trees and a
+		/// middle node, with every key of l < k < every key of r, in
+		/// O(|rank(l) - rank(r)| + 1). Everything else only calls join:
+		///
+		///   split        O(log n)
+		///   union        O(m log(n / m + 1)), m <= n the smaller size
+		///   intersection O(m log(n / m + 1))
+		///   difference   O(m log(n / m + 1))
+		///
+		/// They work on detached subtrees (root parent == nullptr)
+		/// carried with their rank, the black height for rb_tree and the
+		/// height for avl_tree. Nodes are relinked, never copied. Tree
+		/// (the derived tree, befriending tree_base) provides:
+		///
+		///   join_piece DoJoin(join_piece l, base_node_type* k, join_piece r)
+		///   int  DoRootRank(base_node_type* root)   // detached tree
+		///   int  DoChildRank(const join_piece& parent, base_node_type* child)
+		///   void DoFixRoot()                         // once hooked
+
+		struct join_piece {
+			base_node_type* root{};
+			int rank{};
+		};
+
+		struct split_pieces {
+			join_piece left{};
+			base_node_type* found{};  // node with the split key, if any
+			join_piece right{};
+		};
+
+		const key_type& DoKeyOf(const base_node_type* n) const noexcept {
+			return m_KeyExtractor(static_cast<const node_type*>(n)->m_Val);
+		}
+
+		// unhooks the whole tree from the header (size is left as is)
+		template<typename Tree>
+		join_piece DoTakePiece(Tree& self) noexcept {
+
+			base_node_type* root = DoRoot();
+			DoResetHeader();
+
+			if (!root) return {};
+
+			mstl::TreeSetParent(root, nullptr);
+			return { root, self.DoRootRank(root) };
+		}
+
+		template<typename Tree>
+		void DoPlacePiece(Tree& self, join_piece p, size_type size) noexcept {
+
+			DoSetRoot(p.root);
+			m_Size = size;
+			self.DoFixRoot();
+		}
+
+		// detaches the children of p.root
+		template<typename Tree>
+		std::pair<join_piece, join_piece> DoExpose(Tree& self, const join_piece& p) noexcept {
+
+			base_node_type* l = p.root->mp_Left;
+			base_node_type* r = p.root->mp_Right;
+
+			if (l) mstl::TreeSetParent(l, nullptr);
+			if (r) mstl::TreeSetParent(r, nullptr);
+			p.root->mp_Left = p.root->mp_Right = nullptr;
+
+			return { { l, self.DoChildRank(p, l) }, { r, self.DoChildRank(p, r) } };
+		}
+
+		// (keys < key, node with key, keys > key)
+		template<typename Tree>
+		split_pieces DoSplitPiece(Tree& self, join_piece p, const key_type& key) noexcept {
+
+			if (!p.root) return {};
+
+			auto [l, r] = DoExpose(self, p);
+
+			if (m_Comp(key, DoKeyOf(p.root)))
+			{
+				split_pieces s = DoSplitPiece(self, l, key);
+				s.right = self.DoJoin(s.right, p.root, r);
+				return s;
+			}
+
+			if (m_Comp(DoKeyOf(p.root), key))
+			{
+				split_pieces s = DoSplitPiece(self, r, key);
+				s.left = self.DoJoin(l, p.root, s.left);
+				return s;
+			}
+
+			return { l, p.root, r };
+		}
+
+		// takes the maximum out of p: (rest, detached maximum)
+		template<typename Tree>
+		std::pair<join_piece, base_node_type*> DoSplitLast(Tree& self, join_piece p) noexcept {
+
+			auto [l, r] = DoExpose(self, p);
+
+			if (!r.root) return { l, p.root };
+
+			auto [rest, last] = DoSplitLast(self, r);
+			return { self.DoJoin(l, p.root, rest), last };
+		}
+
+		// join without a middle node
+		template<typename Tree>
+		join_piece DoJoin2(Tree& self, join_piece l, join_piece r) noexcept {
+
+			if (!l.root) return r;
+			if (!r.root) return l;
+
+			auto [rest, last] = DoSplitLast(self, l);
+			return self.DoJoin(rest, last, r);
+		}
+
+		/// Union of a (ours) and b (nodes of another tree): when a key is
+		/// in both the node of a stays and on_dup(node of b) gets the
+		/// other one, detached.
+		template<typename Tree, typename OnDup>
+		join_piece DoUnionPiece(Tree& self, join_piece a, join_piece b, OnDup& on_dup) {
+
+			if (!a.root) return b;
+			if (!b.root) return a;
+
+			auto [al, ar] = DoExpose(self, a);
+			split_pieces s = DoSplitPiece(self, b, DoKeyOf(a.root));
+
+			// in order: on_dup sees the duplicates sorted
+			join_piece l = DoUnionPiece(self, al, s.left, on_dup);
+			if (s.found) on_dup(s.found);
+			join_piece r = DoUnionPiece(self, ar, s.right, on_dup);
+
+			return self.DoJoin(l, a.root, r);
+		}
+
+		/// Keeps the nodes of a whose key is in the subtree b (which is
+		/// only read): a is split by the keys of b, the rest destroyed.
+		template<typename Tree>
+		join_piece DoIntersectPiece(Tree& self, join_piece a, const base_node_type* b, size_type& kept) noexcept {
+
+			if (!a.root) return {};
+
+			if (!b)
+			{
+				ClearSubtree(a.root, false);
+				return {};
+			}
+
+			split_pieces s = DoSplitPiece(self, a, DoKeyOf(b));
+
+			join_piece l = DoIntersectPiece(self, s.left, b->mp_Left, kept);
+			join_piece r = DoIntersectPiece(self, s.right, b->mp_Right, kept);
+
+			if (!s.found) return DoJoin2(self, l, r);
+
+			++kept;
+			return self.DoJoin(l, s.found, r);
+		}
+
+		// destroys the nodes of a whose key is in the subtree b
+		template<typename Tree>
+		join_piece DoDifferencePiece(Tree& self, join_piece a, const base_node_type* b, size_type& removed) noexcept {
+
+			if (!a.root || !b) return a;
+
+			split_pieces s = DoSplitPiece(self, a, DoKeyOf(b));
+
+			join_piece l = DoDifferencePiece(self, s.left, b->mp_Left, removed);
+			join_piece r = DoDifferencePiece(self, s.right, b->mp_Right, removed);
+
+			if (s.found)
+			{
+				DoDestroyNode(static_cast<node_type*>(s.found));
+				++removed;
+			}
+
+			return DoJoin2(self, l, r);
+		}
+
+		// ================= Join based operations =================
+		/// What the balanced trees expose, Tree being the derived tree.
+		/// The trees must share comparator and an allocator that can
+		/// free each other's nodes (equal allocators).
+
+		// *this = *this ++ (pivot) ++ right, pivot may be null.
+		// Every key of *this < pivot < every key of right (unchecked)
+		template<typename Tree>
+		void DoJoinWith(Tree& self, base_node_type* pivot, Tree& right) noexcept {
+
+			assert(m_ValueAlloc == right.m_ValueAlloc && "tree: join of trees with unequal allocators");
+
+			const size_type n = m_Size + right.m_Size + (pivot ? 1 : 0);
+
+			join_piece l = DoTakePiece(self);
+			join_piece r = right.DoTakePiece(right);
+			right.m_Size = 0;
+
+			join_piece p = pivot ? self.DoJoin(l, pivot, r) : DoJoin2(self, l, r);
+			DoPlacePiece(self, p, n);
+		}
+
+		/// *this keeps the keys < key, out (empty, same comparator and
+		/// allocator) receives the keys >= key. The sizes come from the
+		/// subtree counts with order statistic nodes, otherwise both
+		/// halves are walked side by side: O(min(|left|, |right|)).
+		template<typename Tree>
+		void DoSplitInto(Tree& self, const key_type& key, Tree& out) noexcept {
+
+			const size_type n = m_Size;
+
+			split_pieces s = DoSplitPiece(self, DoTakePiece(self), key);
+
+			// the node with key goes first in the right part
+			join_piece r = s.found ? self.DoJoin({}, s.found, s.right) : s.right;
+
+			DoPlacePiece(self, s.left, 0);
+			out.DoPlacePiece(out, r, 0);
+
+			if constexpr (has_order_statistics)
+			{
+				m_Size = mstl::TreeCount<node_type>(s.left.root);
+			}
+			else
+			{
+				auto i = begin();
+				auto j = out.begin();
+				size_type k = 0;
+
+				for (; i != end() && j != out.end(); ++i, ++j) ++k;
+
+				m_Size = i == end() ? k : n - k;
+			}
+
+			out.m_Size = n - m_Size;
+		}
+
+		// all of other's nodes move here, on equal keys ours stay and
+		// other's are destroyed
+		template<typename Tree>
+		void DoUnionWith(Tree& self, Tree& other) noexcept {
+
+			assert(m_ValueAlloc == other.m_ValueAlloc && "tree: union of trees with unequal allocators");
+
+			size_type dups = 0;
+			auto destroy = [&](base_node_type* n) noexcept {
+				DoDestroyNode(static_cast<node_type*>(n));
+				++dups;
+			};
+
+			const size_type n = m_Size + other.m_Size;
+			join_piece a = DoTakePiece(self);
+			join_piece b = other.DoTakePiece(other);
+			other.m_Size = 0;
+
+			join_piece u = DoUnionPiece(self, a, b, destroy);
+			DoPlacePiece(self, u, n - dups);
+		}
+
+		/// std::set::merge: the nodes of other whose key is not here move
+		/// here, the others stay in other. They come out of the union in
+		/// order and go back through insert_node (Tree), so relinking
+		/// only: no allocation, no copy.
+		template<typename Tree>
+		void DoMergeFrom(Tree& self, Tree& other) noexcept {
+
+			assert(m_ValueAlloc == other.m_ValueAlloc && "tree: merge of trees with unequal allocators");
+
+			// duplicates chained through mp_Right
+			base_node_type* first = nullptr;
+			base_node_type* last = nullptr;
+			size_type dups = 0;
+
+			auto keep = [&](base_node_type* n) noexcept {
+				n->mp_Right = nullptr;
+				if (last) last->mp_Right = n; else first = n;
+				last = n;
+				++dups;
+			};
+
+			const size_type n = m_Size + other.m_Size;
+			join_piece a = DoTakePiece(self);
+			join_piece b = other.DoTakePiece(other);
+			other.m_Size = 0;
+
+			join_piece u = DoUnionPiece(self, a, b, keep);
+			DoPlacePiece(self, u, n - dups);
+
+			while (first)
+			{
+				base_node_type* next = first->mp_Right;
+				other.insert_node(static_cast<node_type*>(first));
+				first = next;
+			}
+		}
+
+		template<typename Tree>
+		void DoIntersectionWith(Tree& self, const Tree& other) noexcept {
+
+			size_type kept = 0;
+			join_piece i = DoIntersectPiece(self, DoTakePiece(self), other.DoRoot(), kept);
+			DoPlacePiece(self, i, kept);
+		}
+
+		template<typename Tree>
+		void DoDifferenceWith(Tree& self, const Tree& other) noexcept {
+
+			const size_type n = m_Size;
+			size_type removed = 0;
+			join_piece d = DoDifferencePiece(self, DoTakePiece(self), other.DoRoot(), removed);
+			DoPlacePiece(self, d, n - removed);
+		}
 
 		// ================= Alloc/Dealloc =================
 
 		node_type* DoAllocateNode() {
-			return node_traits::allocate(m_NodeAlloc, 1);
+			node_type* p = node_traits::allocate(m_NodeAlloc, 1);
+			trace::on_allocate(sizeof(node_type));
+			return p;
 		}
 
 		void DoDeallocateNode(node_type* p) noexcept {
 			node_traits::deallocate(m_NodeAlloc, p, 1);
+			trace::on_deallocate(sizeof(node_type));
+		}
+
+		template<class... Args>
+		node_type* DoCreateNode(Args&&... args)
+		{
+			node_type* n = DoAllocateNode();
+
+			try {
+				node_traits::construct(m_NodeAlloc, n, std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				DoDeallocateNode(n);
+				throw;
+			}
+
+			n->mp_Left = n->mp_Right = nullptr;
+			mstl::TreeSetParent<base_node_type>(n, nullptr);
+			return n;
+		}
+
+		// ================ Bulk build =================
+
+		/// Replaces the content with a perfectly balanced tree holding
+		/// [first, last), that must be sorted and without duplicates.
+		/// 
+		/// Nodes are created in order and linked bottom-up (the middle
+		/// element of every range becomes the subtree root), so it is
+		/// O(n) with no comparison and no rebalancing.
+		/// init(node, depth, height) is called on every node once its
+		/// subtrees are built so derived trees can set color/height.
+		/// 
+		/// Strong guarantee: if a construction throws the tree is empty
+		/// and every node already built is destroyed.
+
+		template<typename It, typename Init>
+		void DoBuildSorted(It first, It last, Init init)
+		{
+			DoClear();
+
+			if constexpr (std::forward_iterator<It>)
+			{
+				const size_type n = static_cast<size_type>(std::distance(first, last));
+				DoBuildSortedN(first, n, init);
+			}
+			else
+			{
+				// single pass input: buffer it to know the size
+				std::vector<value_type> buffer(first, last);
+				auto it = std::make_move_iterator(buffer.begin());
+				DoBuildSortedN(it, buffer.size(), init);
+			}
+		}
+
+		// ================ Structural copy =================
+
+		/// Replaces the content with a node for node copy of other:
+		/// same shape, no comparison, no rebalancing, O(n).
+		/// meta(node, source) copies the balance data of the derived
+		/// tree (color, height); m_Count is copied here when present.
+		/// 
+		/// The walk keeps the source and the copy in step and climbs
+		/// back through parent links, so it needs O(1) extra space even
+		/// for a degenerate tree. A subtree is done once every child of
+		/// the source node has its copy.
+		/// 
+		/// Strong guarantee: if a value copy throws, every node already
+		/// built is destroyed and the tree is left empty.
+
+		template<typename Meta>
+		void DoCloneFrom(const tree_base& other, Meta meta)
+		{
+			DoClear();
+
+			const base_node_type* s = other.DoRoot();
+			if (!s) return;
+
+			node_type* const root = CloneNode(s, meta);
+			base_node_type* d = root;
+
+			try {
+				for (;;)
+				{
+					if (s->mp_Left && !d->mp_Left)
+					{
+						d->mp_Left = CloneNode(s->mp_Left, meta);
+						mstl::TreeSetParent(d->mp_Left, d);
+						s = s->mp_Left;
+						d = d->mp_Left;
+					}
+					else if (s->mp_Right && !d->mp_Right)
+					{
+						d->mp_Right = CloneNode(s->mp_Right, meta);
+						mstl::TreeSetParent(d->mp_Right, d);
+						s = s->mp_Right;
+						d = d->mp_Right;
+					}
+					else if (d == root)
+					{
+						break;
+					}
+					else
+					{
+						s = mstl::TreeParent(s);
+						d = mstl::TreeParent(d);
+					}
+				}
+			}
+			catch (...)
+			{
+				ClearSubtree(root, false);
+				throw;
+			}
+
+			DoSetRoot(root);
+			m_Size = other.m_Size;
 		}
 
 		// ================ Cleanup =================
@@ -535,22 +1567,198 @@ namespace mstl {
 			DoDeallocateNode(p);
 		}
 
-		// Recursively clear tree nodes
+		// node destruction is a no-op: trivially destructible value,
+		// allocator without its own destroy()
+		static constexpr bool trivial_node_destroy =
+			std::is_trivially_destructible_v<node_type> && alloc_default_construct<node_alloc, node_type>;
+
+		// Clear tree nodes: O(n) time, O(1) extra space
 		void DoClear() noexcept {
-			ClearRec(mp_Root);
-			mp_Root = nullptr;
+
+			// if the allocator can drop every node at once only
+			// destructors are run while walking the tree, and with
+			// nothing to destroy there is no walk at all: O(1)
+			const bool bulk = DoCanBulkRelease();
+
+			if (!(bulk && trivial_node_destroy))
+				ClearSubtree(DoRoot(), bulk);
+
+			if (bulk) DoReleaseAll();
+
+			DoResetHeader();
 			m_Size = 0;
 		}
 
+		// Bulk release is possible when the allocator exposes it
+		// (see node_pool_allocator) and all its nodes are ours
+		bool DoCanBulkRelease() const noexcept {
+
+			if constexpr (requires(node_alloc& a, size_type n) { a.is_sole_owner(n); a.release(); })
+			{
+				return m_Size > 0 && m_NodeAlloc.is_sole_owner(m_Size);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		void DoReleaseAll() noexcept {
+
+			if constexpr (requires(node_alloc& a) { a.release(); })
+			{
+				m_NodeAlloc.release();
+
+				if constexpr (trace::enabled)
+					for (size_type i = 0; i < m_Size; ++i) trace::on_deallocate(sizeof(node_type));
+			}
+		}
+
 	private:
 
-		void ClearRec(base_node_type* n) noexcept {
-			if (!n) return;
+		// adopt the nodes of another header (used by swap)
+		void DoAdopt(base_node_type* root, base_node_type* leftmost, base_node_type* rightmost) noexcept {
+
+			if (!root)
+			{
+				DoResetHeader();
+				return;
+			}
+
+			m_Header.mp_Left = root;
+			m_Header.mp_Right = rightmost;
+			mstl::TreeSetParent(root, DoHeader());
+			mp_Leftmost = leftmost;
+		}
+
+		// detached copy of one node: value, balance data, subtree size
+		template<typename Meta>
+		node_type* CloneNode(const base_node_type* src, Meta& meta)
+		{
+			const node_type* s = static_cast<const node_type*>(src);
+			node_type* n = DoCreateNode(s->m_Val);
+
+			meta(n, s);
+
+			if constexpr (has_order_statistics)
+			{
+				n->m_Count = s->m_Count;
+			}
+
+			return n;
+		}
+
+		template<typename It, typename Init>
+		void DoBuildSortedN(It& it, size_type n, Init& init)
+		{
+			// m_Size is set first: init may depend on the final size
+			m_Size = n;
+
+			base_node_type* root = nullptr;
 
-			ClearRec(n->mp_Left);
-			ClearRec(n->mp_Right);
+			try {
+				int height = 0;
+				root = BuildSortedRec(it, n, 0, height, init);
+			}
+			catch (...)
+			{
+				m_Size = 0;
+				throw;
+			}
+
+			DoSetRoot(root);
+		}
 
-			this->DoDestroyNode(static_cast<node_type*>(n));
+		template<typename It, typename Init>
+		base_node_type* BuildSortedRec(It& it, size_type n, int depth, int& height, Init& init)
+		{
+			if (n == 0)
+			{
+				height = 0;
+				return nullptr;
+			}
+
+			// the right half gets the extra element when n is even
+			const size_type n_left = (n - 1) / 2;
+			const size_type n_right = n - 1 - n_left;
+
+			int h_left = 0;
+			int h_right = 0;
+
+			base_node_type* left = BuildSortedRec(it, n_left, depth + 1, h_left, init);
+			node_type* mid = nullptr;
+
+			try {
+				mid = DoCreateNode(*it);
+				++it;
+			}
+			catch (...)
+			{
+				ClearSubtree(left, false);
+				throw;
+			}
+
+			base_node_type* right = nullptr;
+
+			try {
+				right = BuildSortedRec(it, n_right, depth + 1, h_right, init);
+			}
+			catch (...)
+			{
+				ClearSubtree(left, false);
+				DoDestroyNode(mid);
+				throw;
+			}
+
+			mid->mp_Left = left;
+			mid->mp_Right = right;
+			if (left) mstl::TreeSetParent(left, mid);
+			if (right) mstl::TreeSetParent(right, mid);
+
+			height = 1 + (h_left > h_right ? h_left : h_right);
+
+			if constexpr (has_order_statistics)
+			{
+				mid->m_Count = n;
+			}
+
+			init(mid, depth, height);
+
+			return mid;
+		}
+
+		/// Destroys the subtree of n with no recursion and no stack, so
+		/// a degenerate bst_tree (a list) is as safe as a balanced one:
+		/// while n has a left child it is rotated up (only the links
+		/// among nodes about to die change), with none n goes and its
+		/// right child is next. Each node is rotated up at most once:
+		/// O(n). Parent links are never read.
+		void ClearSubtree(base_node_type* n, bool bulk) noexcept {
+
+			while (n)
+			{
+				if (base_node_type* l = n->mp_Left)
+				{
+					n->mp_Left = l->mp_Right;
+					l->mp_Right = n;
+					n = l;
+					continue;
+				}
+
+				base_node_type* const next = n->mp_Right;
+
+				if (bulk)
+				{
+					if constexpr (!trivial_node_destroy)
+						node_traits::destroy(m_NodeAlloc, static_cast<node_type*>(n));
+				}
+				else
+				{
+					this->DoDestroyNode(static_cast<node_type*>(n));
+				}
+
+				n = next;
+			}
 		}
 
 		template<typename U, template<class> class N, typename K, typename C, typename A>
@@ -562,13 +1770,7 @@ namespace mstl {
 	template<typename U, template<class> class N, typename K, typename C, typename A>
 	void swap(tree_base<U, N, K, C, A>& a, tree_base<U, N, K, C, A>& b) noexcept {
 		
-		using std::swap;
-		swap(a.m_ValueAlloc, b.m_ValueAlloc);
-		swap(a.m_NodeAlloc, b.m_NodeAlloc);
-		swap(a.m_Comp, b.m_Comp);
-		swap(a.m_KeyExtractor, b.m_KeyExtractor);
-		swap(a.m_Size, b.m_Size);
-		swap(a.mp_Root, b.mp_Root);
+		a.DoSwap(b);
 	}
 }
 
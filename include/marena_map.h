@@ -0,0 +1,289 @@
+#ifndef MSTL_ARENA_MAP_H
+#define MSTL_ARENA_MAP_H
+
+#include "internals/arena_tree.h"
+#include <tuple>
+#include <stdexcept>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Arena Map
+	/// ---------------------------------------------------------------
+	/// Same interface as mstl::map, backed by arena_rb_tree: every
+	/// node in one array, linked by 32-bit indices. Half the link
+	/// overhead of map, one allocation for the whole tree, and the
+	/// tree copies (one memcpy for trivially copyable pairs) and
+	/// relocates as plain bytes.
+	///
+	/// Unlike mstl::map, an insert may move every value: iterators
+	/// stay valid, references and pointers don't (reserve() first to
+	/// keep them). No node handles, join / split or order statistics.
+
+	template<
+		typename Key,
+		typename T,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<std::pair<const Key, T>>
+	>
+	class arena_map {
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using key_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+	private:
+
+		using tree_type = arena_rb_tree<
+			value_type,
+			first_key<value_type>,
+			key_compare,
+			allocator_type
+		>;
+
+		tree_type m_Tree;
+
+	public:
+
+		using iterator       = typename tree_type::iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		using reverse_iterator       = typename tree_type::reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
+		// ================= Constructors =================
+		arena_map() = default;
+
+		explicit arena_map(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		arena_map(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(first, last, alloc, comp) {
+		}
+
+		// [first, last) sorted by key, no duplicates: O(n) build,
+		// nodes in key order in the arena
+		template<class InputIt>
+		arena_map(sorted_unique_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_unique, first, last, alloc, comp) {
+		}
+
+		arena_map(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(il, alloc, comp) {
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return m_Tree.begin(); }
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		iterator end() noexcept { return m_Tree.end(); }
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		reverse_iterator rbegin() noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		reverse_iterator rend() noexcept { return m_Tree.rend(); }
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+		static constexpr size_type max_size() noexcept { return tree_type::max_size(); }
+
+		size_type capacity() const noexcept { return m_Tree.capacity(); }
+		void reserve(size_type n) { m_Tree.reserve(n); }
+		void shrink_to_fit() { m_Tree.shrink_to_fit(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& val) { return m_Tree.insert(val); }
+		std::pair<iterator, bool> insert(value_type&& val) { return m_Tree.insert(std::move(val)); }
+
+		iterator insert(const_iterator hint, const value_type& val) { return m_Tree.insert(hint, val); }
+		iterator insert(const_iterator hint, value_type&& val) { return m_Tree.insert(hint, std::move(val)); }
+
+		template<class InputIt>
+		void insert(InputIt first, InputIt last)
+		{
+			for (; first != last; ++first) m_Tree.insert(*first);
+		}
+
+		void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return m_Tree.emplace(std::forward<Args>(args)...);
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			return m_Tree.emplace_hint(hint, std::forward<Args>(args)...);
+		}
+
+		// the value is built only if key is missing
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key, std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key, std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj)
+		{
+			auto [it, inserted] = try_emplace(key, std::forward<M>(obj));
+			if (!inserted) (*it).second = std::forward<M>(obj);
+			return { it, inserted };
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj)
+		{
+			auto [it, inserted] = try_emplace(std::move(key), std::forward<M>(obj));
+			if (!inserted) (*it).second = std::forward<M>(obj);
+			return { it, inserted };
+		}
+
+		iterator erase(const_iterator pos) { return m_Tree.erase(pos); }
+		size_type erase(const key_type& key) { return m_Tree.erase(key); }
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) { return m_Tree.erase(key); }
+
+		void swap(arena_map& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Element access =================
+
+		// T is value-initialized in the slot, only for a new key
+		T& operator[](const Key& key)
+		{
+			return (*try_emplace(key).first).second;
+		}
+
+		T& operator[](Key&& key)
+		{
+			return (*try_emplace(std::move(key)).first).second;
+		}
+
+		T& at(const Key& key)
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::arena_map::at: key not found");
+			return (*it).second;
+		}
+
+		const T& at(const Key& key) const
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::arena_map::at: key not found");
+			return (*it).second;
+		}
+
+		// ================= Lookup =================
+
+		iterator find(const Key& key) { return m_Tree.find(key); }
+		const_iterator find(const Key& key) const { return m_Tree.find(key); }
+
+		size_type count(const Key& key) const { return m_Tree.contains(key) ? 1 : 0; }
+		bool contains(const Key& key) const { return m_Tree.contains(key); }
+
+		iterator lower_bound(const Key& key) { return m_Tree.lower_bound(key); }
+		const_iterator lower_bound(const Key& key) const { return m_Tree.lower_bound(key); }
+
+		iterator upper_bound(const Key& key) { return m_Tree.upper_bound(key); }
+		const_iterator upper_bound(const Key& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<iterator, iterator> equal_range(const Key& key) { return m_Tree.equal_range(key); }
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Heterogeneous lookup =================
+		// transparent Compare only, e.g. arena_map<std::string, T, std::less<>>
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator find(const K& key) { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator find(const K& key) const { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		size_type count(const K& key) const { return m_Tree.contains(key) ? 1 : 0; }
+
+		template<class K> requires TransparentCompare<Compare>
+		bool contains(const K& key) const { return m_Tree.contains(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator lower_bound(const K& key) { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator lower_bound(const K& key) const { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator upper_bound(const K& key) { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator upper_bound(const K& key) const { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<iterator, iterator> equal_range(const K& key) { return m_Tree.equal_range(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.verify(); }
+
+		friend bool operator==(const arena_map& a, const arena_map& b) { return a.m_Tree == b.m_Tree; }
+		friend bool operator!=(const arena_map& a, const arena_map& b) { return !(a == b); }
+	};
+
+	template<typename K, typename T, typename C, typename A>
+	void swap(arena_map<K, T, C, A>& a, arena_map<K, T, C, A>& b) noexcept
+	{
+		a.swap(b);
+	}
+
+	template<typename K, typename T, typename C, typename A>
+	struct is_trivially_relocatable<arena_map<K, T, C, A>>
+		: is_trivially_relocatable<arena_rb_tree<std::pair<const K, T>, first_key<std::pair<const K, T>>, C, A>> {
+	};
+}
+
+#endif // ! MSTL_ARENA_MAP_H
@@ -0,0 +1,218 @@
+#ifndef MSTL_BTREE_MAP_H
+#define MSTL_BTREE_MAP_H
+
+#include "internals/b_tree.h"
+#include <tuple>
+#include <stdexcept>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// B-tree Map
+	/// ---------------------------------------------------------------
+	/// Same interface as mstl::map, backed by a btree: nodes hold
+	/// several values and span CacheLines cache lines, so big maps
+	/// miss the cache far less on lookups and iterate faster.
+	///
+	/// Unlike mstl::map, insert and erase invalidate iterators.
+
+	template<
+		typename Key,
+		typename T,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<std::pair<const Key, T>>,
+		std::size_t CacheLines = 4
+	>
+	class btree_map {
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using key_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+	private:
+
+		using tree_type = btree<
+			value_type,
+			first_key<value_type>,
+			key_compare,
+			allocator_type,
+			CacheLines
+		>;
+
+		tree_type m_Tree;
+
+	public:
+
+		using iterator       = typename tree_type::iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		using reverse_iterator       = typename tree_type::reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
+		// ================= Constructors =================
+		btree_map() = default;
+
+		explicit btree_map(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		btree_map(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(first, last, alloc, comp) {
+		}
+
+		// [first, last) sorted by key, no duplicates: appended in order
+		template<class InputIt>
+		btree_map(sorted_unique_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_unique, first, last, alloc, comp) {
+		}
+
+		btree_map(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(il, alloc, comp) {
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return m_Tree.begin(); }
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		iterator end() noexcept { return m_Tree.end(); }
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		reverse_iterator rbegin() noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		reverse_iterator rend() noexcept { return m_Tree.rend(); }
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& val)
+		{
+			return m_Tree.insert(val);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& val)
+		{
+			return m_Tree.insert(std::move(val));
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return m_Tree.emplace(std::forward<Args>(args)...);
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key,
+				std::piecewise_construct,
+				std::forward_as_tuple(key),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		// key is moved from only when it is inserted
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key,
+				std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		iterator erase(const_iterator pos) { return m_Tree.erase(pos); }
+		size_type erase(const key_type& key) { return m_Tree.erase(key); }
+
+		void swap(btree_map& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Element access =================
+
+		// lookup first: T is value-initialized only for a new key
+		T& operator[](const Key& key)
+		{
+			return (*try_emplace(key).first).second;
+		}
+
+		T& operator[](Key&& key)
+		{
+			return (*try_emplace(std::move(key)).first).second;
+		}
+
+		T& at(const Key& key)
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::btree_map::at: key not found");
+			return (*it).second;
+		}
+
+		const T& at(const Key& key) const
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::btree_map::at: key not found");
+			return (*it).second;
+		}
+
+		// ================= Lookup =================
+
+		iterator find(const Key& key) { return m_Tree.find(key); }
+		const_iterator find(const Key& key) const { return m_Tree.find(key); }
+
+		size_type count(const Key& key) const { return m_Tree.contains(key) ? 1 : 0; }
+		bool contains(const Key& key) const { return m_Tree.contains(key); }
+
+		iterator lower_bound(const Key& key) { return m_Tree.lower_bound(key); }
+		const_iterator lower_bound(const Key& key) const { return m_Tree.lower_bound(key); }
+
+		iterator upper_bound(const Key& key) { return m_Tree.upper_bound(key); }
+		const_iterator upper_bound(const Key& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<iterator, iterator> equal_range(const Key& key) { return m_Tree.equal_range(key); }
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.verify(); }
+
+		friend bool operator==(const btree_map& a, const btree_map& b) { return a.m_Tree == b.m_Tree; }
+		friend bool operator!=(const btree_map& a, const btree_map& b) { return !(a == b); }
+	};
+
+	template<typename K, typename T, typename C, typename A, std::size_t L>
+	void swap(btree_map<K, T, C, A, L>& a, btree_map<K, T, C, A, L>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // ! MSTL_BTREE_MAP_H
@@ -0,0 +1,157 @@
+#ifndef MSTL_BTREE_SET_H
+#define MSTL_BTREE_SET_H
+
+#include "internals/b_tree.h"
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// B-tree Set
+	/// ---------------------------------------------------------------
+	/// Ordered unique keys in a btree (see btree_map).
+	/// Iterators are constant: keys can't change in place.
+
+	template<
+		typename Key,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<Key>,
+		std::size_t CacheLines = 4
+	>
+	class btree_set {
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using key_compare = Compare;
+		using value_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+	private:
+
+		using tree_type = btree<
+			value_type,
+			identity_key<value_type>,
+			key_compare,
+			allocator_type,
+			CacheLines
+		>;
+
+		tree_type m_Tree;
+
+	public:
+
+		using iterator       = typename tree_type::const_iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		using reverse_iterator       = typename tree_type::const_reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
+		// ================= Constructors =================
+		btree_set() = default;
+
+		explicit btree_set(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		btree_set(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(first, last, alloc, comp) {
+		}
+
+		template<class InputIt>
+		btree_set(sorted_unique_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_unique, first, last, alloc, comp) {
+		}
+
+		btree_set(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(il, alloc, comp) {
+		}
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& val)
+		{
+			return m_Tree.insert(val);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& val)
+		{
+			return m_Tree.insert(std::move(val));
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return m_Tree.emplace(std::forward<Args>(args)...);
+		}
+
+		iterator erase(const_iterator pos) { return m_Tree.erase(pos); }
+		size_type erase(const key_type& key) { return m_Tree.erase(key); }
+
+		void swap(btree_set& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Lookup =================
+
+		const_iterator find(const Key& key) const { return m_Tree.find(key); }
+
+		size_type count(const Key& key) const { return m_Tree.contains(key) ? 1 : 0; }
+		bool contains(const Key& key) const { return m_Tree.contains(key); }
+
+		const_iterator lower_bound(const Key& key) const { return m_Tree.lower_bound(key); }
+		const_iterator upper_bound(const Key& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+		value_compare value_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.verify(); }
+
+		friend bool operator==(const btree_set& a, const btree_set& b) { return a.m_Tree == b.m_Tree; }
+		friend bool operator!=(const btree_set& a, const btree_set& b) { return !(a == b); }
+	};
+
+	template<typename K, typename C, typename A, std::size_t L>
+	void swap(btree_set<K, C, A, L>& a, btree_set<K, C, A, L>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // ! MSTL_BTREE_SET_H
@@ -0,0 +1,484 @@
+#ifndef MSTL_DEQUE_H
+#define MSTL_DEQUE_H
+
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <compare>
+#include <cstring>
+#include <bit>
+#include <initializer_list>
+#include "concepts_utils.h"
+#include "internals/relocate.h"
+#include "internals/trace.h"
+
+namespace mstl {
+
+	/// Elements per block: about 4 KiB, at least 16, a power of two
+	/// so an index splits into (block, offset) with a shift and a mask.
+	template<typename T>
+	inline constexpr std::size_t deque_block_size =
+		std::bit_floor(std::max<std::size_t>(16, 4096 / sizeof(T)));
+
+	/// ---------------------------------------------------------------
+	/// deque iterator
+	/// ---------------------------------------------------------------
+	/// Element i of the deque sits at map[i >> shift][i & mask], with
+	/// i counted from the first map slot: the iterator is just the map
+	/// and that index, so every random access step is O(1).
+	/// Growing the map (push_front/push_back) invalidates iterators,
+	/// not references.
+
+	template<typename T, bool IsConst>
+	class deque_iterator {
+
+		template<typename, typename> friend class deque;
+		template<typename, bool> friend class deque_iterator;
+
+		static constexpr std::size_t block_size = deque_block_size<T>;
+		static constexpr std::size_t block_shift = std::countr_zero(block_size);
+		static constexpr std::size_t block_mask = block_size - 1;
+
+		T* const* mp_Map{};
+		std::size_t m_Index{};
+
+		deque_iterator(T* const* map, std::size_t index) noexcept : mp_Map{ map }, m_Index{ index } {}
+
+	public:
+
+		using iterator_category = std::random_access_iterator_tag;
+		using iterator_concept  = std::random_access_iterator_tag;
+		using value_type        = T;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = std::conditional_t<IsConst, const T*, T*>;
+		using reference         = std::conditional_t<IsConst, const T&, T&>;
+
+		deque_iterator() = default;
+
+		// iterator -> const_iterator
+		template<bool C = IsConst> requires C
+		deque_iterator(const deque_iterator<T, false>& it) noexcept : mp_Map{ it.mp_Map }, m_Index{ it.m_Index } {}
+
+		reference operator*() const noexcept { return mp_Map[m_Index >> block_shift][m_Index & block_mask]; }
+		pointer operator->() const noexcept { return std::addressof(**this); }
+		reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+		deque_iterator& operator++() noexcept { ++m_Index; return *this; }
+		deque_iterator operator++(int) noexcept { auto tmp = *this; ++m_Index; return tmp; }
+		deque_iterator& operator--() noexcept { --m_Index; return *this; }
+		deque_iterator operator--(int) noexcept { auto tmp = *this; --m_Index; return tmp; }
+
+		deque_iterator& operator+=(difference_type n) noexcept { m_Index += n; return *this; }
+		deque_iterator& operator-=(difference_type n) noexcept { m_Index -= n; return *this; }
+
+		friend deque_iterator operator+(deque_iterator it, difference_type n) noexcept { return it += n; }
+		friend deque_iterator operator+(difference_type n, deque_iterator it) noexcept { return it += n; }
+		friend deque_iterator operator-(deque_iterator it, difference_type n) noexcept { return it -= n; }
+
+		friend difference_type operator-(const deque_iterator& a, const deque_iterator& b) noexcept {
+			return static_cast<difference_type>(a.m_Index) - static_cast<difference_type>(b.m_Index);
+		}
+
+		bool operator==(const deque_iterator& other) const noexcept { return m_Index == other.m_Index; }
+		auto operator<=>(const deque_iterator& other) const noexcept { return m_Index <=> other.m_Index; }
+	};
+
+	/// deque_rep owns the block map and the blocks, like list_rep owns
+	/// the links: allocator, size and RAII cleanup.
+	///
+	/// The map is an array of block pointers, only the slots holding
+	/// elements point to a block. The live range sits around the middle
+	/// of the map; when one end runs out of slots the block pointers are
+	/// recentred, or the map doubles, without touching any element.
+	/// One emptied block is kept as a spare, so a FIFO in steady state
+	/// (push_back + pop_front) recycles it instead of calling the
+	/// allocator once per block.
+
+	template<typename T, typename A = std::allocator<T>>
+		requires Element<T>
+	class deque_rep {
+
+	public:
+		using value_type = T;
+		using alloc_type = A;
+		using alloc_traits = std::allocator_traits<A>;
+		using size_type = typename alloc_traits::size_type;
+		using difference_type = typename alloc_traits::difference_type;
+		using map_alloc = typename alloc_traits::template rebind_alloc<T*>;
+		using map_traits = std::allocator_traits<map_alloc>;
+		using trace = trace_hook_t<deque_rep>;    // null_trace unless MSTL_TRACE
+
+		static constexpr size_type block_size = deque_block_size<T>;
+		static constexpr size_type block_shift = std::countr_zero(block_size);
+		static constexpr size_type block_mask = block_size - 1;
+
+		// === Constructors ===
+
+		deque_rep()
+			: m_Alloc{ alloc_type{} }
+			, m_MapAlloc{ m_Alloc } {
+		}
+
+		explicit deque_rep(const alloc_type& a)
+			: m_Alloc{ a }
+			, m_MapAlloc{ a } {
+		}
+
+		// === Destructor ===
+
+		~deque_rep() {
+			DoClear();
+
+			if (mp_Spare) DoDeallocateBlock(mp_Spare);
+			if (mp_Map) DoDeallocateMap(mp_Map, m_MapSize);
+		}
+
+	protected:
+
+		[[no_unique_address]] alloc_type m_Alloc{};
+		[[no_unique_address]] map_alloc m_MapAlloc{ m_Alloc };
+		T** mp_Map{};
+		size_type m_MapSize{};
+		size_type m_Start{};      // index of the first element, from map slot 0
+		size_type m_Size{};
+		T* mp_Spare{};            // emptied block kept for the next one needed
+
+		// destroys every element and gives the blocks back
+		void DoClear() noexcept {
+
+			size_type i = m_Start;
+			const size_type last = m_Start + m_Size;
+
+			while (i < last)
+			{
+				const size_type block_end = std::min(last, (i | block_mask) + 1);
+				DestroyN(m_Alloc, mp_Map[i >> block_shift] + (i & block_mask), block_end - i);
+				DoReleaseBlock(i >> block_shift);
+				i = block_end;
+			}
+
+			m_Size = 0;
+			DoRecentre();
+		}
+
+		// an empty deque restarts from the middle of the map
+		void DoRecentre() noexcept {
+			m_Start = (m_MapSize / 2) << block_shift;
+		}
+
+		// the block for slot, taken from the spare if there is one
+		T* DoAcquireBlock(size_type slot) {
+
+			T* b = mp_Spare;
+
+			if (b) mp_Spare = nullptr;
+			else b = DoAllocateBlock();
+
+			mp_Map[slot] = b;
+			return b;
+		}
+
+		// the block of slot holds no element any more
+		void DoReleaseBlock(size_type slot) noexcept {
+
+			T* b = mp_Map[slot];
+			mp_Map[slot] = nullptr;
+
+			if (!mp_Spare) mp_Spare = b;
+			else DoDeallocateBlock(b);
+		}
+
+		/// Makes room for one more block in front (front == true) or at
+		/// the back of the used slots. Only block pointers move: the
+		/// elements stay where they are, references stay valid.
+		void DoGrowMap(bool front) {
+
+			const size_type first = m_Start >> block_shift;
+			const size_type used = m_Size ? ((m_Start + m_Size - 1) >> block_shift) - first + 1 : 0;
+			const size_type needed = used + 1;
+
+			size_type newFirst;
+
+			if (m_MapSize && 2 * needed <= m_MapSize)
+			{
+				// half empty: recentre the used slots in place
+				newFirst = (m_MapSize - needed) / 2 + (front ? 1 : 0);
+
+				if (used) std::memmove(mp_Map + newFirst, mp_Map + first, used * sizeof(T*));
+
+				std::fill(mp_Map, mp_Map + newFirst, nullptr);
+				std::fill(mp_Map + newFirst + used, mp_Map + m_MapSize, nullptr);
+			}
+			else
+			{
+				const size_type newSize = std::max<size_type>(8, 2 * m_MapSize);
+				T** newMap = DoAllocateMap(newSize);
+
+				newFirst = (newSize - needed) / 2 + (front ? 1 : 0);
+
+				std::fill(newMap, newMap + newSize, nullptr);
+				if (used) std::memcpy(newMap + newFirst, mp_Map + first, used * sizeof(T*));
+
+				if (mp_Map) DoDeallocateMap(mp_Map, m_MapSize);
+
+				mp_Map = newMap;
+				m_MapSize = newSize;
+			}
+
+			m_Start = (newFirst << block_shift) + (m_Start & block_mask);
+		}
+
+		T* DoAllocateBlock() {
+			T* b = alloc_traits::allocate(m_Alloc, block_size);
+			trace::on_allocate(block_size * sizeof(T));
+			return b;
+		}
+
+		void DoDeallocateBlock(T* b) noexcept {
+			alloc_traits::deallocate(m_Alloc, b, block_size);
+			trace::on_deallocate(block_size * sizeof(T));
+		}
+
+		T** DoAllocateMap(size_type n) {
+			T** m = map_traits::allocate(m_MapAlloc, n);
+			trace::on_allocate(n * sizeof(T*));
+			return m;
+		}
+
+		void DoDeallocateMap(T** m, size_type n) noexcept {
+			map_traits::deallocate(m_MapAlloc, m, n);
+			trace::on_deallocate(n * sizeof(T*));
+		}
+	};
+
+
+	/// Double-ended queue: O(1) push/pop at both ends and O(1) random
+	/// access. Elements live in fixed-size blocks (deque_block_size),
+	/// so they never move once built and a push allocates at most one
+	/// block: compared to mstl::list no allocation and no links per
+	/// element, and neighbours share cache lines.
+
+	template<typename T, typename A = std::allocator<T>>
+		requires Element<T>
+	class deque : public deque_rep<T, A> {
+
+		using base_type = deque_rep<T, A>;
+		using base_type::block_shift;
+		using base_type::block_mask;
+
+	public:
+
+		using value_type = T;
+		using alloc_type = A;
+		using size_type = typename base_type::size_type;
+		using difference_type = typename base_type::difference_type;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using alloc_traits = typename base_type::alloc_traits;
+
+		using iterator = deque_iterator<T, false>;
+		using const_iterator = deque_iterator<T, true>;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		// ================= Ctors =================
+
+		deque() = default;
+
+		explicit deque(const alloc_type& a) : base_type{ a } {}
+
+		deque(std::initializer_list<T> i_lst) {
+			for (const T& v : i_lst) emplace_back(v);
+		}
+
+		deque(const deque& other)
+			: base_type{ alloc_traits::select_on_container_copy_construction(other.m_Alloc) } {
+			for (const T& v : other) emplace_back(v);
+		}
+
+		deque(deque&& other) noexcept
+			: base_type{ other.m_Alloc } {
+			swap(other);
+		}
+
+		deque& operator=(const deque& other) {
+			if (this != &other)
+			{
+				deque tmp(other);
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		deque& operator=(deque&& other) noexcept {
+			if (this != &other)
+			{
+				this->DoClear();
+				swap(other);
+			}
+			return *this;
+		}
+
+		void swap(deque& other) noexcept {
+			std::swap(this->m_Alloc, other.m_Alloc);
+			std::swap(this->m_MapAlloc, other.m_MapAlloc);
+			std::swap(this->mp_Map, other.mp_Map);
+			std::swap(this->m_MapSize, other.m_MapSize);
+			std::swap(this->m_Start, other.m_Start);
+			std::swap(this->m_Size, other.m_Size);
+			std::swap(this->mp_Spare, other.mp_Spare);
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return iterator{ this->mp_Map, this->m_Start }; }
+		const_iterator begin() const noexcept { return const_iterator{ this->mp_Map, this->m_Start }; }
+		iterator end() noexcept { return iterator{ this->mp_Map, this->m_Start + this->m_Size }; }
+		const_iterator end() const noexcept { return const_iterator{ this->mp_Map, this->m_Start + this->m_Size }; }
+
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+
+		// ================= Access =================
+
+		reference operator[](size_type n) noexcept { return At(this->m_Start + n); }
+		const_reference operator[](size_type n) const noexcept { return At(this->m_Start + n); }
+
+		reference at(size_type n) {
+			if (n >= size())
+				throw std::out_of_range{ "mstl::deque::at: index out of range" };
+			return (*this)[n];
+		}
+
+		const_reference at(size_type n) const {
+			if (n >= size())
+				throw std::out_of_range{ "mstl::deque::at: index out of range" };
+			return (*this)[n];
+		}
+
+		reference front() noexcept { return At(this->m_Start); }
+		const_reference front() const noexcept { return At(this->m_Start); }
+		reference back() noexcept { return At(this->m_Start + this->m_Size - 1); }
+		const_reference back() const noexcept { return At(this->m_Start + this->m_Size - 1); }
+
+		bool empty() const noexcept { return this->m_Size == 0; }
+		size_type size() const noexcept { return this->m_Size; }
+
+		// ================= Modifiers =================
+
+		void push_back(const value_type& v) { emplace_back(v); }
+		void push_back(value_type&& v) { emplace_back(std::move(v)); }
+		void push_front(const value_type& v) { emplace_front(v); }
+		void push_front(value_type&& v) { emplace_front(std::move(v)); }
+
+		template<class... Args>
+		reference emplace_back(Args&&... args) {
+
+			if (((this->m_Start + this->m_Size) >> block_shift) >= this->m_MapSize)
+				this->DoGrowMap(false);
+
+			const size_type i = this->m_Start + this->m_Size;
+			T* p = DoConstructAt(i, std::forward<Args>(args)...);
+
+			++this->m_Size;
+			return *p;
+		}
+
+		template<class... Args>
+		reference emplace_front(Args&&... args) {
+
+			if (this->m_Start == 0)
+				this->DoGrowMap(true);
+
+			const size_type i = this->m_Start - 1;
+			T* p = DoConstructAt(i, std::forward<Args>(args)...);
+
+			this->m_Start = i;
+			++this->m_Size;
+			return *p;
+		}
+
+		void pop_front() noexcept {
+
+			const size_type i = this->m_Start;
+			alloc_traits::destroy(this->m_Alloc, &At(i));
+
+			++this->m_Start;
+			--this->m_Size;
+
+			if (this->m_Size == 0 || (this->m_Start & block_mask) == 0)
+				this->DoReleaseBlock(i >> block_shift);
+
+			if (this->m_Size == 0)
+				this->DoRecentre();
+		}
+
+		void pop_back() noexcept {
+
+			--this->m_Size;
+			const size_type i = this->m_Start + this->m_Size;
+			alloc_traits::destroy(this->m_Alloc, &At(i));
+
+			if (this->m_Size == 0 || (i & block_mask) == 0)
+				this->DoReleaseBlock(i >> block_shift);
+
+			if (this->m_Size == 0)
+				this->DoRecentre();
+		}
+
+		void clear() noexcept {
+			this->DoClear();
+		}
+
+	private:
+
+		//
+		// ================= Helpers =================
+		//
+
+		T& At(size_type i) noexcept { return this->mp_Map[i >> block_shift][i & block_mask]; }
+		const T& At(size_type i) const noexcept { return this->mp_Map[i >> block_shift][i & block_mask]; }
+
+		// builds element index i, acquiring its block if it is the first
+		// one there (and giving it back if the construction throws)
+		template<class... Args>
+		T* DoConstructAt(size_type i, Args&&... args) {
+
+			const size_type slot = i >> block_shift;
+			T* block = this->mp_Map[slot];
+			const bool fresh = !block;
+
+			if (fresh) block = this->DoAcquireBlock(slot);
+
+			T* p = block + (i & block_mask);
+
+			try {
+				alloc_traits::construct(this->m_Alloc, p, std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				if (fresh) this->DoReleaseBlock(slot);
+				throw;
+			}
+
+			return p;
+		}
+	};
+
+	template<typename T, typename A>
+	bool operator==(const deque<T, A>& a, const deque<T, A>& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template<typename T, typename A>
+	void swap(deque<T, A>& a, deque<T, A>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // !MSTL_DEQUE_H
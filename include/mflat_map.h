@@ -0,0 +1,504 @@
+#ifndef MSTL_FLAT_MAP_H
+#define MSTL_FLAT_MAP_H
+
+#include "mvector.h"
+#include "internals/tree.h"   // sorted_unique_t
+#include <compare>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Flat search helpers
+	/// ---------------------------------------------------------------
+	/// Branchless binary search on a sorted array: the loop always
+	/// runs ceil(log2(n)) times and the step is a conditional move,
+	/// so there are no mispredicted branches on random keys.
+
+	template<typename K, typename Key, typename Compare>
+	inline std::size_t FlatLowerBound(const K* first, std::size_t n, const Key& key, const Compare& comp)
+	{
+		if (n == 0) return 0;
+
+		const K* base = first;
+
+		while (n > 1)
+		{
+			const std::size_t half = n / 2;
+			base = comp(base[half], key) ? base + half : base;
+			n -= half;
+		}
+
+		return static_cast<std::size_t>(base - first) + (comp(*base, key) ? 1 : 0);
+	}
+
+	template<typename K, typename Key, typename Compare>
+	inline std::size_t FlatUpperBound(const K* first, std::size_t n, const Key& key, const Compare& comp)
+	{
+		if (n == 0) return 0;
+
+		const K* base = first;
+
+		while (n > 1)
+		{
+			const std::size_t half = n / 2;
+			base = !comp(key, base[half]) ? base + half : base;
+			n -= half;
+		}
+
+		return static_cast<std::size_t>(base - first) + (!comp(key, *base) ? 1 : 0);
+	}
+
+	// the flat containers search and walk their storage through raw
+	// pointers: key/value containers must be contiguous
+	template<typename C>
+	concept FlatStorage = std::contiguous_iterator<typename C::iterator>;
+
+	/// ---------------------------------------------------------------
+	/// Flat map iterator
+	/// ---------------------------------------------------------------
+	/// Walks the key and the value arrays in lockstep. Dereferencing
+	/// gives a pair of references (as std::flat_map does), there is no
+	/// stored pair<const Key, T> to point to.
+
+	template<typename Key, typename T, bool IsConst>
+	class flat_map_iterator {
+
+		using mapped_ptr = std::conditional_t<IsConst, const T*, T*>;
+
+		const Key* mp_Key{};
+		mapped_ptr mp_Val{};
+
+	public:
+
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type        = std::pair<Key, T>;
+		using difference_type   = std::ptrdiff_t;
+		using reference         = std::pair<const Key&, std::conditional_t<IsConst, const T&, T&>>;
+
+		// operator-> needs an address: keep the pair alive in a proxy
+		struct pointer {
+			reference m_Ref;
+			const reference* operator->() const noexcept { return std::addressof(m_Ref); }
+		};
+
+		flat_map_iterator() = default;
+
+		flat_map_iterator(const Key* k, mapped_ptr v) noexcept : mp_Key{ k }, mp_Val{ v } {}
+
+		template<bool C = IsConst, typename = std::enable_if_t<C>>
+		flat_map_iterator(const flat_map_iterator<Key, T, false>& other) noexcept
+			: mp_Key{ other.mp_Key }, mp_Val{ other.mp_Val } {
+		}
+
+		reference operator*() const noexcept { return { *mp_Key, *mp_Val }; }
+		pointer operator->() const noexcept { return pointer{ **this }; }
+		reference operator[](difference_type n) const noexcept { return { mp_Key[n], mp_Val[n] }; }
+
+		const Key& key() const noexcept { return *mp_Key; }
+		std::conditional_t<IsConst, const T&, T&> value() const noexcept { return *mp_Val; }
+
+		flat_map_iterator& operator++() noexcept { ++mp_Key; ++mp_Val; return *this; }
+		flat_map_iterator& operator--() noexcept { --mp_Key; --mp_Val; return *this; }
+		flat_map_iterator operator++(int) noexcept { flat_map_iterator tmp = *this; ++(*this); return tmp; }
+		flat_map_iterator operator--(int) noexcept { flat_map_iterator tmp = *this; --(*this); return tmp; }
+
+		flat_map_iterator& operator+=(difference_type n) noexcept { mp_Key += n; mp_Val += n; return *this; }
+		flat_map_iterator& operator-=(difference_type n) noexcept { mp_Key -= n; mp_Val -= n; return *this; }
+
+		friend flat_map_iterator operator+(flat_map_iterator it, difference_type n) noexcept { return it += n; }
+		friend flat_map_iterator operator+(difference_type n, flat_map_iterator it) noexcept { return it += n; }
+		friend flat_map_iterator operator-(flat_map_iterator it, difference_type n) noexcept { return it -= n; }
+
+		friend difference_type operator-(const flat_map_iterator& a, const flat_map_iterator& b) noexcept { return a.mp_Key - b.mp_Key; }
+
+		friend bool operator==(const flat_map_iterator& a, const flat_map_iterator& b) noexcept { return a.mp_Key == b.mp_Key; }
+		friend auto operator<=>(const flat_map_iterator& a, const flat_map_iterator& b) noexcept { return a.mp_Key <=> b.mp_Key; }
+
+	private:
+
+		template<typename, typename, bool>
+		friend class flat_map_iterator;
+	};
+
+	/// ---------------------------------------------------------------
+	/// Flat Map
+	/// ---------------------------------------------------------------
+	/// Sorted unique keys and their values in two parallel vectors:
+	/// no per-entry node, lookups binary search a contiguous key
+	/// array, iteration is a linear scan.
+	///
+	/// Single insert/erase shift the tail, O(n): build with
+	/// insert_range (sort + merge, O(n + m log m)) or the sorted_unique
+	/// constructor. Any insert/erase invalidates iterators.
+
+	template<
+		typename Key,
+		typename T,
+		typename Compare = std::less<Key>,
+		FlatStorage KeyContainer = mstl::vector<Key>,
+		FlatStorage MappedContainer = mstl::vector<T>
+	>
+	class flat_map {
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<Key, T>;
+		using key_compare = Compare;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using key_container_type = KeyContainer;
+		using mapped_container_type = MappedContainer;
+
+		using iterator       = flat_map_iterator<Key, T, false>;
+		using const_iterator = flat_map_iterator<Key, T, true>;
+
+		using reverse_iterator       = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	private:
+
+		key_container_type    m_Keys;
+		mapped_container_type m_Values;
+		[[no_unique_address]] key_compare m_Comp{};
+
+	public:
+
+		// ================= Constructors =================
+		flat_map() = default;
+
+		explicit flat_map(const key_compare& comp)
+			: m_Comp(comp) {
+		}
+
+		template<class InputIt>
+		flat_map(InputIt first, InputIt last, const key_compare& comp = key_compare{})
+			: m_Comp(comp)
+		{
+			insert_range(first, last);
+		}
+
+		// [first, last) sorted by key, no duplicates: plain append
+		template<class InputIt>
+		flat_map(sorted_unique_t, InputIt first, InputIt last, const key_compare& comp = key_compare{})
+			: m_Comp(comp)
+		{
+			for (; first != last; ++first)
+			{
+				const auto& [k, v] = *first;
+				m_Keys.push_back(k);
+				m_Values.push_back(v);
+			}
+		}
+
+		flat_map(std::initializer_list<value_type> il, const key_compare& comp = key_compare{})
+			: flat_map(il.begin(), il.end(), comp) {
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return iterator{ keys_data(), values_data() }; }
+		const_iterator begin() const noexcept { return const_iterator{ keys_data(), values_data() }; }
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		iterator end() noexcept { return begin() + static_cast<difference_type>(size()); }
+		const_iterator end() const noexcept { return begin() + static_cast<difference_type>(size()); }
+		const_iterator cend() const noexcept { return end(); }
+
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Keys.size() == 0; }
+		size_type size() const noexcept { return m_Keys.size(); }
+
+		void reserve(size_type n)
+		{
+			m_Keys.reserve(n);
+			m_Values.reserve(n);
+		}
+
+		// ================= Modifiers =================
+
+		void clear() noexcept
+		{
+			m_Keys.resize(0);
+			m_Values.resize(0);
+		}
+
+		std::pair<iterator, bool> insert(const value_type& val)
+		{
+			return insert_unique(val.first, val.second);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& val)
+		{
+			return insert_unique(std::move(val.first), std::move(val.second));
+		}
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			value_type tmp(std::forward<Args>(args)...);
+			return insert_unique(std::move(tmp.first), std::move(tmp.second));
+		}
+
+		/// Batched insert: the new entries are sorted on their own and
+		/// merged with the current ones in a single backward pass, instead
+		/// of m shifting inserts. Keys already present (or repeated in the
+		/// input) keep the first value, like m inserts would.
+		template<class InputIt>
+		void insert_range(InputIt first, InputIt last)
+		{
+			std::vector<value_type> batch;
+
+			for (; first != last; ++first)
+				batch.emplace_back(*first);
+
+			if (batch.empty()) return;
+
+			// stable: among equal keys the first one seen survives unique
+			std::stable_sort(batch.begin(), batch.end(), [this](const value_type& a, const value_type& b) {
+				return m_Comp(a.first, b.first);
+			});
+
+			auto equal_keys = [this](const value_type& a, const value_type& b) {
+				return !m_Comp(a.first, b.first) && !m_Comp(b.first, a.first);
+			};
+
+			batch.erase(std::unique(batch.begin(), batch.end(), equal_keys), batch.end());
+
+			// drop the keys we already have (both sides sorted: one pass)
+			const size_type old_n = size();
+			size_type i = 0;
+
+			auto kept = std::remove_if(batch.begin(), batch.end(), [&](const value_type& v) {
+				while (i < old_n && m_Comp(m_Keys[i], v.first)) ++i;
+				return i < old_n && !m_Comp(v.first, m_Keys[i]);
+			});
+
+			batch.erase(kept, batch.end());
+
+			if (batch.empty()) return;
+
+			// grow both arrays, then merge from the back: every element
+			// moves at most once
+			const size_type new_n = old_n + batch.size();
+
+			m_Keys.resize(new_n);
+
+			try {
+				m_Values.resize(new_n);
+			}
+			catch (...)
+			{
+				m_Keys.resize(old_n);
+				throw;
+			}
+
+			size_type src = old_n;
+			size_type add = batch.size();
+			size_type dst = new_n;
+
+			while (add > 0)
+			{
+				--dst;
+
+				if (src > 0 && m_Comp(batch[add - 1].first, m_Keys[src - 1]))
+				{
+					--src;
+					m_Keys[dst] = std::move(m_Keys[src]);
+					m_Values[dst] = std::move(m_Values[src]);
+				}
+				else
+				{
+					--add;
+					m_Keys[dst] = std::move(batch[add].first);
+					m_Values[dst] = std::move(batch[add].second);
+				}
+			}
+		}
+
+		iterator erase(const_iterator pos)
+		{
+			const size_type i = index_of(pos);
+			m_Keys.erase(m_Keys.begin() + i);
+			m_Values.erase(m_Values.begin() + i);
+			return begin() + static_cast<difference_type>(i);
+		}
+
+		size_type erase(const key_type& key)
+		{
+			const size_type i = find_index(key);
+			if (i == size()) return 0;
+			erase(begin() + static_cast<difference_type>(i));
+			return 1;
+		}
+
+		void swap(flat_map& other) noexcept
+		{
+			using std::swap;
+			swap(m_Keys, other.m_Keys);
+			swap(m_Values, other.m_Values);
+			swap(m_Comp, other.m_Comp);
+		}
+
+		// ================= Element access =================
+
+		// lookup first: T is value-initialized only for a new key
+		T& operator[](const Key& key)
+		{
+			return subscript(key);
+		}
+
+		T& operator[](Key&& key)
+		{
+			return subscript(std::move(key));
+		}
+
+		T& at(const Key& key)
+		{
+			const size_type i = find_index(key);
+			if (i == size()) throw std::out_of_range("mstl::flat_map::at: key not found");
+			return m_Values[i];
+		}
+
+		const T& at(const Key& key) const
+		{
+			const size_type i = find_index(key);
+			if (i == size()) throw std::out_of_range("mstl::flat_map::at: key not found");
+			return m_Values[i];
+		}
+
+		// ================= Lookup =================
+
+		iterator find(const Key& key) { return begin() + static_cast<difference_type>(find_index(key)); }
+		const_iterator find(const Key& key) const { return begin() + static_cast<difference_type>(find_index(key)); }
+
+		size_type count(const Key& key) const { return find_index(key) == size() ? 0 : 1; }
+		bool contains(const Key& key) const { return find_index(key) != size(); }
+
+		iterator lower_bound(const Key& key) { return begin() + static_cast<difference_type>(lower_index(key)); }
+		const_iterator lower_bound(const Key& key) const { return begin() + static_cast<difference_type>(lower_index(key)); }
+
+		iterator upper_bound(const Key& key) { return begin() + static_cast<difference_type>(upper_index(key)); }
+		const_iterator upper_bound(const Key& key) const { return begin() + static_cast<difference_type>(upper_index(key)); }
+
+		std::pair<iterator, iterator> equal_range(const Key& key) { return { lower_bound(key), upper_bound(key) }; }
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return { lower_bound(key), upper_bound(key) }; }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Comp; }
+
+		const key_container_type& keys() const noexcept { return m_Keys; }
+		const mapped_container_type& values() const noexcept { return m_Values; }
+
+		friend bool operator==(const flat_map& a, const flat_map& b)
+		{
+			return a.size() == b.size()
+				&& std::equal(a.m_Keys.begin(), a.m_Keys.end(), b.m_Keys.begin())
+				&& std::equal(a.m_Values.begin(), a.m_Values.end(), b.m_Values.begin());
+		}
+
+		friend bool operator!=(const flat_map& a, const flat_map& b) { return !(a == b); }
+
+	private:
+
+		// ================= Helpers =================
+
+		const Key* keys_data() const noexcept { return std::to_address(m_Keys.begin()); }
+		T* values_data() noexcept { return std::to_address(m_Values.begin()); }
+		const T* values_data() const noexcept { return std::to_address(m_Values.begin()); }
+
+		size_type lower_index(const Key& key) const {
+			return FlatLowerBound(keys_data(), size(), key, m_Comp);
+		}
+
+		size_type upper_index(const Key& key) const {
+			return FlatUpperBound(keys_data(), size(), key, m_Comp);
+		}
+
+		// size() when missing
+		size_type find_index(const Key& key) const
+		{
+			const size_type i = lower_index(key);
+			return i < size() && !m_Comp(key, m_Keys[i]) ? i : size();
+		}
+
+		size_type index_of(const_iterator it) const noexcept {
+			return static_cast<size_type>(it - begin());
+		}
+
+		template<typename K, typename V>
+		std::pair<iterator, bool> insert_unique(K&& key, V&& value)
+		{
+			const size_type i = lower_index(key);
+
+			if (i < size() && !m_Comp(key, m_Keys[i]))
+				return { begin() + static_cast<difference_type>(i), false };
+
+			insert_at(i, std::forward<K>(key), std::forward<V>(value));
+			return { begin() + static_cast<difference_type>(i), true };
+		}
+
+		template<typename K>
+		T& subscript(K&& key)
+		{
+			const size_type i = lower_index(key);
+
+			if (i == size() || m_Comp(key, m_Keys[i]))
+				insert_at(i, std::forward<K>(key), T{});
+
+			return m_Values[i];
+		}
+
+		// appends the entry, then rotates it down to slot i
+		template<typename K, typename V>
+		void insert_at(size_type i, K&& key, V&& value)
+		{
+			const size_type n = size();
+
+			// geometric growth: resize alone would reallocate every time
+			if (n == m_Keys.capacity()) reserve(n == 0 ? 8 : 2 * n);
+
+			m_Keys.resize(n + 1);
+
+			try {
+				m_Values.resize(n + 1);
+				m_Keys[n] = std::forward<K>(key);
+				m_Values[n] = std::forward<V>(value);
+			}
+			catch (...)
+			{
+				m_Keys.resize(n);
+				if (m_Values.size() > n) m_Values.resize(n);
+				throw;
+			}
+
+			std::rotate(m_Keys.begin() + i, m_Keys.begin() + n, m_Keys.end());
+			std::rotate(m_Values.begin() + i, m_Values.begin() + n, m_Values.end());
+		}
+	};
+
+	template<typename K, typename T, typename C, typename KC, typename MC>
+	void swap(flat_map<K, T, C, KC, MC>& a, flat_map<K, T, C, KC, MC>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // ! MSTL_FLAT_MAP_H
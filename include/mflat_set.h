@@ -0,0 +1,241 @@
+#ifndef MSTL_FLAT_SET_H
+#define MSTL_FLAT_SET_H
+
+#include "mflat_map.h"   // FlatLowerBound, FlatUpperBound
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Flat Set
+	/// ---------------------------------------------------------------
+	/// Sorted unique keys in one vector (see flat_map).
+	/// Iterators are constant: keys can't change in place.
+
+	template<
+		typename Key,
+		typename Compare = std::less<Key>,
+		FlatStorage KeyContainer = mstl::vector<Key>
+	>
+	class flat_set {
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using key_compare = Compare;
+		using value_compare = Compare;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using container_type = KeyContainer;
+
+		using iterator       = const Key*;
+		using const_iterator = const Key*;
+
+		using reverse_iterator       = std::reverse_iterator<const_iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	private:
+
+		container_type m_Keys;
+		[[no_unique_address]] key_compare m_Comp{};
+
+	public:
+
+		// ================= Constructors =================
+		flat_set() = default;
+
+		explicit flat_set(const key_compare& comp)
+			: m_Comp(comp) {
+		}
+
+		template<class InputIt>
+		flat_set(InputIt first, InputIt last, const key_compare& comp = key_compare{})
+			: m_Comp(comp)
+		{
+			insert_range(first, last);
+		}
+
+		// [first, last) sorted, no duplicates: plain append
+		template<class InputIt>
+		flat_set(sorted_unique_t, InputIt first, InputIt last, const key_compare& comp = key_compare{})
+			: m_Comp(comp)
+		{
+			for (; first != last; ++first)
+				m_Keys.push_back(*first);
+		}
+
+		flat_set(std::initializer_list<value_type> il, const key_compare& comp = key_compare{})
+			: flat_set(il.begin(), il.end(), comp) {
+		}
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept { return std::to_address(m_Keys.begin()); }
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		const_iterator end() const noexcept { return begin() + size(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+		const_reverse_iterator crend() const noexcept { return rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Keys.size() == 0; }
+		size_type size() const noexcept { return m_Keys.size(); }
+
+		void reserve(size_type n) { m_Keys.reserve(n); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Keys.resize(0); }
+
+		std::pair<iterator, bool> insert(const value_type& val) { return insert_unique(val); }
+		std::pair<iterator, bool> insert(value_type&& val) { return insert_unique(std::move(val)); }
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return insert_unique(value_type(std::forward<Args>(args)...));
+		}
+
+		/// Batched insert: sort + unique the new keys, drop the ones
+		/// already present, then one backward merge (see flat_map).
+		template<class InputIt>
+		void insert_range(InputIt first, InputIt last)
+		{
+			std::vector<value_type> batch(first, last);
+
+			if (batch.empty()) return;
+
+			std::sort(batch.begin(), batch.end(), m_Comp);
+
+			batch.erase(std::unique(batch.begin(), batch.end(), [this](const value_type& a, const value_type& b) {
+				return !m_Comp(a, b) && !m_Comp(b, a);
+			}), batch.end());
+
+			const size_type old_n = size();
+			size_type i = 0;
+
+			auto kept = std::remove_if(batch.begin(), batch.end(), [&](const value_type& v) {
+				while (i < old_n && m_Comp(m_Keys[i], v)) ++i;
+				return i < old_n && !m_Comp(v, m_Keys[i]);
+			});
+
+			batch.erase(kept, batch.end());
+
+			if (batch.empty()) return;
+
+			m_Keys.resize(old_n + batch.size());
+
+			size_type src = old_n;
+			size_type add = batch.size();
+			size_type dst = m_Keys.size();
+
+			while (add > 0)
+			{
+				--dst;
+
+				if (src > 0 && m_Comp(batch[add - 1], m_Keys[src - 1]))
+					m_Keys[dst] = std::move(m_Keys[--src]);
+				else
+					m_Keys[dst] = std::move(batch[--add]);
+			}
+		}
+
+		iterator erase(const_iterator pos)
+		{
+			const size_type i = static_cast<size_type>(pos - begin());
+			m_Keys.erase(m_Keys.begin() + i);
+			return begin() + i;
+		}
+
+		size_type erase(const key_type& key)
+		{
+			const size_type i = find_index(key);
+			if (i == size()) return 0;
+			m_Keys.erase(m_Keys.begin() + i);
+			return 1;
+		}
+
+		void swap(flat_set& other) noexcept
+		{
+			using std::swap;
+			swap(m_Keys, other.m_Keys);
+			swap(m_Comp, other.m_Comp);
+		}
+
+		// ================= Lookup =================
+
+		const_iterator find(const Key& key) const { return begin() + find_index(key); }
+
+		size_type count(const Key& key) const { return find_index(key) == size() ? 0 : 1; }
+		bool contains(const Key& key) const { return find_index(key) != size(); }
+
+		const_iterator lower_bound(const Key& key) const { return begin() + FlatLowerBound(begin(), size(), key, m_Comp); }
+		const_iterator upper_bound(const Key& key) const { return begin() + FlatUpperBound(begin(), size(), key, m_Comp); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return { lower_bound(key), upper_bound(key) }; }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Comp; }
+		value_compare value_comp() const { return m_Comp; }
+
+		const container_type& keys() const noexcept { return m_Keys; }
+
+		friend bool operator==(const flat_set& a, const flat_set& b)
+		{
+			return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+		}
+
+		friend bool operator!=(const flat_set& a, const flat_set& b) { return !(a == b); }
+
+	private:
+
+		// size() when missing
+		size_type find_index(const Key& key) const
+		{
+			const size_type i = FlatLowerBound(begin(), size(), key, m_Comp);
+			return i < size() && !m_Comp(key, m_Keys[i]) ? i : size();
+		}
+
+		template<typename K>
+		std::pair<iterator, bool> insert_unique(K&& key)
+		{
+			const size_type i = FlatLowerBound(begin(), size(), key, m_Comp);
+
+			if (i < size() && !m_Comp(key, m_Keys[i]))
+				return { begin() + i, false };
+
+			// append, then rotate down to slot i (geometric growth)
+			const size_type n = size();
+			if (n == m_Keys.capacity()) m_Keys.reserve(n == 0 ? 8 : 2 * n);
+
+			m_Keys.resize(n + 1);
+
+			try {
+				m_Keys[n] = std::forward<K>(key);
+			}
+			catch (...)
+			{
+				m_Keys.resize(n);
+				throw;
+			}
+
+			std::rotate(m_Keys.begin() + i, m_Keys.begin() + n, m_Keys.end());
+			return { begin() + i, true };
+		}
+	};
+
+	template<typename K, typename C, typename KC>
+	void swap(flat_set<K, C, KC>& a, flat_set<K, C, KC>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // ! MSTL_FLAT_SET_H
@@ -0,0 +1,262 @@
+#ifndef MSTL_INTRUSIVE_LIST_H
+#define MSTL_INTRUSIVE_LIST_H
+
+#include <iterator>
+#include <memory>
+#include <cstddef>
+#include <cassert>
+#include "internals/link.h"
+
+namespace mstl {
+
+	/// Intrusive doubly linked list: the links live in the elements.
+	///
+	///   struct session {
+	///       mstl::linkbase m_ByHost;
+	///       mstl::linkbase m_Idle;
+	///       ...
+	///   };
+	///   mstl::intrusive_list<session, &session::m_ByHost> byHost;
+	///   mstl::intrusive_list<session, &session::m_Idle> idle;
+	///
+	/// The list never allocates, copies or destroys an element: it only
+	/// relinks hooks (the same ring and helpers as mstl::list), so an
+	/// object can be in as many lists as it has hooks and its lifetime
+	/// stays with the owner.
+	///
+	/// An unlinked hook is null: unlink(obj) takes an object out of
+	/// whatever list it is in, in O(1) and without knowing the list
+	/// (e.g. from the object's destructor). For that reason the size is
+	/// not stored, size() walks the ring: O(n), empty() is O(1).
+	///
+	/// [!] an object must be unlinked before it is destroyed or moved;
+	///     the list's destructor unlinks whatever is still in it.
+
+	template<typename T, linkbase T::* Hook>
+	class intrusive_list {
+
+	public:
+
+		using value_type = T;
+		using reference = T&;
+		using const_reference = const T&;
+		using size_type = std::size_t;
+
+	private:
+
+		linkbase m_Master{};
+
+		// hook -> object, through the offset of the hook member
+		static std::ptrdiff_t HookOffset() noexcept {
+			alignas(T) static unsigned char probe[sizeof(T)];
+			const T* obj = reinterpret_cast<const T*>(probe);
+			return reinterpret_cast<const unsigned char*>(&(obj->*Hook)) - probe;
+		}
+
+		static T* Owner(linkbase* h) noexcept {
+			return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(h) - HookOffset());
+		}
+
+		static const T* Owner(const linkbase* h) noexcept {
+			return reinterpret_cast<const T*>(reinterpret_cast<const unsigned char*>(h) - HookOffset());
+		}
+
+		static linkbase* HookOf(T& obj) noexcept { return &(obj.*Hook); }
+
+	public:
+
+		// Iterator
+
+		class iterator {
+
+		private:
+
+			linkbase* curr{};
+
+		public:
+
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T*;
+			using reference = T&;
+
+			iterator() = default;
+			explicit iterator(linkbase* p) : curr{ p } {}
+			linkbase* base() noexcept { return curr; }
+			reference operator*() const { return *Owner(curr); }
+			pointer operator->() const { return Owner(curr); }
+			iterator& operator++() { curr = curr->succ; return *this; }
+			iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+			iterator& operator--() { curr = curr->prev; return *this; }
+			iterator operator--(int) { auto tmp = *this; --*this; return tmp; }
+			bool operator==(const iterator& other_it) const noexcept { return this->curr == other_it.curr; }
+			bool operator!=(const iterator& other_it) const noexcept { return !(*this == other_it); }
+		};
+
+		// Const Iterator
+
+		class const_iterator {
+
+		private:
+
+			const linkbase* curr{};
+
+		public:
+
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+
+			const_iterator() = default;
+			explicit const_iterator(const linkbase* p) : curr{ p } {}
+			const linkbase* base() const noexcept { return curr; }
+			reference operator*() const { return *Owner(curr); }
+			pointer operator->() const { return Owner(curr); }
+			const_iterator& operator++() { curr = curr->succ; return *this; }
+			const_iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+			const_iterator& operator--() { curr = curr->prev; return *this; }
+			const_iterator operator--(int) { auto tmp = *this; --*this; return tmp; }
+			bool operator==(const const_iterator& other_it) const noexcept { return this->curr == other_it.curr; }
+			bool operator!=(const const_iterator& other_it) const noexcept { return !(*this == other_it); }
+		};
+
+		// ================= Ctors =================
+
+		intrusive_list() noexcept {
+			m_Master.prev = m_Master.succ = &m_Master;
+		}
+
+		// the elements can't be shared by two lists through one hook
+		intrusive_list(const intrusive_list&) = delete;
+		intrusive_list& operator=(const intrusive_list&) = delete;
+
+		intrusive_list(intrusive_list&& other) noexcept {
+			ListAdoptRing(&m_Master, &other.m_Master);
+		}
+
+		intrusive_list& operator=(intrusive_list&& other) noexcept {
+			if (this != &other)
+			{
+				clear();
+				ListAdoptRing(&m_Master, &other.m_Master);
+			}
+			return *this;
+		}
+
+		~intrusive_list() {
+			clear();
+		}
+
+		iterator begin() noexcept { return iterator{ m_Master.succ }; }
+		const_iterator begin() const noexcept { return const_iterator{ m_Master.succ }; }
+		iterator end() noexcept { return iterator{ &m_Master }; }
+		const_iterator end() const noexcept { return const_iterator{ &m_Master }; }
+
+		//
+		// ================= Access =================
+		//
+
+		reference front() { return *Owner(m_Master.succ); }
+		const_reference front() const { return *Owner(m_Master.succ); }
+		reference back() { return *Owner(m_Master.prev); }
+		const_reference back() const { return *Owner(m_Master.prev); }
+
+		bool empty() const noexcept { return m_Master.succ == &m_Master; }
+
+		// O(n): see above
+		size_type size() const noexcept {
+			return static_cast<size_type>(std::distance(begin(), end()));
+		}
+
+		// iterator to an element known to be in this list, O(1)
+		static iterator iterator_to(T& obj) noexcept { return iterator{ HookOf(obj) }; }
+
+		static bool is_linked(const T& obj) noexcept { return (obj.*Hook).succ != nullptr; }
+
+		//
+		// ================= Modifiers =================
+		//
+
+		void push_back(T& obj) noexcept { insert(end(), obj); }
+		void push_front(T& obj) noexcept { insert(begin(), obj); }
+		void pop_back() noexcept { unlink(back()); }
+		void pop_front() noexcept { unlink(front()); }
+
+		iterator insert(iterator pos, T& obj) noexcept {
+
+			assert(!is_linked(obj) && "intrusive_list: object already linked through this hook");
+
+			linkbase* const h = HookOf(obj);
+			ListLinkBefore(pos.base(), h);
+			return iterator{ h };
+		}
+
+		// unlinks *pos, returns the next position
+		iterator erase(iterator pos) noexcept {
+
+			linkbase* const next = pos.base()->succ;
+			unlink(*pos);
+			return iterator{ next };
+		}
+
+		iterator erase(T& obj) noexcept {
+			return erase(iterator_to(obj));
+		}
+
+		// takes obj out of its list, whichever it is; no-op if not linked
+		static void unlink(T& obj) noexcept {
+
+			linkbase* const h = HookOf(obj);
+
+			if (!h->succ)
+				return;
+
+			ListUnlink(h);
+			h->prev = h->succ = nullptr;
+		}
+
+		// unlinks every element (they are not destroyed)
+		void clear() noexcept {
+
+			linkbase* n = m_Master.succ;
+
+			while (n != &m_Master)
+			{
+				linkbase* const next = n->succ;
+				n->prev = n->succ = nullptr;
+				n = next;
+			}
+
+			m_Master.prev = m_Master.succ = &m_Master;
+		}
+
+		// moves all of other before pos
+		void splice(iterator pos, intrusive_list& other) noexcept {
+			if (this != &other)
+				ListTransfer(pos.base(), other.m_Master.succ, &other.m_Master);
+		}
+
+		// moves obj (an element of any list with this hook) before pos
+		void splice(iterator pos, T& obj) noexcept {
+			assert(is_linked(obj) && "intrusive_list: splice of an object not linked through this hook");
+
+			linkbase* const h = HookOf(obj);
+
+			if (pos.base() == h || pos.base() == h->succ)
+				return;
+
+			ListTransfer(pos.base(), h, h->succ);
+		}
+
+		void swap(intrusive_list& other) noexcept {
+			intrusive_list tmp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(tmp);
+		}
+	};
+}
+
+#endif // !MSTL_INTRUSIVE_LIST_H
@@ -4,21 +4,16 @@
 #include <memory>
 #include <vector>
 #include <iterator>
+#include <functional>
 #include <string>
 #include <iostream>
 #include <initializer_list>
 #include "concepts_utils.h"
+#include "internals/trace.h"
+#include "internals/link.h"
 
 namespace mstl {
 
-	// linkbase: node of a list
-
-	struct linkbase {
-
-		linkbase* prev;
-		linkbase* succ;
-	};
-
 	// link<T> for the list
 
 	template<typename T>
@@ -51,6 +46,7 @@ namespace mstl {
 		using difference_type = typename alloc_traits::difference_type;
 		using link_alloc = typename alloc_traits::template rebind_alloc<link_type>;
 		using link_traits = std::allocator_traits<link_alloc>;
+		using trace = trace_hook_t<list_rep>;    // null_trace unless MSTL_TRACE
 
 		// === Constructors ===
 
@@ -94,6 +90,10 @@ namespace mstl {
 		// For safety destroy nodes and then release memory
 		void DoClear() noexcept {
 
+			// if the allocator can drop every node at once
+			// only destructors are run while walking the list
+			const bool bulk = DoCanBulkRelease();
+
 			linkbase* p = m_LinkMaster.succ;
 
 			while (p != &m_LinkMaster) {
@@ -101,19 +101,49 @@ namespace mstl {
 				link_type* const pTemp = static_cast<link_type*>(p);
 				p = p->succ;
 				link_traits::destroy(m_LinkAlloc, pTemp);  // pTemp->~link_type();
-				DoDeallocateNode(pTemp);
+				if (!bulk) DoDeallocateNode(pTemp);
 			}
 
+			if (bulk) DoReleaseAll();
+
 			InitMaster();
 			m_Size = 0;
 		}
 
+		// Bulk release is possible when the allocator exposes it
+		// (see node_pool_allocator) and all its nodes are ours
+		bool DoCanBulkRelease() const noexcept {
+
+			if constexpr (requires(link_alloc& a, size_type n) { a.is_sole_owner(n); a.release(); })
+			{
+				return m_Size > 0 && m_LinkAlloc.is_sole_owner(m_Size);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		void DoReleaseAll() noexcept {
+
+			if constexpr (requires(link_alloc& a) { a.release(); })
+			{
+				m_LinkAlloc.release();
+
+				if constexpr (trace::enabled)
+					for (size_type i = 0; i < m_Size; ++i) trace::on_deallocate(sizeof(link_type));
+			}
+		}
+
 		link_type* DoAllocateNode() {
-			return link_traits::allocate(m_LinkAlloc, 1);
+			link_type* p = link_traits::allocate(m_LinkAlloc, 1);
+			trace::on_allocate(sizeof(link_type));
+			return p;
 		}
 
 		void DoDeallocateNode(link_type* p) noexcept {
 			link_traits::deallocate(m_LinkAlloc, p, 1);
+			trace::on_deallocate(sizeof(link_type));
 		}
 	};
 
@@ -158,7 +188,7 @@ namespace mstl {
 
 		using base_type = list_rep<T, A>;
 		using link_type = typename base_type::link_type;
-		using link_base = typename linkbase;
+		using link_base = linkbase;
 		using size_type = typename base_type::size_type;
 		using link_traits = typename base_type::link_traits;
 
@@ -270,7 +300,7 @@ namespace mstl {
 
 			auto* node = create_node(v);
 
-			link_before(pos.base(), node);
+			ListLinkBefore(pos.base(), node);
 
 			++(this->m_Size);
 
@@ -281,7 +311,7 @@ namespace mstl {
 
 			auto* node = create_node(std::move(v));
 
-			link_before(pos.base(), node);
+			ListLinkBefore(pos.base(), node);
 
 			++(this->m_Size);
 
@@ -299,7 +329,7 @@ namespace mstl {
 
 			link_base* const next = p->succ;
 
-			unlink(p);
+			ListUnlink(p);
 
 			destroy_node(static_cast<link_type*>(p));
 
@@ -308,6 +338,262 @@ namespace mstl {
 			return iterator{ next };
 		}
 
+		//
+		// ================= Operations =================
+		// Relinking only: no node is allocated and no element is
+		// copied or moved, iterators and references stay valid
+		// (they follow the element into the other list).
+		// Nodes spliced from another list must come from an equal
+		// allocator (the one that will deallocate them).
+		//
+
+		// moves all of other before pos
+		void splice(iterator pos, list& other) noexcept {
+
+			if (this == &other || other.empty())
+				return;
+
+			ListTransfer(pos.base(), other.m_LinkMaster.succ, &other.m_LinkMaster);
+
+			this->m_Size += other.m_Size;
+			other.m_Size = 0;
+		}
+
+		void splice(iterator pos, list&& other) noexcept {
+			splice(pos, other);
+		}
+
+		// moves *it (an element of other) before pos
+		void splice(iterator pos, list& other, iterator it) noexcept {
+
+			link_base* const n = it.base();
+
+			if (pos.base() == n || pos.base() == n->succ)
+				return;
+
+			ListTransfer(pos.base(), n, n->succ);
+
+			++this->m_Size;
+			--other.m_Size;
+		}
+
+		void splice(iterator pos, list&& other, iterator it) noexcept {
+			splice(pos, other, it);
+		}
+
+		// moves [first, last) of other before pos: O(distance) to
+		// keep the sizes, O(1) within the same list
+		void splice(iterator pos, list& other, iterator first, iterator last) noexcept {
+
+			if (first == last)
+				return;
+
+			if (this != &other)
+			{
+				const size_type n = static_cast<size_type>(std::distance(first, last));
+				this->m_Size += n;
+				other.m_Size -= n;
+			}
+
+			ListTransfer(pos.base(), first.base(), last.base());
+		}
+
+		void splice(iterator pos, list&& other, iterator first, iterator last) noexcept {
+			splice(pos, other, first, last);
+		}
+
+		/// Merges the sorted other into this sorted list, other ends up
+		/// empty. Stable: on ties the elements of *this come first.
+		/// Runs of other that go before the same element move with a
+		/// single relink.
+		template<typename Compare = std::less<>>
+		void merge(list& other, Compare comp = Compare{}) {
+
+			if (this == &other)
+				return;
+
+			link_base* const master = &this->m_LinkMaster;
+			link_base* const otherMaster = &other.m_LinkMaster;
+
+			link_base* p = master->succ;
+			link_base* q = otherMaster->succ;
+
+			while (p != master && q != otherMaster)
+			{
+				if (comp(value(q), value(p)))
+				{
+					// the run of other elements still less than *p
+					link_base* runEnd = q->succ;
+					while (runEnd != otherMaster && comp(value(runEnd), value(p)))
+						runEnd = runEnd->succ;
+
+					ListTransfer(p, q, runEnd);
+					q = runEnd;
+				}
+				else
+				{
+					p = p->succ;
+				}
+			}
+
+			if (q != otherMaster)
+				ListTransfer(master, q, otherMaster);
+
+			this->m_Size += other.m_Size;
+			other.m_Size = 0;
+		}
+
+		template<typename Compare = std::less<>>
+		void merge(list&& other, Compare comp = Compare{}) {
+			merge(other, comp);
+		}
+
+		/// Stable bottom-up merge sort over the links, O(n log n) with
+		/// O(1) extra space. The ring is opened into a null-terminated
+		/// succ chain, merged in passes of runs 1, 2, 4... (no recursion,
+		/// no buckets), then the prev pointers are rebuilt in one walk.
+		template<typename Compare = std::less<>>
+		void sort(Compare comp = Compare{}) {
+
+			if (this->m_Size < 2)
+				return;
+
+			link_base* const master = &this->m_LinkMaster;
+
+			link_base* head = master->succ;
+			master->prev->succ = nullptr;
+
+			for (size_type width = 1;; width *= 2)
+			{
+				link_base* p = head;
+				link_base* tail = nullptr;
+				size_type merges = 0;
+
+				head = nullptr;
+
+				while (p)
+				{
+					++merges;
+
+					// q: start of the second run
+					link_base* q = p;
+					size_type pSize = 0;
+					while (pSize < width && q) { ++pSize; q = q->succ; }
+
+					size_type qSize = width;
+
+					while (pSize > 0 || (qSize > 0 && q))
+					{
+						link_base* e;
+
+						// take from p unless q is strictly less: stable
+						if (pSize == 0) { e = q; q = q->succ; --qSize; }
+						else if (qSize == 0 || !q || !comp(value(q), value(p))) { e = p; p = p->succ; --pSize; }
+						else { e = q; q = q->succ; --qSize; }
+
+						if (tail) tail->succ = e;
+						else head = e;
+						tail = e;
+					}
+
+					p = q;
+				}
+
+				tail->succ = nullptr;
+
+				if (merges <= 1)
+					break;
+			}
+
+			// close the ring again, fixing prev
+			link_base* prev = master;
+			for (link_base* n = head; n; n = n->succ)
+			{
+				n->prev = prev;
+				prev->succ = n;
+				prev = n;
+			}
+
+			prev->succ = master;
+			master->prev = prev;
+		}
+
+		// erases consecutive duplicates, returns how many were removed
+		template<typename BinaryPredicate = std::equal_to<>>
+		size_type unique(BinaryPredicate pred = BinaryPredicate{}) {
+
+			link_base* const master = &this->m_LinkMaster;
+			size_type removed = 0;
+
+			if (master->succ == master)
+				return 0;
+
+			link_base* keep = master->succ;
+			link_base* n = keep->succ;
+
+			while (n != master)
+			{
+				link_base* const next = n->succ;
+
+				if (pred(value(keep), value(n)))
+				{
+					ListUnlink(n);
+					destroy_node(static_cast<link_type*>(n));
+					++removed;
+				}
+				else
+				{
+					keep = n;
+				}
+
+				n = next;
+			}
+
+			this->m_Size -= removed;
+			return removed;
+		}
+
+		template<typename Pred>
+		size_type remove_if(Pred pred) {
+
+			link_base* const master = &this->m_LinkMaster;
+			size_type removed = 0;
+
+			for (link_base* n = master->succ; n != master;)
+			{
+				link_base* const next = n->succ;
+
+				if (pred(value(n)))
+				{
+					ListUnlink(n);
+					destroy_node(static_cast<link_type*>(n));
+					++removed;
+				}
+
+				n = next;
+			}
+
+			this->m_Size -= removed;
+			return removed;
+		}
+
+		size_type remove(const value_type& v) {
+			// v may be an element of the list: compare against a copy
+			const value_type key(v);
+			return remove_if([&](const value_type& x) { return x == key; });
+		}
+
+		// swaps prev/succ of every link, the master included
+		void reverse() noexcept {
+
+			link_base* n = &this->m_LinkMaster;
+
+			do {
+				std::swap(n->prev, n->succ);
+				n = n->prev;    // the old succ
+			} while (n != &this->m_LinkMaster);
+		}
+
 	private:
 
 		//
@@ -333,16 +619,8 @@ namespace mstl {
 			this->DoDeallocateNode(n);
 		}
 
-		static void link_before(link_base* pos, link_base* n) noexcept {
-			n->succ = pos;
-			n->prev = pos->prev;
-			pos->prev->succ = n;
-			pos->prev = n;
-		}
-
-		static void unlink(link_base* n) noexcept {
-			n->prev->succ = n->succ;
-			n->succ->prev = n->prev;
+		static value_type& value(link_base* n) noexcept {
+			return static_cast<link_type*>(n)->m_Val;
 		}
 	};
 
@@ -2,6 +2,7 @@
 #define MSTL_MAP_H
 
 #include "internals/red_black_tree.h"
+#include <tuple>
 
 namespace mstl {
 
@@ -9,11 +10,17 @@ namespace mstl {
 	/// Map
 	/// ---------------------------------------------------------------
 
+	/// NodeT selects the tree node layout: rb_os_node adds
+	/// order statistics (rank, select, O(log n) distance),
+	/// rb_compact_node packs the color in the parent pointer
+	/// (one word less per node).
+
 	template<
 		typename Key,
 		typename T,
 		typename Compare = std::less<Key>,
-		typename Alloc = std::allocator<std::pair<const Key, T>>
+		typename Alloc = std::allocator<std::pair<const Key, T>>,
+		template<class> class NodeT = rb_node
 	>
 	class map {
 
@@ -30,7 +37,7 @@ namespace mstl {
 
 		using tree_type = rb_tree<
 			value_type,
-			rb_node,
+			NodeT,
 			first_key<value_type>,
 			key_compare,
 			allocator_type
@@ -38,11 +45,16 @@ namespace mstl {
 
 		tree_type m_Tree;
 
+		explicit map(tree_type&& t) noexcept : m_Tree(std::move(t)) {}
+
 	public:
 
 		using iterator       = typename tree_type::iterator;
 		using const_iterator = typename tree_type::const_iterator;
 
+		using reverse_iterator       = typename tree_type::reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
 		// ================= Constructors =================
 		map() = default;
 
@@ -58,6 +70,14 @@ namespace mstl {
 			: m_Tree(first, last, alloc, comp) {
 		}
 
+		// [first, last) sorted by key, no duplicates: O(n) build
+		template<class InputIt>
+		map(sorted_unique_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_unique, first, last, alloc, comp) {
+		}
+
 		map(std::initializer_list<value_type> il,
 			const key_compare& comp = key_compare{},
 			const allocator_type& alloc = allocator_type{})
@@ -74,6 +94,15 @@ namespace mstl {
 		const_iterator end() const noexcept { return m_Tree.end(); }
 		const_iterator cend() const noexcept { return m_Tree.end(); }
 
+		// O(1): the tree header caches the rightmost node
+		reverse_iterator rbegin() noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		reverse_iterator rend() noexcept { return m_Tree.rend(); }
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
 		// ================= Capacity =================
 
 		bool empty() const noexcept { return m_Tree.empty(); }
@@ -93,29 +122,112 @@ namespace mstl {
 			return m_Tree.insert(std::move(val));
 		}
 
+		// O(1) amortized when val goes right before or after hint:
+		// pass end() (or the last position) for ascending keys
+		iterator insert(const_iterator hint, const value_type& val)
+		{
+			return m_Tree.insert(hint, val);
+		}
+
+		iterator insert(const_iterator hint, value_type&& val)
+		{
+			return m_Tree.insert(hint, std::move(val));
+		}
+
 		template<class... Args>
 		std::pair<iterator, bool> emplace(Args&&... args)
 		{
 			return m_Tree.emplace(std::forward<Args>(args)...);
 		}
 
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			return m_Tree.emplace_hint(hint, std::forward<Args>(args)...);
+		}
+
+		// lookup first: on a hit nothing is built, key and args are
+		// left untouched; on a miss the value is built in the node
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key,
+				std::piecewise_construct,
+				std::forward_as_tuple(key),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		// key is moved from only when it is inserted
+		template<class... Args>
+		std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key,
+				std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj)
+		{
+			auto [it, inserted] = try_emplace(key, std::forward<M>(obj));
+			if (!inserted) (*it).second = std::forward<M>(obj);
+			return { it, inserted };
+		}
+
+		template<class M>
+		std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj)
+		{
+			auto [it, inserted] = try_emplace(std::move(key), std::forward<M>(obj));
+			if (!inserted) (*it).second = std::forward<M>(obj);
+			return { it, inserted };
+		}
+
 		void erase(iterator pos) { m_Tree.erase(pos); }
 		size_type erase(const key_type& key) { return m_Tree.erase(key); }
 
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) { return m_Tree.erase(key); }
+
 		void swap(map& other) noexcept { m_Tree.swap(other.m_Tree); }
 
+		// ================= Join / Split / Set operations =================
+		// O(log n) join and split, set operations in O(m log(n / m + 1))
+		// (m the smaller size), nodes relinked: see rb_tree
+
+		// every key of left < every key of right
+		static map join(map&& left, map&& right) noexcept
+		{
+			return map(tree_type::join(std::move(left.m_Tree), std::move(right.m_Tree)));
+		}
+
+		// every key of left < pivot.first < every key of right
+		static map join(map&& left, value_type pivot, map&& right)
+		{
+			return map(tree_type::join(std::move(left.m_Tree), std::move(pivot), std::move(right.m_Tree)));
+		}
+
+		// keeps the keys < key, returns the keys >= key
+		map split(const Key& key) { return map(m_Tree.split(key)); }
+
+		void merge(map& other) noexcept { m_Tree.merge(other.m_Tree); }
+
+		// on equal keys the values of *this are kept
+		void union_with(map&& other) noexcept { m_Tree.union_with(std::move(other.m_Tree)); }
+		void intersection_with(const map& other) noexcept { m_Tree.intersection_with(other.m_Tree); }
+		void difference_with(const map& other) noexcept { m_Tree.difference_with(other.m_Tree); }
+
 		// ================= Element access =================
 
+		// T is value-initialized in the node, only for a new key
 		T& operator[](const Key& key)
 		{
-			auto [it, inserted] = m_Tree.insert(std::make_pair(key, T{}));
-			return (*it).second;
+			return (*try_emplace(key).first).second;
 		}
 
 		T& operator[](Key&& key)
 		{
-			auto [it, inserted] = m_Tree.insert(std::make_pair(std::move(key), T{}));
-			return (*it).second;
+			return (*try_emplace(std::move(key)).first).second;
 		}
 
 		T& at(const Key& key)
@@ -132,6 +244,22 @@ namespace mstl {
 			return (*it).second;
 		}
 
+		template<class K> requires TransparentCompare<Compare>
+		T& at(const K& key)
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::map::at: key not found");
+			return (*it).second;
+		}
+
+		template<class K> requires TransparentCompare<Compare>
+		const T& at(const K& key) const
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::map::at: key not found");
+			return (*it).second;
+		}
+
 		// ================= Lookup =================
 
 		iterator find(const Key& key) {
@@ -147,9 +275,76 @@ namespace mstl {
 			return find(key) == end() ? 0 : 1;
 		}
 
+		bool contains(const Key& key) const { return m_Tree.contains(key); }
+
+		iterator lower_bound(const Key& key) { return m_Tree.lower_bound(key); }
+		const_iterator lower_bound(const Key& key) const { return m_Tree.lower_bound(key); }
+		iterator upper_bound(const Key& key) { return m_Tree.upper_bound(key); }
+		const_iterator upper_bound(const Key& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<iterator, iterator> equal_range(const Key& key) { return m_Tree.equal_range(key); }
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Heterogeneous lookup =================
+		// with a transparent Compare (e.g. map<std::string, T, std::less<>>)
+		// any K comparable with Key, no Key temporary per query
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator find(const K& key) { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator find(const K& key) const { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		size_type count(const K& key) const { return m_Tree.contains(key) ? 1 : 0; }
+
+		template<class K> requires TransparentCompare<Compare>
+		bool contains(const K& key) const { return m_Tree.contains(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator lower_bound(const K& key) { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator lower_bound(const K& key) const { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		iterator upper_bound(const K& key) { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator upper_bound(const K& key) const { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<iterator, iterator> equal_range(const K& key) { return m_Tree.equal_range(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Order statistics =================
+		// only with NodeT = rb_os_node
+
+		size_type rank(const Key& key) const requires tree_type::has_order_statistics {
+			return m_Tree.rank(key);
+		}
+
+		iterator select(size_type k) requires tree_type::has_order_statistics {
+			return m_Tree.select(k);
+		}
+
+		const_iterator select(size_type k) const requires tree_type::has_order_statistics {
+			return m_Tree.select(k);
+		}
+
+		size_type index_of(const_iterator it) const requires tree_type::has_order_statistics {
+			return m_Tree.index_of(it);
+		}
+
+		difference_type distance(const_iterator first, const_iterator last) const requires tree_type::has_order_statistics {
+			return m_Tree.distance(first, last);
+		}
+
 		// ================= Observers =================
 
-		key_compare key_comp() const { return m_Tree.m_Comp; }
+		key_compare key_comp() const { return m_Tree.key_comp(); }
 
 		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
 
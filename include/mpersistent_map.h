@@ -0,0 +1,231 @@
+#ifndef MSTL_PERSISTENT_MAP_H
+#define MSTL_PERSISTENT_MAP_H
+
+#include "internals/persistent_tree.h"
+#include <tuple>
+#include <stdexcept>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Persistent Map
+	/// ---------------------------------------------------------------
+	/// Ordered map with O(1) snapshots, backed by persistent_rb_tree:
+	/// a snapshot shares every node with the map, each later update
+	/// copies the O(log n) nodes it touches and leaves the snapshot as
+	/// it was. With no live snapshot updates run in place.
+	///
+	///   mstl::persistent_map<std::string, int> m;
+	///   ...
+	///   auto view = m.snapshot();   // hand it to a reader thread
+	///   m.insert_or_assign("k", 2); // view still sees the old state
+	///
+	/// Reading, copying and destroying a snapshot on another thread is
+	/// safe while the map keeps changing; the map itself has a single
+	/// writer. Values are read-only through iterators and there is no
+	/// operator[]: changes go through insert_or_assign / erase.
+	/// No node handles, hints or reverse iteration.
+
+	template<
+		typename Key,
+		typename T,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<std::pair<const Key, T>>
+	>
+	class persistent_map {
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using key_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+	private:
+
+		using tree_type = persistent_rb_tree<
+			value_type,
+			first_key<value_type>,
+			key_compare,
+			allocator_type
+		>;
+
+		tree_type m_Tree;
+
+	public:
+
+		using iterator       = typename tree_type::iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		// ================= Constructors =================
+		persistent_map() = default;
+
+		explicit persistent_map(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		persistent_map(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(first, last, alloc, comp) {
+		}
+
+		persistent_map(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(il, alloc, comp) {
+		}
+
+		// ================= Snapshots =================
+
+		// O(1): the copy shares the nodes, so does the copy constructor
+		persistent_map snapshot() const { return *this; }
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+		static constexpr size_type max_size() noexcept { return tree_type::max_size(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		std::pair<const_iterator, bool> insert(const value_type& val) { return m_Tree.insert(val); }
+		std::pair<const_iterator, bool> insert(value_type&& val) { return m_Tree.insert(std::move(val)); }
+
+		template<class InputIt>
+		void insert(InputIt first, InputIt last)
+		{
+			for (; first != last; ++first) m_Tree.insert(*first);
+		}
+
+		void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+
+		template<class... Args>
+		std::pair<const_iterator, bool> emplace(Args&&... args)
+		{
+			return m_Tree.emplace(std::forward<Args>(args)...);
+		}
+
+		// the value is built only if key is missing
+		template<class... Args>
+		std::pair<const_iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key, std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template<class... Args>
+		std::pair<const_iterator, bool> try_emplace(Key&& key, Args&&... args)
+		{
+			return m_Tree.emplace_if_absent(key, std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		// an existing value is assigned in its node, copied first if a
+		// snapshot shares it
+		template<class M>
+		std::pair<const_iterator, bool> insert_or_assign(const Key& key, M&& obj)
+		{
+			return m_Tree.assign_or_emplace(key,
+				[&](value_type& v) { v.second = std::forward<M>(obj); },
+				std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<M>(obj)));
+		}
+
+		template<class M>
+		std::pair<const_iterator, bool> insert_or_assign(Key&& key, M&& obj)
+		{
+			return m_Tree.assign_or_emplace(key,
+				[&](value_type& v) { v.second = std::forward<M>(obj); },
+				std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<M>(obj)));
+		}
+
+		size_type erase(const key_type& key) { return m_Tree.erase(key); }
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) { return m_Tree.erase(key); }
+
+		void swap(persistent_map& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Element access =================
+
+		const T& at(const Key& key) const
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("mstl::persistent_map::at: key not found");
+			return it->second;
+		}
+
+		// ================= Lookup =================
+
+		const_iterator find(const Key& key) const { return m_Tree.find(key); }
+
+		size_type count(const Key& key) const { return m_Tree.contains(key) ? 1 : 0; }
+		bool contains(const Key& key) const { return m_Tree.contains(key); }
+
+		const_iterator lower_bound(const Key& key) const { return m_Tree.lower_bound(key); }
+		const_iterator upper_bound(const Key& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const Key& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Heterogeneous lookup =================
+		// transparent Compare only, e.g. persistent_map<std::string, T, std::less<>>
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator find(const K& key) const { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		size_type count(const K& key) const { return m_Tree.contains(key) ? 1 : 0; }
+
+		template<class K> requires TransparentCompare<Compare>
+		bool contains(const K& key) const { return m_Tree.contains(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator lower_bound(const K& key) const { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator upper_bound(const K& key) const { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const { return m_Tree.equal_range(key); }
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.verify(); }
+
+		friend bool operator==(const persistent_map& a, const persistent_map& b) { return a.m_Tree == b.m_Tree; }
+		friend bool operator!=(const persistent_map& a, const persistent_map& b) { return !(a == b); }
+	};
+
+	template<typename K, typename T, typename C, typename A>
+	void swap(persistent_map<K, T, C, A>& a, persistent_map<K, T, C, A>& b) noexcept
+	{
+		a.swap(b);
+	}
+
+	template<typename K, typename T, typename C, typename A>
+	struct is_trivially_relocatable<persistent_map<K, T, C, A>>
+		: is_trivially_relocatable<persistent_rb_tree<std::pair<const K, T>, first_key<std::pair<const K, T>>, C, A>> {
+	};
+}
+
+#endif // ! MSTL_PERSISTENT_MAP_H
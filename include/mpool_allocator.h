@@ -0,0 +1,281 @@
+#ifndef MSTL_POOL_ALLOCATOR_H
+#define MSTL_POOL_ALLOCATOR_H
+
+#include <memory>
+#include <new>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// node_pool
+	/// ---------------------------------------------------------------
+	/// Slab-backed pool for blocks of a single size (a size class).
+	///
+	/// Memory is requested from the system in slabs holding many
+	/// blocks; freed blocks go back to an intrusive free list and are
+	/// reused before carving new ones out of the current slab.
+	/// Slabs are only given back to the system by release().
+	///
+	/// [!] not thread-safe, one pool is meant to serve one container
+	///     (or containers living on the same thread).
+
+	class node_pool {
+
+	public:
+
+		explicit node_pool(std::size_t block_size = sizeof(void*)) noexcept
+			: m_BlockSize{ block_size < sizeof(free_block) ? sizeof(free_block) : block_size } {
+		}
+
+		node_pool(const node_pool&) = delete;
+		node_pool& operator=(const node_pool&) = delete;
+
+		~node_pool() { release(); }
+
+		void* allocate()
+		{
+			// 1. reuse a freed block
+			if (mp_FreeList)
+			{
+				free_block* b = mp_FreeList;
+				mp_FreeList = b->mp_Next;
+				++m_InUse;
+				return b;
+			}
+
+			// 2. carve from the current slab, grab a new one if exhausted
+			if (mp_Cursor == mp_SlabEnd)
+			{
+				DoGrow();
+			}
+
+			void* p = mp_Cursor;
+			mp_Cursor += m_BlockSize;
+			++m_InUse;
+			return p;
+		}
+
+		void deallocate(void* p) noexcept
+		{
+			free_block* b = static_cast<free_block*>(p);
+			b->mp_Next = mp_FreeList;
+			mp_FreeList = b;
+			--m_InUse;
+		}
+
+		// Give every slab back to the system.
+		// All blocks handed out become invalid.
+		void release() noexcept
+		{
+			while (mp_Slabs)
+			{
+				slab* next = mp_Slabs->mp_Next;
+				::operator delete(static_cast<void*>(mp_Slabs));
+				mp_Slabs = next;
+			}
+
+			mp_FreeList = nullptr;
+			mp_Cursor = mp_SlabEnd = nullptr;
+			m_InUse = 0;
+			m_NextSlabBlocks = initial_slab_blocks;
+		}
+
+		std::size_t block_size() const noexcept { return m_BlockSize; }
+		std::size_t in_use() const noexcept { return m_InUse; }
+
+	private:
+
+		struct free_block { free_block* mp_Next; };
+
+		// slab header, blocks follow (header padded to max alignment)
+		struct alignas(std::max_align_t) slab { slab* mp_Next; };
+
+		static constexpr std::size_t initial_slab_blocks = 32;
+		static constexpr std::size_t max_slab_blocks     = 4096;
+
+		std::size_t  m_BlockSize{};
+		free_block*  mp_FreeList{};
+		slab*        mp_Slabs{};
+		std::byte*   mp_Cursor{};
+		std::byte*   mp_SlabEnd{};
+		std::size_t  m_InUse{};
+		std::size_t  m_NextSlabBlocks{ initial_slab_blocks };
+
+		// geometric slab growth: few system calls for big containers,
+		// small footprint for small ones
+		void DoGrow()
+		{
+			const std::size_t bytes = sizeof(slab) + m_NextSlabBlocks * m_BlockSize;
+
+			slab* s = static_cast<slab*>(::operator new(bytes));
+			s->mp_Next = mp_Slabs;
+			mp_Slabs = s;
+
+			mp_Cursor = reinterpret_cast<std::byte*>(s) + sizeof(slab);
+			mp_SlabEnd = mp_Cursor + m_NextSlabBlocks * m_BlockSize;
+
+			if (m_NextSlabBlocks < max_slab_blocks)
+				m_NextSlabBlocks *= 2;
+		}
+	};
+
+	/// ---------------------------------------------------------------
+	/// node_pool_resource
+	/// ---------------------------------------------------------------
+	/// One node_pool per size class. Sizes are rounded up to the
+	/// fundamental alignment, so every node type of a container
+	/// (and of rebound copies of its allocator) gets its own class.
+
+	class node_pool_resource {
+
+	public:
+
+		static constexpr std::size_t granularity     = alignof(std::max_align_t);
+		static constexpr std::size_t max_pooled_size = 512;
+		static constexpr std::size_t class_count     = max_pooled_size / granularity;
+
+		node_pool_resource() noexcept
+		{
+			for (std::size_t i = 0; i < class_count; ++i)
+				::new (static_cast<void*>(&pool(i))) node_pool((i + 1) * granularity);
+		}
+
+		node_pool_resource(const node_pool_resource&) = delete;
+		node_pool_resource& operator=(const node_pool_resource&) = delete;
+
+		~node_pool_resource()
+		{
+			for (std::size_t i = 0; i < class_count; ++i)
+				pool(i).~node_pool();
+		}
+
+		static constexpr bool is_pooled(std::size_t bytes, std::size_t align) noexcept {
+			return bytes <= max_pooled_size && align <= granularity;
+		}
+
+		node_pool& pool_for(std::size_t bytes) noexcept {
+			return pool(bytes == 0 ? 0 : (bytes - 1) / granularity);
+		}
+
+		const node_pool& pool_for(std::size_t bytes) const noexcept {
+			return const_cast<node_pool_resource*>(this)->pool_for(bytes);
+		}
+
+	private:
+
+		// raw storage: node_pool isn't default-constructible per size class
+		alignas(node_pool) std::byte m_Storage[class_count * sizeof(node_pool)];
+
+		node_pool& pool(std::size_t i) noexcept {
+			return *std::launder(reinterpret_cast<node_pool*>(m_Storage + i * sizeof(node_pool)));
+		}
+	};
+
+	/// ---------------------------------------------------------------
+	/// node_pool_allocator
+	/// ---------------------------------------------------------------
+	/// Allocator meant for node based containers (tree_base, list_rep,
+	/// map). Single-object requests are served by the shared
+	/// node_pool_resource, anything else (arrays, over-aligned or
+	/// huge types) falls back to std::allocator.
+	///
+	/// Copies and rebound copies share the same resource, so the
+	/// value allocator and the node allocator of a container compare
+	/// equal and can free each other's memory.
+	///
+	/// Every default constructed allocator makes a fresh resource (it
+	/// allocates and may throw, so the containers' noexcept paths copy
+	/// an existing allocator instead): two default constructed pooled
+	/// containers never compare equal.
+	/// Operations that relink nodes between trees (merge, join,
+	/// union_with, node handle insert) need equal allocators, so such
+	/// trees must be built from copies of one allocator.
+	///
+	/// Usage:
+	///   using alloc = mstl::node_pool_allocator<std::pair<const int, int>>;
+	///   mstl::map<int, int, std::less<int>, alloc> m;
+
+	template<typename T>
+	class node_pool_allocator {
+
+	public:
+
+		using value_type      = T;
+		using size_type       = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap            = std::true_type;
+		using is_always_equal                        = std::false_type;
+
+		node_pool_allocator()
+			: mp_Resource{ std::make_shared<node_pool_resource>() } {
+		}
+
+		template<typename U>
+		node_pool_allocator(const node_pool_allocator<U>& other) noexcept
+			: mp_Resource{ other.mp_Resource } {
+		}
+
+		T* allocate(size_type n)
+		{
+			if (n == 1 && pooled)
+			{
+				return static_cast<T*>(mp_Resource->pool_for(sizeof(T)).allocate());
+			}
+
+			return std::allocator<T>{}.allocate(n);
+		}
+
+		void deallocate(T* p, size_type n) noexcept
+		{
+			if (n == 1 && pooled)
+			{
+				mp_Resource->pool_for(sizeof(T)).deallocate(p);
+				return;
+			}
+
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		/// Bulk release support (used by the containers' DoClear).
+		///
+		/// A container holding n nodes may drop the whole size class
+		/// in one go, without freeing node by node, only if no one
+		/// else has blocks in it: that is exactly when in_use == n.
+
+		bool is_sole_owner(size_type n) const noexcept
+		{
+			return pooled && mp_Resource->pool_for(sizeof(T)).in_use() == n;
+		}
+
+		void release() noexcept
+		{
+			if constexpr (pooled)
+				mp_Resource->pool_for(sizeof(T)).release();
+		}
+
+		friend bool operator==(const node_pool_allocator& a, const node_pool_allocator& b) noexcept {
+			return a.mp_Resource == b.mp_Resource;
+		}
+
+		friend bool operator!=(const node_pool_allocator& a, const node_pool_allocator& b) noexcept {
+			return !(a == b);
+		}
+
+	private:
+
+		static constexpr bool pooled = node_pool_resource::is_pooled(sizeof(T), alignof(T));
+
+		std::shared_ptr<node_pool_resource> mp_Resource;
+
+		template<typename U>
+		friend class node_pool_allocator;
+	};
+}
+
+#endif // !MSTL_POOL_ALLOCATOR_H
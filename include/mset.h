@@ -8,8 +8,498 @@ namespace mstl {
 	/// ---------------------------------------------------------------
 	/// Set
 	/// ---------------------------------------------------------------
+	/// Unique keys on rb_tree. Iterators are constant: keys can't
+	/// change in place (extract the node, change value(), insert it).
+	///
+	/// Nothing allocates but the insertion of a new value: erase +
+	/// insert churn can go through extract/insert(node_type&&), and
+	/// merge relinks the nodes of the other set. A sorted range is
+	/// inserted without per element descents (see rb_tree).
+	///
+	/// NodeT selects the tree node layout: rb_os_node adds
+	/// order statistics (rank, select, O(log n) distance).
 
-	
+	template<
+		typename Key,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<Key>,
+		template<class> class NodeT = rb_node
+	>
+	class set {
+
+		using tree_type = rb_tree<
+			Key,
+			NodeT,
+			identity_key<Key>,
+			Compare,
+			Alloc
+		>;
+
+		tree_type m_Tree;
+
+		explicit set(tree_type&& t) noexcept : m_Tree(std::move(t)) {}
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using key_compare = Compare;
+		using value_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using iterator       = typename tree_type::const_iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		using reverse_iterator       = typename tree_type::const_reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
+		using node_type = typename tree_type::node_handle;
+
+		struct insert_return_type {
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		// ================= Constructors =================
+		set() = default;
+
+		explicit set(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		set(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+			m_Tree.insert_range_unique(first, last);
+		}
+
+		// [first, last) sorted, no duplicates: O(n) build
+		template<class InputIt>
+		set(sorted_unique_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_unique, first, last, alloc, comp) {
+		}
+
+		set(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: set(il.begin(), il.end(), comp, alloc) {
+		}
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& val) { return m_Tree.insert(val); }
+		std::pair<iterator, bool> insert(value_type&& val) { return m_Tree.insert(std::move(val)); }
+
+		iterator insert(const_iterator hint, const value_type& val) { return m_Tree.insert(hint, val); }
+		iterator insert(const_iterator hint, value_type&& val) { return m_Tree.insert(hint, std::move(val)); }
+
+		template<class InputIt>
+		void insert(InputIt first, InputIt last) { m_Tree.insert_range_unique(first, last); }
+
+		void insert(std::initializer_list<value_type> il) { m_Tree.insert_range_unique(il.begin(), il.end()); }
+
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			return m_Tree.emplace(std::forward<Args>(args)...);
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			return m_Tree.emplace_hint(hint, std::forward<Args>(args)...);
+		}
+
+		iterator erase(const_iterator pos) { return m_Tree.erase(pos); }
+		size_type erase(const key_type& key) { return m_Tree.erase(key); }
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) { return m_Tree.erase(key); }
+
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			while (first != last) first = m_Tree.erase(first);
+			return last;
+		}
+
+		void swap(set& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Node handles =================
+
+		node_type extract(const_iterator pos) noexcept { return m_Tree.extract(pos); }
+		node_type extract(const key_type& key) noexcept { return m_Tree.extract(key); }
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		node_type extract(const K& key) noexcept { return m_Tree.extract(key); }
+
+		insert_return_type insert(node_type&& nh) noexcept
+		{
+			auto r = m_Tree.insert(std::move(nh));
+			return { r.position, r.inserted, std::move(r.node) };
+		}
+
+		// ================= Set operations =================
+		// nodes are relinked, never copied: see rb_tree
+
+		// keys missing here move from other, the others stay there
+		void merge(set& other) noexcept { m_Tree.merge(other.m_Tree); }
+		void merge(set&& other) noexcept { m_Tree.merge(other.m_Tree); }
+
+		void union_with(set&& other) noexcept { m_Tree.union_with(std::move(other.m_Tree)); }
+		void intersection_with(const set& other) noexcept { m_Tree.intersection_with(other.m_Tree); }
+		void difference_with(const set& other) noexcept { m_Tree.difference_with(other.m_Tree); }
+
+		// keeps the keys < key, returns the keys >= key
+		set split(const key_type& key) { return set(m_Tree.split(key)); }
+
+		// every key of left < every key of right
+		static set join(set&& left, set&& right) noexcept
+		{
+			return set(tree_type::join(std::move(left.m_Tree), std::move(right.m_Tree)));
+		}
+
+		// ================= Lookup =================
+
+		const_iterator find(const key_type& key) const { return m_Tree.find(key); }
+
+		size_type count(const key_type& key) const { return m_Tree.contains(key) ? 1 : 0; }
+
+		bool contains(const key_type& key) const { return m_Tree.contains(key); }
+
+		const_iterator lower_bound(const key_type& key) const { return m_Tree.lower_bound(key); }
+		const_iterator upper_bound(const key_type& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+		{
+			return m_Tree.equal_range(key);
+		}
+
+		// ================= Heterogeneous lookup =================
+		// transparent Compare only, e.g. set<std::string, std::less<>>
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator find(const K& key) const { return m_Tree.find(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		size_type count(const K& key) const { return m_Tree.contains(key) ? 1 : 0; }
+
+		template<class K> requires TransparentCompare<Compare>
+		bool contains(const K& key) const { return m_Tree.contains(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator lower_bound(const K& key) const { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator upper_bound(const K& key) const { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const
+		{
+			return m_Tree.equal_range(key);
+		}
+
+		// ================= Order statistics =================
+		// only with NodeT = rb_os_node
+
+		size_type rank(const key_type& key) const requires tree_type::has_order_statistics {
+			return m_Tree.rank(key);
+		}
+
+		const_iterator select(size_type k) const requires tree_type::has_order_statistics {
+			return m_Tree.select(k);
+		}
+
+		size_type index_of(const_iterator it) const requires tree_type::has_order_statistics {
+			return m_Tree.index_of(it);
+		}
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+		value_compare value_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.IsRBTree(); }
+
+		friend bool operator==(const set& a, const set& b) { return a.m_Tree == b.m_Tree; }
+	};
+
+	/// ---------------------------------------------------------------
+	/// Multiset
+	/// ---------------------------------------------------------------
+	/// Same tree, equal keys allowed: a new key goes after the equal
+	/// ones already in (hinted: as close as possible before the hint).
+
+	template<
+		typename Key,
+		typename Compare = std::less<Key>,
+		typename Alloc = std::allocator<Key>,
+		template<class> class NodeT = rb_node
+	>
+	class multiset {
+
+		using tree_type = rb_tree<
+			Key,
+			NodeT,
+			identity_key<Key>,
+			Compare,
+			Alloc
+		>;
+
+		tree_type m_Tree;
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using key_compare = Compare;
+		using value_compare = Compare;
+		using allocator_type = Alloc;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using iterator       = typename tree_type::const_iterator;
+		using const_iterator = typename tree_type::const_iterator;
+
+		using reverse_iterator       = typename tree_type::const_reverse_iterator;
+		using const_reverse_iterator = typename tree_type::const_reverse_iterator;
+
+		using node_type = typename tree_type::node_handle;
+
+	private:
+
+		template<class K>
+		const_iterator find_first(const K& key) const
+		{
+			const_iterator it = m_Tree.lower_bound(key);
+			return it == end() || m_Tree.key_comp()(key, *it) ? end() : it;
+		}
+
+		size_type count_range(std::pair<const_iterator, const_iterator> r) const
+		{
+			if constexpr (tree_type::has_order_statistics)
+				return static_cast<size_type>(m_Tree.distance(r.first, r.second));
+			else
+				return static_cast<size_type>(std::distance(r.first, r.second));
+		}
+
+	public:
+
+		// ================= Constructors =================
+		multiset() = default;
+
+		explicit multiset(const key_compare& comp,
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+		}
+
+		template<class InputIt>
+		multiset(InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(alloc, comp) {
+			m_Tree.insert_range_equal(first, last);
+		}
+
+		// [first, last) sorted: O(n) build
+		template<class InputIt>
+		multiset(sorted_equivalent_t, InputIt first, InputIt last,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: m_Tree(sorted_equivalent, first, last, alloc, comp) {
+		}
+
+		multiset(std::initializer_list<value_type> il,
+			const key_compare& comp = key_compare{},
+			const allocator_type& alloc = allocator_type{})
+			: multiset(il.begin(), il.end(), comp, alloc) {
+		}
+
+		// ================= Iterators =================
+
+		const_iterator begin() const noexcept { return m_Tree.begin(); }
+		const_iterator cbegin() const noexcept { return m_Tree.begin(); }
+
+		const_iterator end() const noexcept { return m_Tree.end(); }
+		const_iterator cend() const noexcept { return m_Tree.end(); }
+
+		const_reverse_iterator rbegin() const noexcept { return m_Tree.rbegin(); }
+		const_reverse_iterator crbegin() const noexcept { return m_Tree.rbegin(); }
+
+		const_reverse_iterator rend() const noexcept { return m_Tree.rend(); }
+		const_reverse_iterator crend() const noexcept { return m_Tree.rend(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Tree.empty(); }
+		size_type size() const noexcept { return m_Tree.size(); }
+
+		// ================= Modifiers =================
+
+		void clear() noexcept { m_Tree.clear(); }
+
+		iterator insert(const value_type& val) { return m_Tree.insert_equal(val); }
+		iterator insert(value_type&& val) { return m_Tree.insert_equal(std::move(val)); }
+
+		iterator insert(const_iterator hint, const value_type& val) { return m_Tree.insert_equal(hint, val); }
+		iterator insert(const_iterator hint, value_type&& val) { return m_Tree.insert_equal(hint, std::move(val)); }
+
+		template<class InputIt>
+		void insert(InputIt first, InputIt last) { m_Tree.insert_range_equal(first, last); }
+
+		void insert(std::initializer_list<value_type> il) { m_Tree.insert_range_equal(il.begin(), il.end()); }
+
+		template<class... Args>
+		iterator emplace(Args&&... args)
+		{
+			return m_Tree.emplace_equal(std::forward<Args>(args)...);
+		}
+
+		template<class... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args)
+		{
+			return m_Tree.emplace_hint_equal(hint, std::forward<Args>(args)...);
+		}
+
+		iterator erase(const_iterator pos) { return m_Tree.erase(pos); }
+
+		// every element with key
+		size_type erase(const key_type& key) { return m_Tree.erase_equal(key); }
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		size_type erase(const K& key) { return m_Tree.erase_equal(key); }
+
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			while (first != last) first = m_Tree.erase(first);
+			return last;
+		}
+
+		void swap(multiset& other) noexcept { m_Tree.swap(other.m_Tree); }
+
+		// ================= Node handles =================
+
+		node_type extract(const_iterator pos) noexcept { return m_Tree.extract(pos); }
+
+		// the first element with key
+		node_type extract(const key_type& key) noexcept
+		{
+			const_iterator it = find(key);
+			return it == end() ? node_type{} : m_Tree.extract(it);
+		}
+
+		template<class K> requires tree_type::template is_heterogeneous_key<K>
+		node_type extract(const K& key) noexcept
+		{
+			const_iterator it = find(key);
+			return it == end() ? node_type{} : m_Tree.extract(it);
+		}
+
+		iterator insert(node_type&& nh) noexcept { return m_Tree.insert_equal(std::move(nh)); }
+
+		// every node of other moves here, relinked
+		void merge(multiset& other) noexcept { m_Tree.merge_equal(other.m_Tree); }
+		void merge(multiset&& other) noexcept { m_Tree.merge_equal(other.m_Tree); }
+
+		// ================= Lookup =================
+
+		// the first element with key
+		const_iterator find(const key_type& key) const { return find_first(key); }
+
+		size_type count(const key_type& key) const { return count_range(m_Tree.equal_range(key)); }
+
+		bool contains(const key_type& key) const { return m_Tree.contains(key); }
+
+		const_iterator lower_bound(const key_type& key) const { return m_Tree.lower_bound(key); }
+		const_iterator upper_bound(const key_type& key) const { return m_Tree.upper_bound(key); }
+
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+		{
+			return m_Tree.equal_range(key);
+		}
+
+		// ================= Heterogeneous lookup =================
+		// transparent Compare only, e.g. multiset<std::string, std::less<>>
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator find(const K& key) const { return find_first(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		size_type count(const K& key) const { return count_range(m_Tree.equal_range(key)); }
+
+		template<class K> requires TransparentCompare<Compare>
+		bool contains(const K& key) const { return m_Tree.contains(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator lower_bound(const K& key) const { return m_Tree.lower_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		const_iterator upper_bound(const K& key) const { return m_Tree.upper_bound(key); }
+
+		template<class K> requires TransparentCompare<Compare>
+		std::pair<const_iterator, const_iterator> equal_range(const K& key) const
+		{
+			return m_Tree.equal_range(key);
+		}
+
+		// ================= Order statistics =================
+		// only with NodeT = rb_os_node
+
+		size_type rank(const key_type& key) const requires tree_type::has_order_statistics {
+			return m_Tree.rank(key);
+		}
+
+		const_iterator select(size_type k) const requires tree_type::has_order_statistics {
+			return m_Tree.select(k);
+		}
+
+		size_type index_of(const_iterator it) const requires tree_type::has_order_statistics {
+			return m_Tree.index_of(it);
+		}
+
+		// ================= Observers =================
+
+		key_compare key_comp() const { return m_Tree.key_comp(); }
+		value_compare value_comp() const { return m_Tree.key_comp(); }
+
+		allocator_type get_allocator() const { return m_Tree.get_allocator(); }
+
+		// ================= Debug =================
+
+		bool verify() const noexcept { return m_Tree.IsRBTree(); }
+
+		friend bool operator==(const multiset& a, const multiset& b) { return a.m_Tree == b.m_Tree; }
+	};
 }
 
-#endif // ! MSTL_SET_H
\ No newline at end of file
+#endif // ! MSTL_SET_H
@@ -0,0 +1,562 @@
+#ifndef MSTL_SMALL_VECTOR_H
+#define MSTL_SMALL_VECTOR_H
+
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <limits>
+#include <stdexcept>
+#include <cstring>
+#include <initializer_list>
+#include "mvector.h"
+#include "internals/relocate.h"
+#include "internals/trace.h"
+
+namespace mstl {
+
+	///
+	/// small_vector
+	///
+	/// A vector that keeps up to N elements in a buffer inside the
+	/// object and allocates only when it outgrows it. Same interface
+	/// and growth policy as mstl::vector (NextCapacity), same
+	/// relocation helpers (relocate.h): spilling to the heap, or
+	/// growing there, is one memcpy for trivially relocatable types.
+	///
+	/// Once on the heap it stays there (like std::vector, capacity
+	/// never shrinks), clear() keeps the buffer.
+	///
+	/// [!] moving a small_vector whose elements are inline moves the
+	///     elements, not a pointer: iterators into the source are not
+	///     carried over, unlike mstl::vector.
+
+	template<typename T, std::size_t N, typename A = std::allocator<T>>
+		requires Element<T>
+	class small_vector {
+
+		static_assert(N > 0, "small_vector needs at least one inline element, use mstl::vector");
+
+	public:
+		using allocator_type = A;
+		using alloc_traits = std::allocator_traits<A>;
+		using size_type = typename alloc_traits::size_type;
+		using value_type = T;
+		using iterator = T*;
+		using const_iterator = const T*;
+		using trace = trace_hook_t<small_vector>;    // null_trace unless MSTL_TRACE
+
+		static constexpr size_type inline_capacity = N;
+
+	private:
+		static constexpr size_type reasonable_size = std::numeric_limits<size_type>::max() / sizeof(T);
+
+		[[no_unique_address]] A m_Alloc{};
+		T* mp_Elem{};
+		size_type m_Size{};
+		size_type m_Space{ N };
+		alignas(T) unsigned char m_Inline[N * sizeof(T)];
+
+	public:
+		small_vector() : mp_Elem{ InlineData() } {}
+
+		explicit small_vector(const A& i_alloc) : m_Alloc{ i_alloc }, mp_Elem{ InlineData() } {}
+
+		explicit small_vector(size_type i_size, value_type def = value_type{})
+			: mp_Elem{ InlineData() }
+		{
+			if (!(i_size < reasonable_size))
+				throw std::length_error{ "Wrong size for small_vector" };
+
+			resize(i_size, def);
+		}
+
+		small_vector(std::initializer_list<T> i_lst)
+			: mp_Elem{ InlineData() }
+		{
+			append_range(i_lst);
+		}
+
+		// copy constructor: inline when it fits, else one exact allocation
+		small_vector(const small_vector& i_v)
+			: m_Alloc{ alloc_traits::select_on_container_copy_construction(i_v.m_Alloc) }
+			, mp_Elem{ InlineData() }
+		{
+			if (i_v.size() > N)
+			{
+				mp_Elem = DoAllocate(i_v.size());
+				m_Space = i_v.size();
+			}
+
+			try {
+				UninitializedCopyN(m_Alloc, i_v.mp_Elem, i_v.size(), mp_Elem);
+			}
+			catch (...)
+			{
+				DoRelease();
+				throw;
+			}
+
+			m_Size = i_v.size();
+		}
+
+		// move constructor: steals a heap buffer, relocates inline elements
+		small_vector(small_vector&& i_v) noexcept(std::is_nothrow_move_constructible_v<T>)
+			: m_Alloc{ std::move(i_v.m_Alloc) }
+			, mp_Elem{ InlineData() }
+		{
+			DoSteal(i_v);
+		}
+
+		small_vector& operator=(const small_vector& i_v)
+		{
+			if (this == &i_v)
+				return *this;
+
+			// a propagated allocator that can't free our buffer: give
+			// it back first, then take the new allocator
+			if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+			{
+				if (!alloc_traits::is_always_equal::value && m_Alloc != i_v.m_Alloc)
+				{
+					clear();
+					DoRelease();
+					mp_Elem = InlineData();
+					m_Space = N;
+				}
+
+				m_Alloc = i_v.m_Alloc;
+			}
+
+			reserve(i_v.size());
+
+			// assign the common prefix, build or destroy the rest
+			const size_type common = std::min(size(), i_v.size());
+			std::copy(i_v.begin(), i_v.begin() + common, begin());
+
+			if (i_v.size() > size())
+				UninitializedCopyN(m_Alloc, i_v.mp_Elem + common, i_v.size() - common, mp_Elem + common);
+			else
+				DestroyN(m_Alloc, mp_Elem + common, size() - common);
+
+			m_Size = i_v.size();
+			return *this;
+		}
+
+		// the heap buffer is stolen only with an allocator that can free
+		// it: propagated, or equal; else the elements are moved one by
+		// one into our own storage (as unrolled_list)
+		small_vector& operator=(small_vector&& i_v) noexcept(std::is_nothrow_move_constructible_v<T>
+			&& (alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value))
+		{
+			if (this == &i_v)
+				return *this;
+
+			clear();
+
+			if constexpr (!alloc_traits::propagate_on_container_move_assignment::value && !alloc_traits::is_always_equal::value)
+			{
+				if (m_Alloc != i_v.m_Alloc)
+				{
+					reserve(i_v.size());
+					UninitializedMoveIfNoexceptN(m_Alloc, i_v.mp_Elem, i_v.m_Size, mp_Elem);
+					m_Size = i_v.m_Size;
+					i_v.clear();
+					return *this;
+				}
+			}
+
+			DoRelease();
+			mp_Elem = InlineData();
+			m_Space = N;
+
+			if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+				m_Alloc = std::move(i_v.m_Alloc);
+
+			DoSteal(i_v);
+			return *this;
+		}
+
+		~small_vector()
+		{
+			DestroyN(m_Alloc, mp_Elem, m_Size);
+			DoRelease();
+		}
+
+		// checked accesses
+		T& at(size_type n)
+		{
+			if (size() <= n)
+				throw std::out_of_range{ "mstl::small_vector::at: index out of range" };
+
+			return mp_Elem[n];
+		}
+		const T& at(size_type n) const
+		{
+			if (size() <= n)
+				throw std::out_of_range{ "mstl::small_vector::at: index out of range" };
+
+			return mp_Elem[n];
+		}
+
+		// unchecked access
+		value_type& operator[](size_type n) { return mp_Elem[n]; }
+		const value_type& operator[](size_type n) const { return mp_Elem[n]; }
+
+		size_type size() const { return m_Size; }
+		size_type capacity() const { return m_Space; }
+		bool empty() const { return m_Size == 0; }
+
+		// true while no heap memory is in use
+		bool is_inline() const { return mp_Elem == InlineData(); }
+
+		// growth: reserve, resize, push_back
+		void reserve(size_type newAlloc)
+		{
+			if (newAlloc <= capacity())
+				return;
+
+			T* b = DoAllocate(newAlloc);
+
+			try {
+				RelocateN(m_Alloc, mp_Elem, m_Size, b);
+			}
+			catch (...)
+			{
+				DoDeallocate(b, newAlloc);
+				throw;
+			}
+
+			DoAdopt(b, newAlloc);
+		}
+
+		void resize(size_type newSize, value_type def = value_type{})
+		{
+			reserve(newSize);
+
+			if (size() < newSize)
+			{
+				for (size_type i = size(); i < newSize; ++i)
+					alloc_traits::construct(m_Alloc, mp_Elem + i, def);
+			}
+			else
+			{
+				DestroyN(m_Alloc, mp_Elem + newSize, size() - newSize);
+			}
+
+			m_Size = newSize;
+		}
+
+		void clear() noexcept
+		{
+			DestroyN(m_Alloc, mp_Elem, m_Size);
+			m_Size = 0;
+		}
+
+		void push_back(const value_type& newElem)
+		{
+			emplace_back(newElem);
+		}
+
+		void push_back(value_type&& newElem)
+		{
+			emplace_back(std::move(newElem));
+		}
+
+		void pop_back()
+		{
+			alloc_traits::destroy(m_Alloc, mp_Elem + m_Size - 1);
+			--m_Size;
+		}
+
+		template<class... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (size() == capacity())
+				return realloc_emplace_back(std::forward<Args>(args)...);
+
+			alloc_traits::construct(m_Alloc, mp_Elem + m_Size, std::forward<Args>(args)...);
+			++m_Size;
+			return mp_Elem[m_Size - 1];
+		}
+
+		// appends a whole range: one reservation when its size is known
+		template<std::ranges::input_range R>
+		void append_range(R&& rg)
+		{
+			if constexpr (std::ranges::forward_range<R> || std::ranges::sized_range<R>)
+			{
+				const size_type n = static_cast<size_type>(std::ranges::distance(rg));
+
+				if (size() + n > capacity())
+					reserve(NextCapacity<size_type>(size(), capacity(), n, reasonable_size, N));
+
+				for (auto&& v : rg)
+				{
+					alloc_traits::construct(m_Alloc, mp_Elem + m_Size, std::forward<decltype(v)>(v));
+					++m_Size;
+				}
+			}
+			else
+			{
+				for (auto&& v : rg)
+					emplace_back(std::forward<decltype(v)>(v));
+			}
+		}
+
+		iterator insert(iterator p, const value_type& val)
+		{
+			return emplace(p, val);
+		}
+
+		iterator insert(iterator p, value_type&& val)
+		{
+			return emplace(p, std::move(val));
+		}
+
+		template<class... Args>
+		iterator emplace(iterator p, Args&&... args)
+		{
+			const size_type index = p - begin();
+
+			if (p == end())
+			{
+				emplace_back(std::forward<Args>(args)...);
+				return begin() + index;
+			}
+
+			// args may refer to elements of this vector
+			value_type tmp(std::forward<Args>(args)...);
+
+			return insert_n(index, 1, [&](T* dst) {
+				alloc_traits::construct(m_Alloc, dst, std::move(tmp));
+			});
+		}
+
+		iterator insert(iterator p, size_type n, const value_type& val)
+		{
+			const size_type index = p - begin();
+			if (n == 0) return p;
+
+			value_type copy(val);
+
+			return insert_n(index, n, [&](T* dst) {
+				size_type i = 0;
+
+				try {
+					for (; i < n; ++i)
+						alloc_traits::construct(m_Alloc, dst + i, copy);
+				}
+				catch (...)
+				{
+					DestroyN(m_Alloc, dst, i);
+					throw;
+				}
+			});
+		}
+
+		template<std::input_iterator It>
+		iterator insert(iterator p, It first, It last)
+		{
+			const size_type index = p - begin();
+
+			if constexpr (std::forward_iterator<It>)
+			{
+				const size_type n = static_cast<size_type>(std::distance(first, last));
+				if (n == 0) return p;
+
+				return insert_n(index, n, [&](T* dst) {
+					size_type i = 0;
+
+					try {
+						for (It it = first; i < n; ++i, ++it)
+							alloc_traits::construct(m_Alloc, dst + i, *it);
+					}
+					catch (...)
+					{
+						DestroyN(m_Alloc, dst, i);
+						throw;
+					}
+				});
+			}
+			else
+			{
+				// single pass: append, then rotate the new tail into place
+				const size_type old_size = size();
+
+				try {
+					for (; first != last; ++first)
+						emplace_back(*first);
+				}
+				catch (...)
+				{
+					DestroyN(m_Alloc, mp_Elem + old_size, size() - old_size);
+					m_Size = old_size;
+					throw;
+				}
+
+				std::rotate(begin() + index, begin() + old_size, end());
+				return begin() + index;
+			}
+		}
+
+		iterator erase(iterator p)
+		{
+			if (p == end())
+				return p;
+
+			if constexpr (relocate_by_memcpy<A>)
+			{
+				alloc_traits::destroy(m_Alloc, p);
+				std::memmove(static_cast<void*>(p), static_cast<const void*>(p + 1), (end() - p - 1) * sizeof(T));
+			}
+			else
+			{
+				std::move(p + 1, end(), p);
+				alloc_traits::destroy(m_Alloc, end() - 1);
+			}
+
+			--m_Size;
+			return p;
+		}
+
+		// iterator support
+		iterator begin() { return mp_Elem; }
+		const_iterator begin() const { return mp_Elem; }
+		iterator end() { return mp_Elem + m_Size; }
+		const_iterator end() const { return mp_Elem + m_Size; }
+
+		T* data() { return mp_Elem; }
+		const T* data() const { return mp_Elem; }
+
+		allocator_type get_allocator() const { return m_Alloc; }
+
+	private:
+
+		// ================= Buffer =================
+
+		T* InlineData() noexcept { return reinterpret_cast<T*>(m_Inline); }
+		const T* InlineData() const noexcept { return reinterpret_cast<const T*>(m_Inline); }
+
+		T* DoAllocate(size_type n)
+		{
+			T* p = alloc_traits::allocate(m_Alloc, n);
+			trace::on_allocate(n * sizeof(T));
+			return p;
+		}
+
+		void DoDeallocate(T* p, size_type n) noexcept
+		{
+			alloc_traits::deallocate(m_Alloc, p, n);
+			trace::on_deallocate(n * sizeof(T));
+		}
+
+		// frees the heap buffer, if any (elements already gone)
+		void DoRelease() noexcept
+		{
+			if (!is_inline())
+				DoDeallocate(mp_Elem, m_Space);
+		}
+
+		// switches to b, whose first m_Size elements were relocated in
+		void DoAdopt(T* b, size_type space) noexcept
+		{
+			trace::on_grow(m_Size * sizeof(T));
+
+			DoRelease();
+			mp_Elem = b;
+			m_Space = space;
+		}
+
+		// *this is empty and inline
+		void DoSteal(small_vector& i_v)
+		{
+			if (!i_v.is_inline())
+			{
+				mp_Elem = i_v.mp_Elem;
+				m_Space = i_v.m_Space;
+				m_Size = i_v.m_Size;
+			}
+			else
+			{
+				RelocateN(m_Alloc, i_v.mp_Elem, i_v.m_Size, mp_Elem);
+				m_Size = i_v.m_Size;
+			}
+
+			i_v.mp_Elem = i_v.InlineData();
+			i_v.m_Space = N;
+			i_v.m_Size = 0;
+		}
+
+		// ================= Growth =================
+		// same scheme and helpers as mstl::vector (relocate.h): new
+		// elements are built in the new buffer before the old ones are
+		// relocated (they may be sources)
+
+		template<class... Args>
+		T& realloc_emplace_back(Args&&... args)
+		{
+			grow_around_gap(m_Size, 1, [&](T* dst) {
+				alloc_traits::construct(m_Alloc, dst, std::forward<Args>(args)...);
+			});
+
+			return mp_Elem[m_Size - 1];
+		}
+
+		// opens a gap of n elements at index, fill(dst) builds all or none
+		template<class Fill>
+		iterator insert_n(size_type index, size_type n, Fill&& fill)
+		{
+			if (size() + n > capacity())
+				grow_around_gap(index, n, fill);
+			else
+				InsertGapInPlace(m_Alloc, mp_Elem, m_Size, index, n, fill);
+
+			return begin() + index;
+		}
+
+		// moves to a heap buffer with room for n more, built at index
+		template<class Fill>
+		void grow_around_gap(size_type index, size_type n, Fill&& fill)
+		{
+			const size_type newAlloc = NextCapacity<size_type>(size(), capacity(), n, reasonable_size, N);
+			T* b = DoAllocate(newAlloc);
+
+			try {
+				RelocateAroundGap(m_Alloc, mp_Elem, m_Size, index, n, b, fill);
+			}
+			catch (...)
+			{
+				DoDeallocate(b, newAlloc);
+				throw;
+			}
+
+			DoAdopt(b, newAlloc);
+			m_Size += n;
+		}
+	};
+
+	template<typename T, std::size_t N, typename A>
+	bool operator==(const small_vector<T, N, A>& a, const small_vector<T, N, A>& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template<typename T, std::size_t N, typename A>
+	bool operator!=(const small_vector<T, N, A>& a, const small_vector<T, N, A>& b)
+	{
+		return !(a == b);
+	}
+
+	// inline buffers can't be exchanged, so it goes through three moves
+	template<typename T, std::size_t N, typename A>
+	void swap(small_vector<T, N, A>& a, small_vector<T, N, A>& b)
+		noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		small_vector<T, N, A> tmp(std::move(a));
+		a = std::move(b);
+		b = std::move(tmp);
+	}
+}
+
+#endif // !MSTL_SMALL_VECTOR_H
@@ -0,0 +1,689 @@
+#ifndef MSTL_UNORDERED_MAP_H
+#define MSTL_UNORDERED_MAP_H
+
+#include <memory>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <initializer_list>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <bit>
+
+// SSE2 is baseline on x64 (MSVC doesn't define __SSE2__ there)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MSTL_SWISS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace mstl {
+
+	/// ---------------------------------------------------------------
+	/// Swiss table control bytes
+	/// ---------------------------------------------------------------
+	/// One control byte per slot:
+	///   0xxxxxxx  full, low 7 bits of the hash (h2)
+	///   10000000  empty
+	///   11111110  deleted (tombstone)
+	///   11111111  sentinel, right after the last slot (stops iterators)
+	///
+	/// Slots are grouped by 16: a lookup loads the 16 control bytes of
+	/// a group at once and compares them against h2 in parallel, so
+	/// most probes touch one group and at most one slot per miss.
+
+	using swiss_ctrl = std::int8_t;
+
+	inline constexpr swiss_ctrl swiss_empty    = static_cast<swiss_ctrl>(-128); // 0x80
+	inline constexpr swiss_ctrl swiss_deleted  = static_cast<swiss_ctrl>(-2);   // 0xFE
+	inline constexpr swiss_ctrl swiss_sentinel = static_cast<swiss_ctrl>(-1);   // 0xFF
+
+	inline constexpr std::size_t swiss_group_width = 16;
+
+	inline constexpr bool swiss_is_full(swiss_ctrl c) noexcept { return c >= 0; }
+
+	/// ---------------------------------------------------------------
+	/// swiss_group
+	/// ---------------------------------------------------------------
+	/// 16 control bytes viewed as a unit. Every match returns a
+	/// bitmask with bit i set when slot i of the group matches.
+
+	struct swiss_group {
+
+#ifdef MSTL_SWISS_SSE2
+
+		__m128i m_Ctrl;
+
+		explicit swiss_group(const swiss_ctrl* p) noexcept
+			: m_Ctrl{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) } {
+		}
+
+		std::uint32_t match(swiss_ctrl h2) const noexcept {
+			return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_Ctrl)));
+		}
+
+		std::uint32_t match_empty() const noexcept {
+			return match(swiss_empty);
+		}
+
+		// empty and deleted are the only bytes with the high bit
+		// set inside a group (the sentinel is never part of one)
+		std::uint32_t match_empty_or_deleted() const noexcept {
+			return static_cast<std::uint32_t>(_mm_movemask_epi8(m_Ctrl));
+		}
+
+#else
+
+		// scalar fallback: same interface, one byte at a time
+		swiss_ctrl m_Ctrl[swiss_group_width];
+
+		explicit swiss_group(const swiss_ctrl* p) noexcept {
+			std::memcpy(m_Ctrl, p, swiss_group_width);
+		}
+
+		std::uint32_t match(swiss_ctrl h2) const noexcept {
+			std::uint32_t mask = 0;
+			for (std::size_t i = 0; i < swiss_group_width; ++i)
+				mask |= static_cast<std::uint32_t>(m_Ctrl[i] == h2) << i;
+			return mask;
+		}
+
+		std::uint32_t match_empty() const noexcept {
+			return match(swiss_empty);
+		}
+
+		std::uint32_t match_empty_or_deleted() const noexcept {
+			std::uint32_t mask = 0;
+			for (std::size_t i = 0; i < swiss_group_width; ++i)
+				mask |= static_cast<std::uint32_t>(m_Ctrl[i] < 0) << i;
+			return mask;
+		}
+
+#endif
+	};
+
+	/// ---------------------------------------------------------------
+	/// swiss_iterator
+	/// ---------------------------------------------------------------
+	/// Forward iterator over full slots: skips empty/deleted control
+	/// bytes and stops on the sentinel.
+
+	template<typename V, bool IsConst>
+	class swiss_iterator {
+
+		const swiss_ctrl* mp_Ctrl{};
+		V* mp_Slot{};
+
+	public:
+
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = V;
+		using difference_type   = std::ptrdiff_t;
+		using reference         = std::conditional_t<IsConst, const V&, V&>;
+		using pointer           = std::conditional_t<IsConst, const V*, V*>;
+
+		swiss_iterator() = default;
+
+		swiss_iterator(const swiss_ctrl* ctrl, V* slot) noexcept
+			: mp_Ctrl{ ctrl }, mp_Slot{ slot } {
+			skip_free();
+		}
+
+		template<bool C = IsConst, typename = std::enable_if_t<C>>
+		swiss_iterator(const swiss_iterator<V, false>& other) noexcept
+			: mp_Ctrl{ other.mp_Ctrl }, mp_Slot{ other.mp_Slot } {
+		}
+
+		reference operator*() const noexcept { return *mp_Slot; }
+		pointer operator->() const noexcept { return mp_Slot; }
+
+		swiss_iterator& operator++() noexcept {
+			++mp_Ctrl;
+			++mp_Slot;
+			skip_free();
+			return *this;
+		}
+
+		swiss_iterator operator++(int) noexcept {
+			swiss_iterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		friend bool operator==(const swiss_iterator& a, const swiss_iterator& b) noexcept { return a.mp_Ctrl == b.mp_Ctrl; }
+		friend bool operator!=(const swiss_iterator& a, const swiss_iterator& b) noexcept { return !(a == b); }
+
+	private:
+
+		void skip_free() noexcept {
+			if (!mp_Ctrl) return;
+			while (!swiss_is_full(*mp_Ctrl) && *mp_Ctrl != swiss_sentinel)
+			{
+				++mp_Ctrl;
+				++mp_Slot;
+			}
+		}
+
+		template<typename K, typename M, typename H, typename E, typename A>
+		friend class unordered_map;
+
+		template<typename, bool>
+		friend class swiss_iterator;
+	};
+
+	/// ---------------------------------------------------------------
+	/// Unordered Map
+	/// ---------------------------------------------------------------
+	/// Open addressing hash map (Swiss table layout):
+	/// - capacity is a power of two, multiple of the group width
+	/// - probing walks whole groups with a triangular sequence,
+	///   which visits every group once for power of two counts
+	/// - max load factor 7/8, tombstones are reclaimed on rehash
+	///
+	/// Values live directly in the slot array: unlike std::unordered_map
+	/// references and iterators are invalidated by rehashing.
+
+	template<
+		typename Key,
+		typename T,
+		typename Hash = std::hash<Key>,
+		typename KeyEqual = std::equal_to<Key>,
+		typename Alloc = std::allocator<std::pair<const Key, T>>
+	>
+	class unordered_map {
+
+	public:
+
+		using key_type        = Key;
+		using mapped_type     = T;
+		using value_type      = std::pair<const Key, T>;
+		using hasher          = Hash;
+		using key_equal       = KeyEqual;
+		using allocator_type  = Alloc;
+		using size_type       = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using iterator       = swiss_iterator<value_type, false>;
+		using const_iterator = swiss_iterator<value_type, true>;
+
+	private:
+
+		using alloc_traits = std::allocator_traits<Alloc>;
+		using ctrl_alloc   = typename alloc_traits::template rebind_alloc<swiss_ctrl>;
+		using ctrl_traits  = std::allocator_traits<ctrl_alloc>;
+
+		[[no_unique_address]] Alloc      m_Alloc{};
+		[[no_unique_address]] ctrl_alloc m_CtrlAlloc{ m_Alloc };
+		[[no_unique_address]] Hash       m_Hash{};
+		[[no_unique_address]] KeyEqual   m_Eq{};
+
+		swiss_ctrl*  mp_Ctrl{};      // capacity + group width bytes
+		value_type*  mp_Slots{};
+		size_type    m_Capacity{};
+		size_type    m_Size{};
+		size_type    m_Deleted{};
+
+	public:
+
+		// ================= Ctors =================
+
+		unordered_map() = default;
+
+		explicit unordered_map(size_type bucket_count,
+			const Hash& hash = Hash{},
+			const KeyEqual& eq = KeyEqual{},
+			const Alloc& alloc = Alloc{})
+			: m_Alloc{ alloc }, m_CtrlAlloc{ m_Alloc }, m_Hash{ hash }, m_Eq{ eq }
+		{
+			reserve(bucket_count);
+		}
+
+		template<std::input_iterator It>
+		unordered_map(It first, It last, size_type bucket_count = 0,
+			const Hash& hash = Hash{},
+			const KeyEqual& eq = KeyEqual{},
+			const Alloc& alloc = Alloc{})
+			: unordered_map(bucket_count, hash, eq, alloc)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		unordered_map(std::initializer_list<value_type> il, size_type bucket_count = 0,
+			const Hash& hash = Hash{},
+			const KeyEqual& eq = KeyEqual{},
+			const Alloc& alloc = Alloc{})
+			: unordered_map(il.begin(), il.end(), bucket_count, hash, eq, alloc) {
+		}
+
+		// ============= Copy semantics =================
+
+		// delegates to the empty shell: the object is complete before
+		// the first copy, so if one throws the destructor frees the
+		// table and the elements built so far
+		unordered_map(const unordered_map& other)
+			: unordered_map(alloc_traits::select_on_container_copy_construction(other.m_Alloc), other.m_Hash, other.m_Eq)
+		{
+			reserve(other.m_Size);
+			for (const auto& v : other)
+				insert_unique_no_grow(v);
+		}
+
+		unordered_map& operator=(const unordered_map& other)
+		{
+			if (this == &other) return *this;
+			unordered_map tmp(other);
+			swap(tmp);
+			return *this;
+		}
+
+		// ============= Move semantics =================
+
+		unordered_map(unordered_map&& other) noexcept
+			: m_Alloc{ std::move(other.m_Alloc) }
+			, m_CtrlAlloc{ m_Alloc }
+			, m_Hash{ std::move(other.m_Hash) }
+			, m_Eq{ std::move(other.m_Eq) }
+		{
+			steal(other);
+		}
+
+		unordered_map& operator=(unordered_map&& other) noexcept
+		{
+			if (this != &other) swap(other);
+			return *this;
+		}
+
+		~unordered_map() { destroy_all(); }
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return m_Capacity ? iterator{ mp_Ctrl, mp_Slots } : iterator{}; }
+		const_iterator begin() const noexcept { return m_Capacity ? const_iterator{ mp_Ctrl, mp_Slots } : const_iterator{}; }
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		iterator end() noexcept { return m_Capacity ? iterator{ mp_Ctrl + m_Capacity, mp_Slots + m_Capacity } : iterator{}; }
+		const_iterator end() const noexcept { return m_Capacity ? const_iterator{ mp_Ctrl + m_Capacity, mp_Slots + m_Capacity } : const_iterator{}; }
+		const_iterator cend() const noexcept { return end(); }
+
+		// ================= Capacity =================
+
+		bool empty() const noexcept { return m_Size == 0; }
+		size_type size() const noexcept { return m_Size; }
+		size_type bucket_count() const noexcept { return m_Capacity; }
+
+		float load_factor() const noexcept {
+			return m_Capacity ? static_cast<float>(m_Size) / static_cast<float>(m_Capacity) : 0.0f;
+		}
+
+		static constexpr float max_load_factor() noexcept { return 7.0f / 8.0f; }
+
+		// room for n elements without rehashing
+		void reserve(size_type n)
+		{
+			size_type cap = swiss_group_width;
+			while (max_load(cap) < n) cap *= 2;
+			if (cap > m_Capacity) rehash_to(cap);
+		}
+
+		void rehash(size_type n)
+		{
+			reserve(n > m_Size ? n : m_Size);
+		}
+
+		// ================= Modifiers =================
+
+		void clear() noexcept
+		{
+			if (!m_Capacity) return;
+
+			for (size_type i = 0; i < m_Capacity; ++i)
+			{
+				if (swiss_is_full(mp_Ctrl[i]))
+					alloc_traits::destroy(m_Alloc, mp_Slots + i);
+			}
+
+			reset_ctrl();
+			m_Size = 0;
+			m_Deleted = 0;
+		}
+
+		std::pair<iterator, bool> insert(const value_type& v)
+		{
+			return emplace_key(v.first, v);
+		}
+
+		std::pair<iterator, bool> insert(value_type&& v)
+		{
+			return emplace_key(v.first, std::move(v));
+		}
+
+		template<std::input_iterator It>
+		void insert(It first, It last)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		// the key is needed before the value can be placed:
+		// build the pair once, then move it into its slot
+		template<class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args)
+		{
+			value_type tmp(std::forward<Args>(args)...);
+			return emplace_key(tmp.first, std::move(tmp));
+		}
+
+		size_type erase(const key_type& key)
+		{
+			const size_type i = find_index(key);
+			if (i == npos) return 0;
+			erase_at(i);
+			return 1;
+		}
+
+		iterator erase(const_iterator pos)
+		{
+			const size_type i = static_cast<size_type>(pos.mp_Ctrl - mp_Ctrl);
+			erase_at(i);
+			return iterator{ mp_Ctrl + i + 1, mp_Slots + i + 1 };
+		}
+
+		void swap(unordered_map& other) noexcept
+		{
+			using std::swap;
+			swap(m_Alloc, other.m_Alloc);
+			swap(m_CtrlAlloc, other.m_CtrlAlloc);
+			swap(m_Hash, other.m_Hash);
+			swap(m_Eq, other.m_Eq);
+			swap(mp_Ctrl, other.mp_Ctrl);
+			swap(mp_Slots, other.mp_Slots);
+			swap(m_Capacity, other.m_Capacity);
+			swap(m_Size, other.m_Size);
+			swap(m_Deleted, other.m_Deleted);
+		}
+
+		// ================= Element access =================
+
+		// lookup first: the mapped value is built (in its slot) on miss only
+		T& operator[](const Key& key)
+		{
+			return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).first->second;
+		}
+
+		T& operator[](Key&& key)
+		{
+			return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple()).first->second;
+		}
+
+		T& at(const Key& key)
+		{
+			const size_type i = find_index(key);
+			if (i == npos) throw std::out_of_range("mstl::unordered_map::at: key not found");
+			return mp_Slots[i].second;
+		}
+
+		const T& at(const Key& key) const
+		{
+			const size_type i = find_index(key);
+			if (i == npos) throw std::out_of_range("mstl::unordered_map::at: key not found");
+			return mp_Slots[i].second;
+		}
+
+		// ================= Lookup =================
+
+		iterator find(const Key& key)
+		{
+			const size_type i = find_index(key);
+			return i == npos ? end() : iterator{ mp_Ctrl + i, mp_Slots + i };
+		}
+
+		const_iterator find(const Key& key) const
+		{
+			const size_type i = find_index(key);
+			return i == npos ? end() : const_iterator{ mp_Ctrl + i, mp_Slots + i };
+		}
+
+		size_type count(const Key& key) const { return find_index(key) == npos ? 0 : 1; }
+
+		bool contains(const Key& key) const { return find_index(key) != npos; }
+
+		// ================= Observers =================
+
+		hasher hash_function() const { return m_Hash; }
+		key_equal key_eq() const { return m_Eq; }
+		allocator_type get_allocator() const { return m_Alloc; }
+
+	private:
+
+		static constexpr size_type npos = static_cast<size_type>(-1);
+
+		static constexpr size_type max_load(size_type cap) noexcept { return cap - cap / 8; }
+
+		// ================= Hashing =================
+
+		// spread the bits: std::hash of integers is often the identity
+		size_type hash_of(const Key& key) const
+		{
+			std::uint64_t h = static_cast<std::uint64_t>(m_Hash(key));
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return static_cast<size_type>(h);
+		}
+
+		static size_type h1(size_type hash) noexcept { return hash >> 7; }
+		static swiss_ctrl h2(size_type hash) noexcept { return static_cast<swiss_ctrl>(hash & 0x7F); }
+
+		// ================= Probing =================
+
+		size_type group_mask() const noexcept { return m_Capacity / swiss_group_width - 1; }
+
+		size_type find_index(const Key& key) const
+		{
+			return m_Size ? find_index(key, hash_of(key)) : npos;
+		}
+
+		size_type find_index(const Key& key, size_type hash) const
+		{
+			const swiss_ctrl tag = h2(hash);
+			const size_type mask = group_mask();
+
+			size_type g = h1(hash) & mask;
+
+			for (size_type step = 1; ; ++step)
+			{
+				const size_type base = g * swiss_group_width;
+				const swiss_group group{ mp_Ctrl + base };
+
+				for (std::uint32_t m = group.match(tag); m; m &= m - 1)
+				{
+					const size_type i = base + static_cast<size_type>(std::countr_zero(m));
+					if (m_Eq(mp_Slots[i].first, key)) return i;
+				}
+
+				// an empty slot ends the probe sequence
+				if (group.match_empty()) return npos;
+
+				g = (g + step) & mask;
+			}
+		}
+
+		// first empty or deleted slot along the probe sequence of hash
+		size_type find_free(size_type hash) const noexcept
+		{
+			const size_type mask = group_mask();
+			size_type g = h1(hash) & mask;
+
+			for (size_type step = 1; ; ++step)
+			{
+				const size_type base = g * swiss_group_width;
+				const std::uint32_t m = swiss_group{ mp_Ctrl + base }.match_empty_or_deleted();
+
+				if (m) return base + static_cast<size_type>(std::countr_zero(m));
+
+				g = (g + step) & mask;
+			}
+		}
+
+		// lookup, and on miss construct value_type(args...) in a free slot
+		template<class... Args>
+		std::pair<iterator, bool> emplace_key(const Key& key, Args&&... args)
+		{
+			const size_type hash = hash_of(key);
+
+			const size_type found = m_Size ? find_index(key, hash) : npos;
+			if (found != npos) return { iterator{ mp_Ctrl + found, mp_Slots + found }, false };
+
+			if (m_Size + m_Deleted + 1 > max_load(m_Capacity))
+			{
+				// mostly tombstones: clean up in place, otherwise grow
+				rehash_to(m_Capacity && m_Deleted >= m_Size ? m_Capacity : (m_Capacity ? 2 * m_Capacity : swiss_group_width));
+			}
+
+			const size_type i = find_free(hash);
+
+			alloc_traits::construct(m_Alloc, mp_Slots + i, std::forward<Args>(args)...);
+
+			if (mp_Ctrl[i] == swiss_deleted) --m_Deleted;
+			mp_Ctrl[i] = h2(hash);
+			++m_Size;
+
+			return { iterator{ mp_Ctrl + i, mp_Slots + i }, true };
+		}
+
+		// copy construction: no duplicates and room already reserved
+		void insert_unique_no_grow(const value_type& v)
+		{
+			const size_type hash = hash_of(v.first);
+			const size_type i = find_free(hash);
+			alloc_traits::construct(m_Alloc, mp_Slots + i, v);
+			mp_Ctrl[i] = h2(hash);
+			++m_Size;
+		}
+
+		void erase_at(size_type i)
+		{
+			alloc_traits::destroy(m_Alloc, mp_Slots + i);
+			--m_Size;
+
+			// if the group still has an empty slot no probe sequence
+			// ever went past it: the slot can become empty again
+			const size_type base = i - i % swiss_group_width;
+
+			if (swiss_group{ mp_Ctrl + base }.match_empty())
+			{
+				mp_Ctrl[i] = swiss_empty;
+			}
+			else
+			{
+				mp_Ctrl[i] = swiss_deleted;
+				++m_Deleted;
+			}
+		}
+
+		// ================= Storage =================
+
+		void reset_ctrl() noexcept
+		{
+			std::memset(mp_Ctrl, static_cast<unsigned char>(swiss_empty), m_Capacity);
+			std::memset(mp_Ctrl + m_Capacity, static_cast<unsigned char>(swiss_sentinel), swiss_group_width);
+		}
+
+		/// Moves every element into a fresh table of new_cap slots
+		/// (also drops tombstones). If a move/copy throws the new
+		/// table is discarded and the map is left untouched.
+		void rehash_to(size_type new_cap)
+		{
+			swiss_ctrl* new_ctrl = ctrl_traits::allocate(m_CtrlAlloc, new_cap + swiss_group_width);
+			value_type* new_slots = nullptr;
+
+			try {
+				new_slots = alloc_traits::allocate(m_Alloc, new_cap);
+			}
+			catch (...)
+			{
+				ctrl_traits::deallocate(m_CtrlAlloc, new_ctrl, new_cap + swiss_group_width);
+				throw;
+			}
+
+			unordered_map fresh{ m_Alloc, m_Hash, m_Eq };
+			fresh.mp_Ctrl = new_ctrl;
+			fresh.mp_Slots = new_slots;
+			fresh.m_Capacity = new_cap;
+			fresh.reset_ctrl();
+
+			for (size_type i = 0; i < m_Capacity; ++i)
+			{
+				if (!swiss_is_full(mp_Ctrl[i])) continue;
+
+				const size_type hash = hash_of(mp_Slots[i].first);
+				const size_type j = fresh.find_free(hash);
+
+				alloc_traits::construct(fresh.m_Alloc, fresh.mp_Slots + j, std::move_if_noexcept(mp_Slots[i]));
+				fresh.mp_Ctrl[j] = h2(hash);
+				++fresh.m_Size;
+			}
+
+			swap(fresh);
+		}
+
+		void destroy_all() noexcept
+		{
+			if (!m_Capacity) return;
+
+			clear();
+			alloc_traits::deallocate(m_Alloc, mp_Slots, m_Capacity);
+			ctrl_traits::deallocate(m_CtrlAlloc, mp_Ctrl, m_Capacity + swiss_group_width);
+
+			mp_Ctrl = nullptr;
+			mp_Slots = nullptr;
+			m_Capacity = 0;
+		}
+
+		void steal(unordered_map& other) noexcept
+		{
+			mp_Ctrl = std::exchange(other.mp_Ctrl, nullptr);
+			mp_Slots = std::exchange(other.mp_Slots, nullptr);
+			m_Capacity = std::exchange(other.m_Capacity, 0);
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Deleted = std::exchange(other.m_Deleted, 0);
+		}
+
+		// empty shell sharing allocator and functors (used by rehash
+		// and the copy constructor)
+		unordered_map(const Alloc& alloc, const Hash& hash, const KeyEqual& eq)
+			: m_Alloc{ alloc }, m_CtrlAlloc{ m_Alloc }, m_Hash{ hash }, m_Eq{ eq } {
+		}
+	};
+
+	template<typename K, typename M, typename H, typename E, typename A>
+	bool operator==(const unordered_map<K, M, H, E, A>& a, const unordered_map<K, M, H, E, A>& b)
+	{
+		if (a.size() != b.size()) return false;
+
+		for (const auto& v : a)
+		{
+			auto it = b.find(v.first);
+			if (it == b.end() || !(it->second == v.second)) return false;
+		}
+
+		return true;
+	}
+
+	template<typename K, typename M, typename H, typename E, typename A>
+	bool operator!=(const unordered_map<K, M, H, E, A>& a, const unordered_map<K, M, H, E, A>& b)
+	{
+		return !(a == b);
+	}
+
+	template<typename K, typename M, typename H, typename E, typename A>
+	void swap(unordered_map<K, M, H, E, A>& a, unordered_map<K, M, H, E, A>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // !MSTL_UNORDERED_MAP_H
@@ -0,0 +1,487 @@
+#ifndef MSTL_UNROLLED_LIST_H
+#define MSTL_UNROLLED_LIST_H
+
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include "concepts_utils.h"
+#include "internals/link.h"
+#include "internals/relocate.h"
+#include "internals/trace.h"
+
+namespace mstl {
+
+	/// Default elements per node: about 256 bytes of payload, at least 4.
+	template<typename T>
+	inline constexpr std::size_t unrolled_list_capacity =
+		std::max<std::size_t>(4, (256 - sizeof(linkbase) - sizeof(std::size_t)) / sizeof(T));
+
+	/// node of an unrolled_list: links + up to N elements, the first
+	/// m_Count of them alive
+	template<typename T, std::size_t N>
+	struct unrolled_node : public linkbase {
+
+		std::size_t m_Count{};
+		alignas(T) unsigned char m_Storage[N * sizeof(T)];
+
+		T* data() noexcept { return reinterpret_cast<T*>(m_Storage); }
+		const T* data() const noexcept { return reinterpret_cast<const T*>(m_Storage); }
+	};
+
+	/// ---------------------------------------------------------------
+	/// unrolled_list iterator
+	/// ---------------------------------------------------------------
+	/// (node, index) pair; end() is (master, 0). Nodes are never empty,
+	/// so stepping only crosses a node when the index runs out.
+
+	template<typename T, std::size_t N, bool IsConst>
+	class unrolled_list_iterator {
+
+		template<typename, std::size_t, typename> friend class unrolled_list;
+		template<typename, std::size_t, bool> friend class unrolled_list_iterator;
+
+		using node_type = unrolled_node<T, N>;
+		using link_ptr = std::conditional_t<IsConst, const linkbase*, linkbase*>;
+
+		link_ptr mp_Node{};
+		std::size_t m_Index{};
+
+		unrolled_list_iterator(link_ptr node, std::size_t index) noexcept : mp_Node{ node }, m_Index{ index } {}
+
+		auto* node() const noexcept {
+			using np = std::conditional_t<IsConst, const node_type*, node_type*>;
+			return static_cast<np>(mp_Node);
+		}
+
+	public:
+
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<IsConst, const T*, T*>;
+		using reference = std::conditional_t<IsConst, const T&, T&>;
+
+		unrolled_list_iterator() = default;
+
+		// iterator -> const_iterator
+		template<bool C = IsConst> requires C
+		unrolled_list_iterator(const unrolled_list_iterator<T, N, false>& it) noexcept : mp_Node{ it.mp_Node }, m_Index{ it.m_Index } {}
+
+		reference operator*() const noexcept { return node()->data()[m_Index]; }
+		pointer operator->() const noexcept { return node()->data() + m_Index; }
+
+		unrolled_list_iterator& operator++() noexcept {
+			if (++m_Index == node()->m_Count)
+			{
+				mp_Node = mp_Node->succ;
+				m_Index = 0;
+			}
+			return *this;
+		}
+
+		unrolled_list_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+		unrolled_list_iterator& operator--() noexcept {
+			if (m_Index == 0)
+			{
+				mp_Node = mp_Node->prev;
+				m_Index = node()->m_Count;
+			}
+			--m_Index;
+			return *this;
+		}
+
+		unrolled_list_iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+
+		bool operator==(const unrolled_list_iterator& other) const noexcept {
+			return mp_Node == other.mp_Node && m_Index == other.m_Index;
+		}
+	};
+
+	/// Unrolled linked list: a doubly linked list of nodes holding up
+	/// to NodeCapacity elements each. Traversal reads consecutive
+	/// elements from the same node (one cache miss per node instead of
+	/// one per element as in mstl::list) and there is one allocation
+	/// per node.
+	///
+	/// insert/erase at an iterator shift at most NodeCapacity elements
+	/// inside one node: O(NodeCapacity) = O(1) for a fixed capacity.
+	///  - a full node is split in two halves (inserting at the very
+	///    front or back of a full node starts a new node instead, so
+	///    push_back/push_front leave full nodes behind);
+	///  - a node that drops under NodeCapacity / 4 is merged with a
+	///    neighbour when both fit in one node, an emptied node is freed.
+	///
+	/// [!] insert and erase invalidate the iterators into the touched
+	///     node(s); elements move between nodes on split/merge.
+
+	template<typename T, std::size_t NodeCapacity = unrolled_list_capacity<T>, typename A = std::allocator<T>>
+		requires Element<T>
+	class unrolled_list {
+
+		static_assert(NodeCapacity >= 2, "unrolled_list: a node must hold at least 2 elements");
+
+	public:
+
+		using value_type = T;
+		using alloc_type = A;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using alloc_traits = std::allocator_traits<A>;
+		using size_type = typename alloc_traits::size_type;
+		using difference_type = std::ptrdiff_t;
+
+		using node_type = unrolled_node<T, NodeCapacity>;
+		using node_alloc = typename alloc_traits::template rebind_alloc<node_type>;
+		using node_traits = std::allocator_traits<node_alloc>;
+		using trace = trace_hook_t<unrolled_list>;    // null_trace unless MSTL_TRACE
+
+		using iterator = unrolled_list_iterator<T, NodeCapacity, false>;
+		using const_iterator = unrolled_list_iterator<T, NodeCapacity, true>;
+
+		static constexpr size_type node_capacity = NodeCapacity;
+
+	private:
+
+		static constexpr size_type merge_threshold = NodeCapacity / 4;
+
+		[[no_unique_address]] alloc_type m_Alloc{};
+		[[no_unique_address]] node_alloc m_NodeAlloc{ m_Alloc };
+		linkbase m_Master{};
+		size_type m_Size{};
+
+	public:
+
+		// ================= Ctors =================
+
+		unrolled_list() noexcept(std::is_nothrow_default_constructible_v<alloc_type>) {
+			m_Master.prev = m_Master.succ = &m_Master;
+		}
+
+		explicit unrolled_list(const alloc_type& a) noexcept
+			: m_Alloc{ a }
+			, m_NodeAlloc{ a } {
+			m_Master.prev = m_Master.succ = &m_Master;
+		}
+
+		unrolled_list(std::initializer_list<T> i_lst) : unrolled_list() {
+			for (const T& v : i_lst) push_back(v);
+		}
+
+		unrolled_list(const unrolled_list& other)
+			: unrolled_list(alloc_traits::select_on_container_copy_construction(other.m_Alloc)) {
+			try {
+				for (const T& v : other) push_back(v);
+			}
+			catch (...)
+			{
+				clear();
+				throw;
+			}
+		}
+
+		unrolled_list(unrolled_list&& other) noexcept
+			: m_Alloc{ other.m_Alloc }
+			, m_NodeAlloc{ other.m_NodeAlloc }
+			, m_Size{ other.m_Size } {
+			ListAdoptRing(&m_Master, &other.m_Master);
+			other.m_Size = 0;
+		}
+
+		unrolled_list& operator=(const unrolled_list& other) {
+			if (this != &other)
+			{
+				unrolled_list tmp(other);
+				swap(tmp);
+			}
+			return *this;
+		}
+
+		// the nodes are adopted only with an allocator that can free
+		// them: propagated as deque does, or equal; else moved one by one
+		unrolled_list& operator=(unrolled_list&& other) noexcept(
+			alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) {
+			if (this != &other)
+			{
+				clear();
+
+				if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+				{
+					swap(other);
+				}
+				else if (alloc_traits::is_always_equal::value || m_Alloc == other.m_Alloc)
+				{
+					ListAdoptRing(&m_Master, &other.m_Master);
+					m_Size = other.m_Size;
+					other.m_Size = 0;
+				}
+				else
+				{
+					for (T& v : other) push_back(std::move(v));
+					other.clear();
+				}
+			}
+			return *this;
+		}
+
+		~unrolled_list() {
+			clear();
+		}
+
+		void swap(unrolled_list& other) noexcept {
+			linkbase tmp{};
+			ListAdoptRing(&tmp, &other.m_Master);
+			ListAdoptRing(&other.m_Master, &m_Master);
+			ListAdoptRing(&m_Master, &tmp);
+
+			std::swap(m_Alloc, other.m_Alloc);
+			std::swap(m_NodeAlloc, other.m_NodeAlloc);
+			std::swap(m_Size, other.m_Size);
+		}
+
+		// ================= Iterators =================
+
+		iterator begin() noexcept { return iterator{ m_Master.succ, 0 }; }
+		const_iterator begin() const noexcept { return const_iterator{ m_Master.succ, 0 }; }
+		iterator end() noexcept { return iterator{ &m_Master, 0 }; }
+		const_iterator end() const noexcept { return const_iterator{ &m_Master, 0 }; }
+
+		// ================= Access =================
+
+		reference front() { return Node(m_Master.succ)->data()[0]; }
+		const_reference front() const { return Node(m_Master.succ)->data()[0]; }
+		reference back() { node_type* n = Node(m_Master.prev); return n->data()[n->m_Count - 1]; }
+		const_reference back() const { const node_type* n = Node(m_Master.prev); return n->data()[n->m_Count - 1]; }
+
+		bool empty() const noexcept { return m_Size == 0; }
+		size_type size() const noexcept { return m_Size; }
+
+		// ================= Modifiers =================
+
+		void push_back(const value_type& v) { emplace(end(), v); }
+		void push_back(value_type&& v) { emplace(end(), std::move(v)); }
+		void push_front(const value_type& v) { emplace(begin(), v); }
+		void push_front(value_type&& v) { emplace(begin(), std::move(v)); }
+
+		void pop_back() { erase(--end()); }
+		void pop_front() { erase(begin()); }
+
+		iterator insert(const_iterator pos, const value_type& v) { return emplace(pos, v); }
+		iterator insert(const_iterator pos, value_type&& v) { return emplace(pos, std::move(v)); }
+
+		template<class... Args>
+		iterator emplace(const_iterator pos, Args&&... args) {
+
+			// args may refer to an element that the shift below moves
+			value_type tmp(std::forward<Args>(args)...);
+
+			linkbase* n = const_cast<linkbase*>(pos.mp_Node);
+			size_type i = pos.m_Index;
+
+			if (n == &m_Master)
+			{
+				// end: append to the last node, or start a new one
+				n = m_Master.prev;
+
+				if (n == &m_Master || Node(n)->m_Count == NodeCapacity)
+					n = DoCreateNode(&m_Master);
+
+				i = Node(n)->m_Count;
+			}
+			else if (Node(n)->m_Count == NodeCapacity)
+			{
+				if (i == 0)
+				{
+					// front of a full node: open a new node before it
+					n = DoCreateNode(n);
+				}
+				else
+				{
+					// split: the upper half goes to a new node after n
+					constexpr size_type half = NodeCapacity / 2;
+					node_type* const m = DoCreateNode(n->succ);
+
+					RelocateN(m_Alloc, Node(n)->data() + half, NodeCapacity - half, m->data());
+					m->m_Count = NodeCapacity - half;
+					Node(n)->m_Count = half;
+
+					if (i > half)
+					{
+						n = m;
+						i -= half;
+					}
+				}
+			}
+
+			ShiftRight(Node(n), i);
+
+			try {
+				alloc_traits::construct(m_Alloc, Node(n)->data() + i, std::move(tmp));
+			}
+			catch (...)
+			{
+				ShiftLeft(Node(n), i);
+				if (Node(n)->m_Count == 0) DoDestroyNode(Node(n));
+				throw;
+			}
+
+			++m_Size;
+			return iterator{ n, i };
+		}
+
+		iterator erase(const_iterator pos) {
+
+			node_type* n = Node(const_cast<linkbase*>(pos.mp_Node));
+			size_type i = pos.m_Index;
+
+			alloc_traits::destroy(m_Alloc, n->data() + i);
+			ShiftLeft(n, i);
+			--m_Size;
+
+			if (n->m_Count == 0)
+			{
+				linkbase* const next = n->succ;
+				DoDestroyNode(n);
+				return iterator{ next, 0 };
+			}
+
+			if (n->m_Count < merge_threshold)
+			{
+				linkbase* const next = n->succ;
+				linkbase* const prev = n->prev;
+
+				if (next != &m_Master && n->m_Count + Node(next)->m_Count <= NodeCapacity)
+				{
+					// pull the next node in
+					MergeInto(n, Node(next));
+				}
+				else if (prev != &m_Master && Node(prev)->m_Count + n->m_Count <= NodeCapacity)
+				{
+					// push this node into the previous one
+					i += Node(prev)->m_Count;
+					MergeInto(Node(prev), n);
+					n = Node(prev);
+				}
+			}
+
+			if (i == n->m_Count)
+				return iterator{ n->succ, 0 };
+
+			return iterator{ n, i };
+		}
+
+		void clear() noexcept {
+
+			linkbase* p = m_Master.succ;
+
+			while (p != &m_Master)
+			{
+				node_type* const n = Node(p);
+				p = p->succ;
+
+				DestroyN(m_Alloc, n->data(), n->m_Count);
+				DoDeallocateNode(n);
+			}
+
+			m_Master.prev = m_Master.succ = &m_Master;
+			m_Size = 0;
+		}
+
+	private:
+
+		//
+		// ================= Helpers =================
+		//
+
+		static node_type* Node(linkbase* p) noexcept { return static_cast<node_type*>(p); }
+		static const node_type* Node(const linkbase* p) noexcept { return static_cast<const node_type*>(p); }
+
+		// opens a hole at i of a non-full node (count grows by one)
+		void ShiftRight(node_type* n, size_type i) {
+
+			T* d = n->data();
+			const size_type count = n->m_Count;
+
+			if constexpr (relocate_by_memcpy<A>)
+			{
+				std::memmove(static_cast<void*>(d + i + 1), static_cast<const void*>(d + i), (count - i) * sizeof(T));
+			}
+			else if (i < count)
+			{
+				alloc_traits::construct(m_Alloc, d + count, std::move(d[count - 1]));
+				std::move_backward(d + i, d + count - 1, d + count);
+				alloc_traits::destroy(m_Alloc, d + i);
+			}
+
+			n->m_Count = count + 1;
+		}
+
+		// closes the (already destroyed) hole at i
+		void ShiftLeft(node_type* n, size_type i) noexcept {
+
+			T* d = n->data();
+			const size_type count = n->m_Count;
+
+			if constexpr (relocate_by_memcpy<A>)
+			{
+				std::memmove(static_cast<void*>(d + i), static_cast<const void*>(d + i + 1), (count - i - 1) * sizeof(T));
+			}
+			else if (i + 1 < count)
+			{
+				alloc_traits::construct(m_Alloc, d + i, std::move(d[i + 1]));
+				std::move(d + i + 2, d + count, d + i + 1);
+				alloc_traits::destroy(m_Alloc, d + count - 1);
+			}
+
+			n->m_Count = count - 1;
+		}
+
+		// moves all of src at the end of dst and frees src
+		void MergeInto(node_type* dst, node_type* src) {
+
+			RelocateN(m_Alloc, src->data(), src->m_Count, dst->data() + dst->m_Count);
+			dst->m_Count += src->m_Count;
+			src->m_Count = 0;
+
+			DoDestroyNode(src);
+		}
+
+		// new empty node linked before pos
+		node_type* DoCreateNode(linkbase* pos) {
+
+			node_type* n = node_traits::allocate(m_NodeAlloc, 1);
+			trace::on_allocate(sizeof(node_type));
+
+			::new (static_cast<void*>(n)) node_type;
+			ListLinkBefore(pos, n);
+			return n;
+		}
+
+		// unlinks and frees an empty node
+		void DoDestroyNode(node_type* n) noexcept {
+			ListUnlink(n);
+			DoDeallocateNode(n);
+		}
+
+		void DoDeallocateNode(node_type* n) noexcept {
+			node_traits::deallocate(m_NodeAlloc, n, 1);
+			trace::on_deallocate(sizeof(node_type));
+		}
+	};
+
+	template<typename T, std::size_t N, typename A>
+	bool operator==(const unrolled_list<T, N, A>& a, const unrolled_list<T, N, A>& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template<typename T, std::size_t N, typename A>
+	void swap(unrolled_list<T, N, A>& a, unrolled_list<T, N, A>& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+#endif // !MSTL_UNROLLED_LIST_H
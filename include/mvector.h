@@ -4,7 +4,20 @@
 #include <initializer_list>
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <ranges>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <new>
+#include <cstring>
+#include "internals/relocate.h"
+#include "internals/trace.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 // concepts
 template<typename E>
@@ -21,17 +34,35 @@ namespace mstl {
 	///
 	/// vector_rep
 	/// 
+	/// Owns the buffer. On Linux big buffers of trivially relocatable
+	/// types can live in an anonymous mapping instead (mapped == true):
+	/// growing it is an mremap, the kernel moves page table entries
+	/// and no element is copied.
 
 	template<typename T, typename A = std::allocator<T>>
 	struct vector_rep {
 
 		using alloc_traits = std::allocator_traits<A>;
 		using size_type = typename alloc_traits::size_type;  // tipically: std::size_t
+		using trace = trace_hook_t<vector_rep>;               // null_trace unless MSTL_TRACE
 
 		[[no_unique_address]] A alloc{}; //from C++20
 		size_type sz{};
 		T* elem{};    //pImpl idiom
 		size_type space{};
+		bool mapped{};    // elem comes from mmap, not from alloc
+
+#ifdef __linux__
+		// only for the default allocator: a custom one owns its memory
+		static constexpr bool can_map = relocate_by_memcpy<A, T>
+			&& std::is_same_v<A, std::allocator<T>>
+			&& alignof(T) <= 4096;
+#else
+		static constexpr bool can_map = false;
+#endif
+
+		// below this size malloc/realloc are as good
+		static constexpr std::size_t map_threshold = std::size_t{ 64 } << 20;   // 64 MiB
 
 		vector_rep() : alloc{ A{} }, sz{ 0 }, elem{ nullptr }, space{ 0 } {}
 
@@ -39,13 +70,80 @@ namespace mstl {
 
 		vector_rep(const A& in_allocator, size_type n)
 			: alloc{ in_allocator }, sz{ 0 }, elem{ alloc_traits::allocate(alloc, n) }, space{ n } {
-			std::cout << "ctor vector_rep called\n";
+			if (n) trace::on_allocate(n * sizeof(T));
 		}
 
 		~vector_rep() {
-			std::cout << "dtor vector_rep called\n";
+			release();
+		}
+
+		bool wants_map(size_type n) const noexcept {
+			return can_map && n > space && n * sizeof(T) >= map_threshold;
+		}
+
+		/// Grows the buffer to n elements through the mapping, the
+		/// first time the current elements are copied in (one memcpy),
+		/// afterwards mremap may move the pages without copying.
+		void map_grow(size_type n)
+		{
+#ifdef __linux__
+			const std::size_t bytes = map_bytes(n);
+			void* p = nullptr;
+
+			if (mapped)
+			{
+				p = ::mremap(elem, map_bytes(space), bytes, MREMAP_MAYMOVE);
+				if (p == MAP_FAILED) throw std::bad_alloc{};
+
+				trace::on_grow(0);     // pages moved, no element copied
+			}
+			else
+			{
+				p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (p == MAP_FAILED) throw std::bad_alloc{};
+
+				if (sz) std::memcpy(p, static_cast<const void*>(elem), sz * sizeof(T));
+				if (elem)
+				{
+					alloc_traits::deallocate(alloc, elem, space);
+					trace::on_deallocate(space * sizeof(T));
+				}
+				mapped = true;
+
+				trace::on_allocate(bytes);
+				trace::on_grow(sz * sizeof(T));
+			}
+
+			elem = static_cast<T*>(p);
+			space = n;
+#else
+			(void)n;
+#endif
+		}
+
+		void release() noexcept {
+#ifdef __linux__
+			if (mapped)
+			{
+				::munmap(elem, map_bytes(space));
+				trace::on_deallocate(map_bytes(space));
+				return;
+			}
+#endif
+			if (!elem) return;
+
 			alloc_traits::deallocate(alloc, elem, space);
+			trace::on_deallocate(space * sizeof(T));
 		}
+
+	private:
+
+#ifdef __linux__
+		static std::size_t map_bytes(size_type n) noexcept {
+			const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+			return (n * sizeof(T) + page - 1) / page * page;
+		}
+#endif
 	};
 
 	/// 
@@ -66,15 +164,81 @@ namespace mstl {
 		using size_type = typename vector_rep<T, A>::size_type;
 		using value_type = T;
 		using iterator = T*;
+		using trace = typename vector_rep<T, A>::trace;   // trace::stats() for bench reports
 		using const_iterator = const T*;
 
-		vector() : r{} { std::cout << "vector ctor called\n"; }
+	private:
+		static constexpr size_type reasonable_size = std::numeric_limits<size_type>::max() / sizeof(T);
+
+		// geometric growth, but at least room for extra more elements
+		size_type next_capacity(size_type extra) const
+		{
+			return NextCapacity<size_type>(size(), capacity(), extra, reasonable_size, 8);
+		}
+
+		// full buffer: the new element is built in the new buffer first
+		// (args may refer to an element of this vector), then the old
+		// ones are relocated next to it
+		template<class... Args>
+		T& realloc_emplace_back(Args&&... args)
+		{
+			const size_type newAlloc = next_capacity(1);
+
+			if (r.wants_map(newAlloc))
+			{
+				value_type tmp(std::forward<Args>(args)...);
+				r.map_grow(newAlloc);
+				alloc_traits::construct(r.alloc, r.elem + r.sz, std::move(tmp));
+				++r.sz;
+				return r.elem[r.sz - 1];
+			}
+
+			vector_rep<T, A> b{ r.alloc, newAlloc };
+			RelocateAroundGap(r.alloc, r.elem, r.sz, r.sz, 1, b.elem, [&](T* dst) {
+				alloc_traits::construct(b.alloc, dst, std::forward<Args>(args)...);
+			});
+
+			b.sz = r.sz + 1;
+			trace::on_grow(r.sz * sizeof(T));
+			swap(r, b);
+			return r.elem[r.sz - 1];
+		}
+
+		// opens a gap of n elements at index and lets fill(dst) build them
+		// (fill constructs all n or none), see RelocateAroundGap and
+		// InsertGapInPlace: a reallocation fills the new buffer before
+		// relocating, so the old elements stay valid sources
+		template<class Fill>
+		iterator insert_n(size_type index, size_type n, Fill&& fill)
+		{
+			if (size() + n > capacity())
+			{
+				const size_type newAlloc = next_capacity(n);
+
+				if (r.wants_map(newAlloc))
+					r.map_grow(newAlloc);
+				else
+				{
+					vector_rep<T, A> b{ r.alloc, newAlloc };
+					RelocateAroundGap(r.alloc, r.elem, r.sz, index, n, b.elem, fill);
+
+					b.sz = r.sz + n;
+					trace::on_grow(r.sz * sizeof(T));
+					swap(r, b);
+					return begin() + index;
+				}
+			}
+
+			InsertGapInPlace(r.alloc, r.elem, r.sz, index, n, fill);
+			return begin() + index;
+		}
+
+	public:
+		vector() : r{} {}
 
 		explicit vector(size_type i_size, value_type def = value_type{})
 			: r{ A{}, i_size }
 		{
-			std::cout << "vector ctor called\n";
-
 			if (!(i_size >= 0 && i_size < reasonable_size))
 				throw std::length_error{ "Wrong size for vector" };
 
@@ -84,12 +248,11 @@ namespace mstl {
 		vector(std::initializer_list<T> i_lst)
 			: r{ A{}, static_cast<size_type>(i_lst.size()) }
 		{
-			std::cout << "vector ctor called\n";
 			if (capacity() > 0)
 			{
 				int i = 0;
 				for (const T& v : i_lst) {
-					alloc_traits::construct(alloc, &r.elem[i++], v);
+					alloc_traits::construct(r.alloc, &r.elem[i++], v);
 				}
 
 				r.sz = static_cast<size_type>(i_lst.size());
@@ -100,16 +263,10 @@ namespace mstl {
 		vector(const vector& i_v)
 			: r{ i_v.r.alloc, i_v.r.sz }
 		{
-			// if construction fails, it is nice to destroy objects 
-			// inside a catch block
-
-			if (i_v.size() > 0) {
-				size_type i = 0;
-				for (const T& v : i_v) {
-					alloc_traits::construct(r.alloc, &r.elem[i++], v);
-				}
-				r.sz = i_v.size();
-			}
+			// memcpy for trivially copyable types, otherwise element
+			// by element (what was built is destroyed if one throws)
+			UninitializedCopyN(r.alloc, i_v.r.elem, i_v.size(), r.elem);
+			r.sz = i_v.size();
 		}
 
 		// copy assignment
@@ -122,7 +279,9 @@ namespace mstl {
 			{
 				// since i_v is a const ref, move algo make copies and does not move
 				std::move(i_v.begin(), i_v.begin() + i_v.size(), begin());
-				std::destroy(begin() + i_v.size(), end());		// destroy eventual surplus
+				DestroyN(r.alloc, begin() + i_v.size(), size() - i_v.size());		// destroy eventual surplus
+				r.sz = i_v.size();
+				return *this;
 			}
 
 			// need more space
@@ -139,9 +298,11 @@ namespace mstl {
 			r.sz = i_v.size();
 			r.space = i_v.capacity();
 			r.elem = i_v.r.elem;
+			r.mapped = i_v.r.mapped;
 
 			i_v.r.sz = i_v.r.space = 0;
 			i_v.r.elem = nullptr;
+			i_v.r.mapped = false;
 		}
 
 		// move assignment
@@ -170,8 +331,6 @@ namespace mstl {
 		// destructor
 		~vector()
 		{
-			std::cout << "vector dtor called\n";
-
 			for (size_type i = 0; i < r.sz; ++i) {
 				alloc_traits::destroy(r.alloc, &r.elem[i]);
 			}
@@ -183,14 +342,14 @@ namespace mstl {
 		T& at(size_type n)
 		{
 			if (n < 0 || size() <= n)
-				throw out_of_range_bs(n);
+				throw std::out_of_range{ "mstl::vector::at: index out of range" };
 
 			return r.elem[n];
 		}
 		const T& at(size_type n) const
 		{
 			if (n < 0 || size() <= n)
-				throw out_of_range_bs(n);
+				throw std::out_of_range{ "mstl::vector::at: index out of range" };
 
 			return r.elem[n];
 		}
@@ -212,16 +371,21 @@ namespace mstl {
 			if (newAlloc <= capacity())
 				return;
 
+			// huge buffers of relocatable types: grow the mapping in place
+			if (r.wants_map(newAlloc))
+			{
+				r.map_grow(newAlloc);
+				return;
+			}
+
 			vector_rep<T, A> b{ r.alloc, newAlloc };
 
-			//std::uninitialized_move(begin(), end(), b.elem);
-			//std::destroy(begin(), end());
-			for (size_type i = 0; i < r.sz; ++i) {
-				alloc_traits::construct(b.alloc, b.elem + i, std::move(r.elem[i]));
-				alloc_traits::destroy(r.alloc, r.elem + i);
-			}
+			// one memcpy for trivially relocatable types; otherwise
+			// move_if_noexcept, r stays intact if a copy throws
+			RelocateN(r.alloc, r.elem, r.sz, b.elem);
 
 			b.sz = r.sz;
+			trace::on_grow(r.sz * sizeof(T));
 			swap(r, b);
 
 			// old r values freed with the destruction of b, no memory leaks
@@ -249,17 +413,48 @@ namespace mstl {
 
 		void push_back(const value_type& newElem)
 		{
-			if (capacity() == 0)
+			emplace_back(newElem);
+		}
+
+		void push_back(value_type&& newElem)
+		{
+			emplace_back(std::move(newElem));
+		}
+
+		// builds the element in place at the end
+		template<class... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (size() == capacity())
+				return realloc_emplace_back(std::forward<Args>(args)...);
+
+			alloc_traits::construct(r.alloc, r.elem + r.sz, std::forward<Args>(args)...);
+			++r.sz;
+			return r.elem[r.sz - 1];
+		}
+
+		// appends a whole range: one reservation when its size is known
+		template<std::ranges::input_range R>
+		void append_range(R&& rg)
+		{
+			if constexpr (std::ranges::forward_range<R> || std::ranges::sized_range<R>)
 			{
-				reserve(8);  // default initial space
+				const size_type n = static_cast<size_type>(std::ranges::distance(rg));
+
+				if (size() + n > capacity())
+					reserve(next_capacity(n));
+
+				for (auto&& v : rg)
+				{
+					alloc_traits::construct(r.alloc, r.elem + r.sz, std::forward<decltype(v)>(v));
+					++r.sz;
+				}
 			}
-			else if (size() == capacity())
+			else
 			{
-				reserve(2 * capacity());
+				for (auto&& v : rg)
+					emplace_back(std::forward<decltype(v)>(v));
 			}
-			//std::construct_at(end(), newElem);
-			alloc_traits::construct(r.alloc, r.elem + r.sz, newElem);
-			++r.sz;
 		}
 
 		/*
@@ -270,32 +465,125 @@ namespace mstl {
 		elements. We have repeatedly seen the usefulness of push_back(), which is
 		another operation traditionally associated with lists.
 		*/
+
 		iterator insert(iterator p, const value_type& val)
 		{
-			// TODO: use alloc traits
+			return emplace(p, val);
+		}
 
+		iterator insert(iterator p, value_type&& val)
+		{
+			return emplace(p, std::move(val));
+		}
+
+		template<class... Args>
+		iterator emplace(iterator p, Args&&... args)
+		{
 			size_type index = p - begin(); // save index in case of relocation, iterator invalidation
 
-			if (size() == capacity())
-				reserve(size() == 0 ? 8 : 2 * size());
+			if (p == end())
+			{
+				emplace_back(std::forward<Args>(args)...);
+				return begin() + index;
+			}
 
-			p = begin() + index;
-			std::move_backward(p, end() - 1, p + 1);
-			*p = val;
-			++r.sz;
-			return p;
+			// args may refer to elements of this vector: build the
+			// value before growing or shifting moves them
+			value_type tmp(std::forward<Args>(args)...);
+
+			return insert_n(index, 1, [&](T* dst) {
+				alloc_traits::construct(r.alloc, dst, std::move(tmp));
+			});
+		}
+
+		iterator insert(iterator p, size_type n, const value_type& val)
+		{
+			const size_type index = p - begin();
+			if (n == 0) return p;
+
+			value_type copy(val);
+
+			return insert_n(index, n, [&](T* dst) {
+				size_type i = 0;
+
+				try {
+					for (; i < n; ++i)
+						alloc_traits::construct(r.alloc, dst + i, copy);
+				}
+				catch (...)
+				{
+					DestroyN(r.alloc, dst, i);
+					throw;
+				}
+			});
+		}
+
+		template<std::input_iterator It>
+		iterator insert(iterator p, It first, It last)
+		{
+			const size_type index = p - begin();
+
+			if constexpr (std::forward_iterator<It>)
+			{
+				// known size: the gap is opened once, the range is
+				// built straight into it
+				const size_type n = static_cast<size_type>(std::distance(first, last));
+				if (n == 0) return p;
+
+				return insert_n(index, n, [&](T* dst) {
+					size_type i = 0;
+
+					try {
+						for (It it = first; i < n; ++i, ++it)
+							alloc_traits::construct(r.alloc, dst + i, *it);
+					}
+					catch (...)
+					{
+						DestroyN(r.alloc, dst, i);
+						throw;
+					}
+				});
+			}
+			else
+			{
+				// single pass: append, then rotate the new tail into place
+				const size_type old_size = size();
+
+				try {
+					for (; first != last; ++first)
+						emplace_back(*first);
+				}
+				catch (...)
+				{
+					DestroyN(r.alloc, r.elem + old_size, size() - old_size);
+					r.sz = old_size;
+					throw;
+				}
+
+				std::rotate(begin() + index, begin() + old_size, end());
+				return begin() + index;
+			}
 		}
 
 		iterator erase(iterator p)
 		{
-			// TODO: Use alloc traits
 			if (p == end())
 				return p;
 
-			// move elements to one position to the left
-			std::move(p + 1, end(), p);
-			// destroy surplus last element
-			std::destroy_at(end() - 1);
+			if constexpr (relocate_by_memcpy<A>)
+			{
+				// the hole is closed by sliding the tail bytes
+				alloc_traits::destroy(r.alloc, p);
+				std::memmove(static_cast<void*>(p), static_cast<const void*>(p + 1), (end() - p - 1) * sizeof(T));
+			}
+			else
+			{
+				// move elements to one position to the left
+				std::move(p + 1, end(), p);
+				// destroy surplus last element
+				alloc_traits::destroy(r.alloc, end() - 1);
+			}
+
 			--r.sz;
 			return p;
 		}
@@ -352,6 +640,7 @@ namespace mstl {
 		std::swap(a.data().sz, b.data().sz);
 		std::swap(a.data().elem, b.data().elem);
 		std::swap(a.data().space, b.data().space);
+		std::swap(a.data().mapped, b.data().mapped);
 	}
 
 	template<typename T, typename A>
@@ -360,6 +649,7 @@ namespace mstl {
 		std::swap(a.sz, b.sz);
 		std::swap(a.elem, b.elem);
 		std::swap(a.space, b.space);
+		std::swap(a.mapped, b.mapped);
 	}
 
 	template<typename T, typename A>
@@ -6,6 +6,7 @@ namespace mstl {
 	void bst_test();
 	void avl_test();
 	void rb_test();
+	void set_test();
 }
 
 #endif // !MSTL_BST_TEST_H
\ No newline at end of file
@@ -1,6 +1,11 @@
 //#include "test/list_test.h"
 #include <iostream>
 #include "test/tree_test.h"
+#include "bench/alloc_bench.h"
+#include "bench/map_bench.h"
+#include "bench/vector_bench.h"
+#include "bench/deque_bench.h"
+#include "bench/list_bench.h"
 #include "mmap.h"
 
 
@@ -10,6 +15,21 @@ int main() {
 	//mstl::bst_test();
 	//mstl::avl_test();
 	mstl::rb_test();
+	//mstl::set_test();
+
+	//mstl::pool_allocator_bench();
+	//mstl::unordered_map_bench();
+	//mstl::btree_map_bench();
+	//mstl::flat_map_bench();
+	//mstl::tree_hint_bench();
+	//mstl::rb_node_layout_bench();
+	//mstl::tree_clear_bench();
+	//mstl::tree_copy_bench();
+	//mstl::persistent_map_bench();
+	//mstl::vector_growth_bench();
+	//mstl::small_vector_bench();
+	//mstl::deque_queue_bench();
+	//mstl::unrolled_list_bench();
 
 	std::cout << "\n=============================\n";
 	std::cout << "     TEST MAP \n";
@@ -0,0 +1,94 @@
+#include "bench/alloc_bench.h"
+#include "bench/bench_utils.h"
+#include "mpool_allocator.h"
+#include "mmap.h"
+#include "mlist.h"
+#include "internals/avl_tree.h"
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+
+	std::vector<int> shuffled_keys(std::size_t n)
+	{
+		std::vector<int> keys(n);
+		std::iota(keys.begin(), keys.end(), 0);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937{ 42 });
+		return keys;
+	}
+
+	template<typename Map>
+	void map_insert_clear(const char* label, const std::vector<int>& keys)
+	{
+		Map m;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (int k : keys) m.insert({ k, k });
+			m.clear();
+		});
+
+		mstl::bench::print_row(label, keys.size(), keys.size(), ms);
+	}
+
+	template<typename Tree>
+	void tree_insert_erase(const char* label, const std::vector<int>& keys)
+	{
+		Tree t;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (int k : keys) t.insert(k);
+			for (int k : keys) t.erase(k);
+		});
+
+		mstl::bench::print_row(label, keys.size(), 2 * keys.size(), ms);
+	}
+
+	template<typename List>
+	void list_push_pop(const char* label, std::size_t n)
+	{
+		List l;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i) l.push_back(static_cast<int>(i));
+			while (!l.empty()) l.pop_front();
+		});
+
+		mstl::bench::print_row(label, n, 2 * n, ms);
+	}
+}
+
+void mstl::pool_allocator_bench()
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH NODE POOL ALLOCATOR\n";
+	std::cout << "=============================\n";
+
+	using pair_type = std::pair<const int, int>;
+
+	using std_map  = mstl::map<int, int, std::less<int>, std::allocator<pair_type>>;
+	using pool_map = mstl::map<int, int, std::less<int>, mstl::node_pool_allocator<pair_type>>;
+
+	using std_avl  = mstl::avl_tree<int, mstl::avl_node, mstl::identity_key<int>, std::less<int>, std::allocator<int>>;
+	using pool_avl = mstl::avl_tree<int, mstl::avl_node, mstl::identity_key<int>, std::less<int>, mstl::node_pool_allocator<int>>;
+
+	using std_list  = mstl::list<int, std::allocator<int>>;
+	using pool_list = mstl::list<int, mstl::node_pool_allocator<int>>;
+
+	for (std::size_t n : { 10'000u, 100'000u, 1'000'000u })
+	{
+		const std::vector<int> keys = shuffled_keys(n);
+
+		map_insert_clear<std_map>("map insert+clear   std::allocator", keys);
+		map_insert_clear<pool_map>("map insert+clear   node_pool", keys);
+
+		tree_insert_erase<std_avl>("avl insert+erase   std::allocator", keys);
+		tree_insert_erase<pool_avl>("avl insert+erase   node_pool", keys);
+
+		list_push_pop<std_list>("list push+pop      std::allocator", n);
+		list_push_pop<pool_list>("list push+pop      node_pool", n);
+
+		std::cout << "\n";
+	}
+}
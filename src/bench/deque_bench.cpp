@@ -0,0 +1,95 @@
+#include "bench/deque_bench.h"
+#include "bench/bench_utils.h"
+#include "mdeque.h"
+#include "mlist.h"
+#include <deque>
+#include <cstdint>
+
+namespace {
+
+	// push_back all, then pop_front all. One untimed round first: the
+	// timed one then gets memory already faulted in, whatever ran before
+	template<typename Queue>
+	void fill_drain(const char* label, std::size_t n)
+	{
+		Queue q;
+		std::uint64_t sum = 0;
+
+		for (std::size_t i = 0; i < n; ++i) q.push_back(static_cast<int>(i));
+		while (!q.empty()) q.pop_front();
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i) q.push_back(static_cast<int>(i));
+			while (!q.empty()) { sum += static_cast<std::uint64_t>(q.front()); q.pop_front(); }
+		});
+
+		mstl::bench::do_not_optimize(sum);
+		mstl::bench::print_row(label, n, 2 * n, ms);
+	}
+
+	// producer/consumer at the same rate over a backlog of 1024
+	template<typename Queue>
+	void steady_fifo(const char* label, std::size_t n)
+	{
+		Queue q;
+		std::uint64_t sum = 0;
+
+		for (int i = 0; i < 1024; ++i) q.push_back(i);
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				q.push_back(static_cast<int>(i));
+				sum += static_cast<std::uint64_t>(q.front());
+				q.pop_front();
+			}
+		});
+
+		mstl::bench::do_not_optimize(sum);
+		mstl::bench::print_row(label, n, 2 * n, ms);
+	}
+
+	// same FIFO the other way round: push_front, pop_back
+	template<typename Queue>
+	void reverse_fifo(const char* label, std::size_t n)
+	{
+		Queue q;
+		std::uint64_t sum = 0;
+
+		for (int i = 0; i < 1024; ++i) q.push_front(i);
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				q.push_front(static_cast<int>(i));
+				sum += static_cast<std::uint64_t>(q.back());
+				q.pop_back();
+			}
+		});
+
+		mstl::bench::do_not_optimize(sum);
+		mstl::bench::print_row(label, n, 2 * n, ms);
+	}
+}
+
+void mstl::deque_queue_bench(std::size_t n)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH DEQUE QUEUE\n";
+	std::cout << "=============================\n";
+
+	std::cout << "-- fill + drain --\n";
+	fill_drain<mstl::list<int>>("mstl::list<int>", n);
+	fill_drain<mstl::deque<int>>("mstl::deque<int>", n);
+	fill_drain<std::deque<int>>("std::deque<int>", n);
+
+	std::cout << "-- steady FIFO (backlog 1024) --\n";
+	steady_fifo<mstl::list<int>>("mstl::list<int>", n);
+	steady_fifo<mstl::deque<int>>("mstl::deque<int>", n);
+	steady_fifo<std::deque<int>>("std::deque<int>", n);
+
+	std::cout << "-- push_front / pop_back --\n";
+	reverse_fifo<mstl::list<int>>("mstl::list<int>", n);
+	reverse_fifo<mstl::deque<int>>("mstl::deque<int>", n);
+	reverse_fifo<std::deque<int>>("std::deque<int>", n);
+}
@@ -0,0 +1,86 @@
+#include "bench/list_bench.h"
+#include "bench/bench_utils.h"
+#include "munrolled_list.h"
+#include "mlist.h"
+#include "mvector.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+	template<typename Seq>
+	void traverse(const char* label, const Seq& s, std::size_t passes)
+	{
+		std::uint64_t sum = 0;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t p = 0; p < passes; ++p)
+				for (int v : s) sum += static_cast<std::uint64_t>(v);
+		});
+
+		mstl::bench::do_not_optimize(sum);
+		mstl::bench::print_row(label, s.size(), passes * s.size(), ms);
+	}
+
+	// inserts at an iterator that walks forward from the middle,
+	// stepping over two elements after every insert
+	template<typename Seq>
+	void mid_insert(const char* label, std::size_t base, std::size_t inserts)
+	{
+		Seq s;
+		for (std::size_t i = 0; i < base; ++i) s.push_back(static_cast<int>(i));
+
+		double ms = mstl::bench::time_ms([&] {
+			auto it = s.begin();
+			std::advance(it, base / 2);
+
+			for (std::size_t i = 0; i < inserts; ++i)
+			{
+				it = s.insert(it, static_cast<int>(i));
+				++it;
+				++it;
+			}
+		});
+
+		mstl::bench::do_not_optimize(s);
+		mstl::bench::print_row(label, base, inserts, ms);
+	}
+}
+
+void mstl::unrolled_list_bench(std::size_t n)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH UNROLLED LIST\n";
+	std::cout << "=============================\n";
+
+	std::vector<int> values(n);
+	std::mt19937 rng{ 42 };
+	for (int& v : values) v = static_cast<int>(rng() % 1'000'000);
+
+	// sorting relinks the nodes: list order no longer follows memory
+	mstl::list<int> lst;
+	for (int v : values) lst.push_back(v);
+	lst.sort();
+
+	std::sort(values.begin(), values.end());
+
+	mstl::unrolled_list<int> ulst;
+	mstl::vector<int> vec;
+	for (int v : values)
+	{
+		ulst.push_back(v);
+		vec.push_back(v);
+	}
+
+	std::cout << "-- traversal x10 --\n";
+	traverse("mstl::list<int> (sorted)", lst, 10);
+	traverse("mstl::unrolled_list<int>", ulst, 10);
+	traverse("mstl::vector<int>", vec, 10);
+
+	std::cout << "-- mid-sequence insert --\n";
+	mid_insert<mstl::list<int>>("mstl::list<int>", n / 10, 10'000);
+	mid_insert<mstl::unrolled_list<int>>("mstl::unrolled_list<int>", n / 10, 10'000);
+	mid_insert<mstl::vector<int>>("mstl::vector<int>", n / 10, 10'000);
+}
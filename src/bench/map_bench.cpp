@@ -0,0 +1,503 @@
+#include "bench/map_bench.h"
+#include "bench/bench_utils.h"
+#include "munordered_map.h"
+#include "mbtree_map.h"
+#include "mflat_map.h"
+#include "mmap.h"
+#include "marena_map.h"
+#include "mpersistent_map.h"
+#include "mpool_allocator.h"
+#include "internals/avl_tree.h"
+#include "internals/binary_search_tree.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+	// distinct pseudo random keys: odd multiplier is a bijection on 64 bits
+	std::vector<std::uint64_t> random_keys(std::size_t n, std::uint64_t salt)
+	{
+		std::vector<std::uint64_t> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+			keys[i] = (static_cast<std::uint64_t>(i) * 2 + salt) * 0x9E3779B97F4A7C15ULL;
+		return keys;
+	}
+
+	template<typename Map>
+	void run(const char* name, const std::vector<std::uint64_t>& keys, const std::vector<std::uint64_t>& misses)
+	{
+		Map m;
+		std::size_t found = 0;
+
+		auto row = [&](const char* op, double ms) {
+			const std::string label = std::string{ name } + op;
+			mstl::bench::print_row(label.c_str(), keys.size(), keys.size(), ms);
+		};
+
+		double ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) m.insert({ k, k });
+		});
+		row(" insert", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) found += m.find(k) != m.end();
+		});
+		row(" find hit", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : misses) found += m.find(k) != m.end();
+		});
+		row(" find miss", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) m.erase(k);
+		});
+		row(" erase", ms);
+
+		mstl::bench::do_not_optimize(found);
+	}
+
+	// build from an unsorted batch, look every key up, walk it all
+	template<typename Map>
+	void run_read_mostly(const char* name, const std::vector<std::pair<std::uint64_t, std::uint64_t>>& items)
+	{
+		std::size_t found = 0;
+		std::uint64_t sum = 0;
+
+		auto row = [&](const char* op, double ms) {
+			const std::string label = std::string{ name } + op;
+			mstl::bench::print_row(label.c_str(), items.size(), items.size(), ms);
+		};
+
+		Map m;
+
+		double ms = mstl::bench::time_ms([&] {
+			if constexpr (requires { m.insert_range(items.begin(), items.end()); })
+				m.insert_range(items.begin(), items.end());
+			else
+				for (const auto& kv : items) m.insert(kv);
+		});
+		row(" build", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (const auto& kv : items) found += m.find(kv.first) != m.end();
+		});
+		row(" find hit", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto it = m.begin(); it != m.end(); ++it) sum += (*it).second;
+		});
+		row(" iterate", ms);
+
+		mstl::bench::do_not_optimize(found);
+		mstl::bench::do_not_optimize(sum);
+	}
+
+	// sorted ingestion: every key goes right after the previous one
+	template<typename Tree>
+	void run_ingest(const char* name, const std::vector<std::uint64_t>& keys)
+	{
+		auto value = [](std::uint64_t k) {
+			if constexpr (requires { typename Tree::mapped_type; })
+				return typename Tree::value_type{ k, k };
+			else
+				return k;
+		};
+
+		auto row = [&](const char* op, double ms) {
+			const std::string label = std::string{ name } + op;
+			mstl::bench::print_row(label.c_str(), keys.size(), keys.size(), ms);
+		};
+
+		{
+			Tree t;
+			double ms = mstl::bench::time_ms([&] {
+				for (auto k : keys) t.insert(value(k));
+			});
+			row(" insert", ms);
+			mstl::bench::do_not_optimize(t);
+		}
+
+		{
+			Tree t;
+			double ms = mstl::bench::time_ms([&] {
+				for (auto k : keys) t.insert(t.end(), value(k));
+			});
+			row(" insert(end())", ms);
+			mstl::bench::do_not_optimize(t);
+		}
+	}
+
+	// random order build, then hit / miss lookups in random order
+	template<typename Map>
+	void run_lookup(const char* name, const std::vector<std::uint32_t>& keys, const std::vector<std::uint32_t>& misses)
+	{
+		std::size_t found = 0;
+
+		auto row = [&](const char* op, double ms) {
+			const std::string label = std::string{ name } + op;
+			mstl::bench::print_row(label.c_str(), keys.size(), keys.size(), ms);
+		};
+
+		Map m;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) m.insert({ k, k });
+		});
+		row(" insert", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) found += m.find(k) != m.end();
+		});
+		row(" find hit", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : misses) found += m.find(k) != m.end();
+		});
+		row(" find miss", ms);
+
+		mstl::bench::do_not_optimize(found);
+	}
+
+	// fill untimed, time clear() only
+	template<typename Tree, typename Fill>
+	void run_clear(const char* name, std::size_t n, Fill fill)
+	{
+		Tree t;
+		fill(t);
+
+		const double ms = mstl::bench::time_ms([&] { t.clear(); });
+		const std::string label = std::string{ name } + " clear";
+		mstl::bench::print_row(label.c_str(), n, n, ms);
+		mstl::bench::do_not_optimize(t);
+	}
+
+	// bytes live through every counting_allocator (single thread)
+	struct alloc_counter {
+		static inline std::size_t live_bytes = 0;
+	};
+
+	template<typename T>
+	struct counting_allocator {
+
+		using value_type = T;
+
+		counting_allocator() = default;
+
+		template<typename U>
+		counting_allocator(const counting_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n)
+		{
+			alloc_counter::live_bytes += n * sizeof(T);
+			return std::allocator<T>{}.allocate(n);
+		}
+
+		void deallocate(T* p, std::size_t n) noexcept
+		{
+			alloc_counter::live_bytes -= n * sizeof(T);
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		friend bool operator==(const counting_allocator&, const counting_allocator&) noexcept { return true; }
+	};
+
+	// build, in place updates, then the same updates with a snapshot
+	// taken every updates.size() / snapshots and kept alive
+	template<typename Map>
+	void run_snapshots(const char* name, const std::vector<std::uint64_t>& keys,
+		const std::vector<std::uint64_t>& updates, std::size_t snapshots)
+	{
+		auto row = [&](const char* op, double ms) {
+			const std::string label = std::string{ name } + op;
+			mstl::bench::print_row(label.c_str(), keys.size(), keys.size(), ms);
+		};
+
+		const std::size_t start_bytes = alloc_counter::live_bytes;
+
+		Map m;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (auto k : keys) m.insert({ k, k });
+		});
+		row(" insert", ms);
+
+		ms = mstl::bench::time_ms([&] {
+			for (auto k : updates) m.insert_or_assign(k, k + 1);
+		});
+		row(" update", ms);
+
+		const std::size_t map_bytes = alloc_counter::live_bytes - start_bytes;
+		const std::size_t every = updates.size() / snapshots;
+
+		std::vector<Map> views;
+		views.reserve(snapshots);
+
+		ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < updates.size(); ++i)
+			{
+				if (i % every == 0)
+				{
+					if constexpr (requires { m.snapshot(); })
+						views.push_back(m.snapshot());
+					else
+						views.push_back(m);
+				}
+
+				m.insert_or_assign(updates[i], i);
+			}
+		});
+		row(" update + snapshots", ms);
+
+		const std::size_t all_bytes = alloc_counter::live_bytes - start_bytes;
+
+		std::cout << "    bytes/entry: map " << map_bytes / keys.size()
+			<< ", map + " << views.size() << " snapshots " << all_bytes / keys.size() << "\n";
+	}
+
+	// fill untimed, time the copy constructor only
+	template<typename Tree>
+	void run_copy(const char* name, const std::vector<std::uint64_t>& keys)
+	{
+		Tree t;
+		for (auto k : keys)
+		{
+			if constexpr (requires { typename Tree::mapped_type; })
+				t.insert({ k, k });
+			else
+				t.insert(k);
+		}
+
+		std::size_t size = 0;
+		const double ms = mstl::bench::time_ms([&] {
+			Tree copy(t);
+			size = copy.size();
+		});
+
+		const std::string label = std::string{ name } + " copy";
+		mstl::bench::print_row(label.c_str(), keys.size(), keys.size(), ms);
+		mstl::bench::do_not_optimize(size);
+	}
+}
+
+void mstl::unordered_map_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH UNORDERED MAP\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::vector<key> misses = random_keys(n, 2);
+
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		run<mstl::unordered_map<key, key>>("mstl::unordered_map", keys, misses);
+		run<std::unordered_map<key, key>>("std::unordered_map", keys, misses);
+
+		// ordered map gets slow fast, keep it to reasonable sizes
+		if (n <= 1'000'000)
+			run<mstl::map<key, key>>("mstl::map", keys, misses);
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::btree_map_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH BTREE MAP\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::vector<key> misses = random_keys(n, 2);
+
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		run<mstl::btree_map<key, key>>("mstl::btree_map", keys, misses);
+		run<mstl::map<key, key>>("mstl::map", keys, misses);
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::flat_map_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH FLAT MAP\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		std::vector<std::pair<key, key>> items;
+		items.reserve(n);
+		for (key k : keys) items.emplace_back(k, k);
+
+		run_read_mostly<mstl::flat_map<key, key>>("mstl::flat_map", items);
+		run_read_mostly<mstl::map<key, key>>("mstl::map", items);
+
+		std::cout << "  bytes/entry: flat_map " << 2 * sizeof(key)
+			<< ", map >= " << sizeof(mstl::rb_node<std::pair<const key, key>>) << "\n\n";
+	}
+}
+
+void mstl::tree_hint_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH HINTED INSERT\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		// strictly increasing, with gaps like timestamps
+		std::vector<key> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+			keys[i] = 1'700'000'000'000ULL + i * 16 + (i * 7) % 13;
+
+		run_ingest<mstl::map<key, key>>("mstl::map", keys);
+		run_ingest<mstl::avl_tree<key>>("mstl::avl_tree", keys);
+		run_ingest<std::map<key, key>>("std::map", keys);
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::rb_node_layout_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH RB NODE LAYOUT\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint32_t;
+	using value = std::pair<const key, key>;
+
+	// node pool: blocks of the exact size class (48 vs 32 bytes) and
+	// fresh slabs per map; malloc would round both nodes up to the
+	// same 48 byte chunk, and the second map would reuse the chunks
+	// freed by the first one in a scattered order
+	using alloc = mstl::node_pool_allocator<value>;
+
+	std::cout << "sizeof rb_node<pair<u32, u32>>:         " << sizeof(mstl::rb_node<value>) << " bytes\n";
+	std::cout << "sizeof rb_compact_node<pair<u32, u32>>: " << sizeof(mstl::rb_compact_node<value>) << " bytes\n";
+	std::cout << "sizeof arena_node<pair<u32, u32>>:      " << sizeof(mstl::arena_node<value>) << " bytes\n\n";
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		// odd multiplier: a bijection on 32 bits, even / odd never meet
+		std::vector<key> keys(n), misses(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			keys[i] = static_cast<key>(i * 2) * 0x9E3779B1u;
+			misses[i] = static_cast<key>(i * 2 + 1) * 0x9E3779B1u;
+		}
+
+		run_lookup<mstl::map<key, key, std::less<key>, alloc, mstl::rb_node>>("rb_node", keys, misses);
+		run_lookup<mstl::map<key, key, std::less<key>, alloc, mstl::rb_compact_node>>("rb_compact_node", keys, misses);
+		run_lookup<mstl::arena_map<key, key>>("arena_map", keys, misses);
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::tree_clear_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH TREE CLEAR\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+	using pool = mstl::node_pool_allocator<std::pair<const key, key>>;
+	using string_pool = mstl::node_pool_allocator<std::pair<const key, std::string>>;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		auto fill = [&](auto& t) { for (auto k : keys) t.insert({ k, k }); };
+
+		run_clear<mstl::map<key, key>>("map", n, fill);
+		run_clear<mstl::map<key, key, std::less<key>, pool>>("map pool", n, fill);
+
+		// strings past the SSO buffer: a real destructor per node
+		run_clear<mstl::map<key, std::string, std::less<key>, string_pool>>("map<string> pool", n, [&](auto& t) {
+			for (auto k : keys) t.insert({ k, std::string(32, 'x') });
+		});
+
+		// a list leaning right: n levels deep
+		run_clear<mstl::bst_tree<key>>("degenerate bst", n, [&](auto& t) {
+			for (std::size_t i = 0; i < n; ++i) t.insert(t.end(), static_cast<key>(i));
+		});
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::tree_copy_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH TREE COPY\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+
+	// the timed copy includes the destruction of the copy
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		run_copy<mstl::map<key, key>>("mstl::map", keys);
+		run_copy<mstl::avl_tree<key>>("mstl::avl_tree", keys);
+		run_copy<mstl::bst_tree<key>>("mstl::bst_tree", keys);
+		run_copy<std::map<key, key>>("std::map", keys);
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::persistent_map_bench(std::size_t max_keys)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH PERSISTENT MAP\n";
+	std::cout << "=============================\n";
+
+	using key = std::uint64_t;
+	using alloc = counting_allocator<std::pair<const key, key>>;
+
+	constexpr std::size_t snapshots = 10;
+
+	for (std::size_t n = 1'000; n <= max_keys; n *= 10)
+	{
+		std::vector<key> keys = random_keys(n, 1);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937_64{ 42 });
+
+		// every key updated once, in another random order
+		std::vector<key> updates = keys;
+		std::shuffle(updates.begin(), updates.end(), std::mt19937_64{ 7 });
+
+		run_snapshots<mstl::persistent_map<key, key, std::less<key>, alloc>>("persistent_map", keys, updates, snapshots);
+		run_snapshots<mstl::map<key, key, std::less<key>, alloc>>("mstl::map (copies)", keys, updates, snapshots);
+
+		std::cout << "\n";
+	}
+}
@@ -0,0 +1,171 @@
+#include "bench/vector_bench.h"
+#include "bench/bench_utils.h"
+#include "mvector.h"
+#include "msmall_vector.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace {
+
+	// 16 bytes with a user-provided copy: not trivially copyable,
+	// so by default every reallocation relocates it one by one
+	struct payload {
+		std::uint64_t m_A{};
+		std::uint64_t m_B{};
+
+		payload() = default;
+		explicit payload(std::uint64_t x) noexcept : m_A{ x }, m_B{ ~x } {}
+		payload(const payload& o) noexcept : m_A{ o.m_A }, m_B{ o.m_B } {}
+		payload& operator=(const payload&) = default;
+	};
+
+	// same layout, opted in to memcpy relocation
+	struct relocatable_payload : payload {
+		using payload::payload;
+	};
+}
+
+template<>
+struct mstl::is_trivially_relocatable<relocatable_payload> : std::true_type {};
+
+namespace {
+
+	template<typename Vec, typename T>
+	void push_growth(const char* label, std::size_t n)
+	{
+		if constexpr (requires { typename Vec::trace; }) Vec::trace::reset();
+
+		Vec v;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i)
+				v.push_back(T(static_cast<std::uint64_t>(i)));
+		});
+
+		mstl::bench::do_not_optimize(v);
+		mstl::bench::print_row(label, n, n, ms);
+
+		if constexpr (requires { typename Vec::trace; }) mstl::bench::print_trace<typename Vec::trace>();
+	}
+
+	// heap-backed strings (past the small buffer): push_back(T&&)
+	// steals the buffer, append_range reserves once
+	template<typename Vec>
+	void string_growth(const char* label, std::size_t n)
+	{
+		const std::string proto(48, 'x');
+		std::vector<std::string> batch(n, proto);
+
+		if constexpr (requires { typename Vec::trace; }) Vec::trace::reset();
+
+		Vec v;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t i = 0; i < n; ++i)
+				v.push_back(std::string(proto));
+		});
+
+		mstl::bench::do_not_optimize(v);
+		mstl::bench::print_row(label, n, n, ms);
+
+		if constexpr (requires { typename Vec::trace; }) mstl::bench::print_trace<typename Vec::trace>();
+
+		if constexpr (requires(Vec & w) { w.append_range(batch); })
+		{
+			Vec w;
+			ms = mstl::bench::time_ms([&] { w.append_range(batch); });
+
+			mstl::bench::do_not_optimize(w);
+			mstl::bench::print_row("  append_range", n, n, ms);
+		}
+	}
+}
+
+namespace {
+
+	// std::allocator that counts its allocations
+	std::size_t g_Allocations = 0;
+
+	template<typename T>
+	struct counting_allocator : std::allocator<T> {
+
+		using value_type = T;
+
+		template<typename U>
+		struct rebind { using other = counting_allocator<U>; };
+
+		counting_allocator() = default;
+
+		template<typename U>
+		counting_allocator(const counting_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n) {
+			++g_Allocations;
+			return std::allocator<T>::allocate(n);
+		}
+	};
+
+	template<typename Vec>
+	void short_lived(const char* label, std::size_t rounds, std::size_t elems)
+	{
+		g_Allocations = 0;
+		std::uint64_t sum = 0;
+
+		double ms = mstl::bench::time_ms([&] {
+			for (std::size_t r = 0; r < rounds; ++r)
+			{
+				Vec v;
+				for (std::size_t i = 0; i < elems; ++i)
+					v.push_back(static_cast<int>(i + r));
+
+				sum += static_cast<std::uint64_t>(v[elems - 1]);
+			}
+		});
+
+		mstl::bench::do_not_optimize(sum);
+		mstl::bench::print_row(label, elems, rounds * elems, ms);
+		std::cout << "    heap allocations per vector: "
+			<< static_cast<double>(g_Allocations) / static_cast<double>(rounds) << "\n";
+	}
+}
+
+void mstl::vector_growth_bench(std::size_t max_elems)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH VECTOR GROWTH\n";
+	std::cout << "=============================\n";
+
+	for (std::size_t n = 1'000'000; n <= max_elems; n *= 10)
+	{
+		push_growth<std::vector<int>, int>("std::vector<int>", n);
+		push_growth<mstl::vector<int>, int>("mstl::vector<int>", n);
+
+		push_growth<mstl::vector<payload>, payload>("mstl::vector<payload>", n);
+		push_growth<mstl::vector<relocatable_payload>, relocatable_payload>("mstl::vector<relocatable>", n);
+
+		if (n <= 10'000'000)
+		{
+			string_growth<std::vector<std::string>>("std::vector<string>", n);
+			string_growth<mstl::vector<std::string>>("mstl::vector<string>", n);
+		}
+
+		std::cout << "\n";
+	}
+}
+
+void mstl::small_vector_bench(std::size_t rounds)
+{
+	std::cout << "\n=============================\n";
+	std::cout << "     BENCH SMALL VECTOR\n";
+	std::cout << "=============================\n";
+
+	for (std::size_t elems : { 4, 8, 16, 32, 64 })
+	{
+		short_lived<std::vector<int, counting_allocator<int>>>("std::vector<int>", rounds, elems);
+		short_lived<mstl::vector<int, counting_allocator<int>>>("mstl::vector<int>", rounds, elems);
+		short_lived<mstl::small_vector<int, 16, counting_allocator<int>>>("mstl::small_vector<int, 16>", rounds, elems);
+
+		std::cout << "\n";
+	}
+}
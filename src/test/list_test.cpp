@@ -1,5 +1,7 @@
 #include "test/list_test.h"
 #include "mlist.h"
+#include "munrolled_list.h"
+#include "mpool_allocator.h"
 #include <iostream>
 
 void mstl::list_test()
@@ -53,5 +55,48 @@ void mstl::list_test()
 
 	std::cout << "front = " << lst.front() << ", back = " << lst.back() << "\n";
 
+	// Relinking operations
+	mstl::list<int> other;
+	for (int v : { 9, 4, 7, 4, 1 })
+		other.push_back(v);
+
+	lst.splice(lst.end(), other);
+	mstl::print_list(lst, "after splice(end, {9,4,7,4,1})");
+	mstl::visualize(lst);
+
+	lst.sort();
+	mstl::print_list(lst, "after sort()");
+	mstl::visualize(lst);
+
+	lst.unique();
+	mstl::print_list(lst, "after unique()");
+	mstl::visualize(lst);
+
+	lst.remove_if([](int v) { return v % 2 == 0; });
+	mstl::print_list(lst, "after remove_if(even)");
+	mstl::visualize(lst);
+
+	other.push_back(3);
+	other.push_back(8);
+	lst.merge(other);
+	mstl::print_list(lst, "after merge({3,8})");
+	mstl::visualize(lst);
+
+	lst.reverse();
+	mstl::print_list(lst, "after reverse()");
+	mstl::visualize(lst);
+
+	// move assignment hands the nodes over with the pool that owns them
+	mstl::unrolled_list<int, 8, mstl::node_pool_allocator<int>> pooled;
+	{
+		mstl::unrolled_list<int, 8, mstl::node_pool_allocator<int>> src;
+		for (int v = 0; v < 20; ++v)
+			src.push_back(v);
+		pooled = std::move(src);
+	}
+	pooled.push_back(20);
+	std::cout << "pooled unrolled_list after move assignment: size " << pooled.size()
+		<< ", back " << pooled.back() << "\n\n";
+
 	std::cout << "All tests complete.\n";
 }
@@ -2,6 +2,11 @@
 #include "internals/binary_search_tree.h"
 #include "internals/avl_tree.h"
 #include "internals/red_black_tree.h"
+#include "mset.h"
+#include "mmap.h"
+#include "marena_map.h"
+#include <string>
+#include <string_view>
 #include <vector>
 
 void mstl::bst_test()
@@ -102,3 +107,76 @@ void mstl::rb_test()
 
     std::cout << (t.IsRBTree() ? "\nSuccess!!!" : "\nWrong!!") << std::endl;
 }
+
+void mstl::set_test()
+{
+    std::cout << "\n=============================\n";
+    std::cout << "     TEST SET / MULTISET\n";
+    std::cout << "=============================\n";
+
+    auto print = [](const char* what, const auto& c) {
+        std::cout << what << ": ";
+        for (const auto& v : c) std::cout << v << " ";
+        std::cout << "(" << c.size() << ")" << (c.verify() ? "" : " [invalid tree]") << "\n";
+    };
+
+    // sorted input: bottom-up build, no descent per element
+    std::vector<int> sorted = { 1, 3, 5, 7, 9, 11 };
+    set<int> s(sorted.begin(), sorted.end());
+    print("\nsorted range", s);
+
+    // sorted range into a non-empty set: built apart and united
+    std::vector<int> more = { 2, 3, 4, 12 };
+    s.insert(more.begin(), more.end());
+    print("insert(sorted range)", s);
+
+    // hinted insert at the end: O(1)
+    for (int v = 13; v < 16; ++v) s.insert(s.end(), v);
+    print("insert(end(), 13..15)", s);
+
+    // extract / reinsert: no allocation, the key can change
+    auto nh = s.extract(7);
+    nh.value() = 70;
+    s.insert(std::move(nh));
+    print("extract(7) -> 70", s);
+
+    // merge: relinks, duplicates stay in the source
+    set<int> other = { 1, 2, 100, 200 };
+    s.merge(other);
+    print("merge", s);
+    print("left in other", other);
+
+    multiset<int> m = { 5, 1, 5, 3, 5 };
+    m.insert(m.find(3), 3);
+    print("\nmultiset", m);
+    std::cout << "count(5): " << m.count(5) << ", erase(5): " << m.erase(5) << "\n";
+    print("after erase(5)", m);
+
+    // transparent comparator: string_view / const char* lookups, no
+    // std::string built per query
+    set<std::string, std::less<>> names = { "ada", "alan", "grace", "linus" };
+    std::string_view key = "grace";
+    std::cout << "\ncontains(string_view \"grace\"): " << names.contains(key)
+              << ", count(\"bob\"): " << names.count("bob") << "\n";
+    names.erase(std::string_view("alan"));
+    print("erase(string_view \"alan\")", names);
+
+    map<std::string, int, std::less<>> ages = { { "ada", 36 }, { "grace", 85 } };
+    ages.at(key) += 1;
+    std::cout << "map at(string_view): " << ages.at(key)
+              << ", lower_bound(\"b\"): " << (*ages.lower_bound("b")).first << "\n";
+
+    // the value comes from the tree itself while the arena is full:
+    // it must be built before the old slots are freed
+    arena_map<int, std::string> arena;
+    arena.emplace(1, "slot value long enough to live on the heap");
+    arena.shrink_to_fit();
+    arena.insert_or_assign(1000, (*arena.begin()).second);
+    arena.shrink_to_fit();
+    arena.try_emplace(1001, (*arena.begin()).second);
+    arena.shrink_to_fit();
+    arena.emplace(*arena.find(1000));
+    std::cout << "\narena_map grow from own value: "
+              << ((*arena.find(1000)).second == (*arena.find(1001)).second ? "ok" : "wrong")
+              << " (" << arena.size() << ")" << (arena.verify() ? "" : " [invalid tree]") << "\n";
+}